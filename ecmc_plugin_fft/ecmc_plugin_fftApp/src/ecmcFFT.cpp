@@ -19,6 +19,9 @@
 #define ECMC_PLUGIN_ASYN_RAWDATA     "rawdata"
 #define ECMC_PLUGIN_ASYN_PPDATA      "preprocdata"
 #define ECMC_PLUGIN_ASYN_FFT_AMP     "fftamplitude"
+#define ECMC_PLUGIN_ASYN_FFT_PHASE   "fftphase"
+#define ECMC_PLUGIN_ASYN_FFT_REAL    "fftreal"
+#define ECMC_PLUGIN_ASYN_FFT_IMAG    "fftimag"
 #define ECMC_PLUGIN_ASYN_FFT_MODE    "mode"
 #define ECMC_PLUGIN_ASYN_FFT_STAT    "status"
 #define ECMC_PLUGIN_ASYN_FFT_SOURCE  "source"
@@ -27,14 +30,56 @@
 #define ECMC_PLUGIN_ASYN_NFFT        "nfft"
 #define ECMC_PLUGIN_ASYN_RATE        "samplerate"
 #define ECMC_PLUGIN_ASYN_BUFF_ID     "buffid"
+#define ECMC_PLUGIN_ASYN_WINDOW      "window"
+#define ECMC_PLUGIN_ASYN_FFT_AVG     "fftamplitudeavg"
+#define ECMC_PLUGIN_ASYN_AVG_MODE    "avgmode"
+#define ECMC_PLUGIN_ASYN_UNIT        "unit"
+#define ECMC_PLUGIN_ASYN_DB_REF      "dbref"
+#define ECMC_PLUGIN_ASYN_ENBW        "enbw"
+#define ECMC_PLUGIN_ASYN_ZOOM_CENTER "zoomcenter"
+#define ECMC_PLUGIN_ASYN_ZOOM_SPAN   "zoomspan"
+#define ECMC_PLUGIN_ASYN_AVG_COUNT   "avgcount"
+#define ECMC_PLUGIN_ASYN_AVG_ALPHA   "avgalpha"
+#define ECMC_PLUGIN_ASYN_AVG_RESET   "avgreset"
+#define ECMC_PLUGIN_ASYN_AVG_COUNTER "avgcounter"
+#define ECMC_PLUGIN_ASYN_WORKER_POLICY "workerpolicy"
+#define ECMC_PLUGIN_ASYN_WORKER_PRIO "workerprio"
+#define ECMC_PLUGIN_ASYN_WORKER_CPUS "workercpus"
+#define ECMC_PLUGIN_ASYN_RT_TIME_LAST "rttimelast"
+#define ECMC_PLUGIN_ASYN_RT_TIME_MIN "rttimemin"
+#define ECMC_PLUGIN_ASYN_RT_TIME_MAX "rttimemax"
+#define ECMC_PLUGIN_ASYN_RT_TIME_HIST "rttimehist"
+#define ECMC_PLUGIN_ASYN_SAMPLES_INGESTED "samplesingested"
+#define ECMC_PLUGIN_ASYN_SAMPLES_DROPPED "samplesdropped"
+#define ECMC_PLUGIN_ASYN_SAMPLES_IGNORED "samplesignored"
+#define ECMC_PLUGIN_ASYN_RT_STAT_RESET "rtstatreset"
+#define ECMC_PLUGIN_ASYN_WORKER_TIME "workertime"
+#define ECMC_PLUGIN_ASYN_WORKER_TIME_MAX "workertimemax"
+#define ECMC_PLUGIN_ASYN_SPECTRA_RATE "spectrarate"
+#define ECMC_PLUGIN_ASYN_LATENCY     "latency"
+#define ECMC_PLUGIN_ASYN_LATENCY_MAX "latencymax"
+#define ECMC_PLUGIN_ASYN_WORKER_STAT_RESET "workerstatreset"
+#define ECMC_PLUGIN_ASYN_CROSS_AMP   "crossamplitude"
+#define ECMC_PLUGIN_ASYN_TF_AMP      "tfamplitude"
+#define ECMC_PLUGIN_ASYN_TF_PHASE    "tfphase"
+#define ECMC_PLUGIN_ASYN_COHERENCE   "coherence"
+#define ECMC_PLUGIN_ASYN_PUBLISH_ARRAYS "publisharrays"
+#define ECMC_PLUGIN_ASYN_BAND        "band"
 
 
 #include <sstream>
+#include <sched.h>
+#include <math.h>
+#include <time.h>
 #include "ecmcFFT.h"
+#include "ecmcFFTEngine.h"
+#include "ecmcFFTWorkerPool.h"
 #include "ecmcPluginClient.h"
 #include "ecmcAsynPortDriver.h"
 #include "ecmcAsynPortDriverUtils.h"
 #include "epicsThread.h"
+#include "epicsAtomic.h"
+#include "epicsString.h"
 
 // Breaktable
 #include "ellLib.h"
@@ -51,6 +96,45 @@ extern DBBASE *pdbbase;
 // New data callback from ecmc
 static int printMissingObjError = 1;
 
+// Monotonic time [ns] (vdso, cheap enough for realtime thread)
+static inline int64_t getMonotonicNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Enum strings for window (index = FFT_WINDOW)
+static const char* windowStrings[ECMC_PLUGIN_WINDOW_COUNT] = {
+  ECMC_PLUGIN_WINDOW_NONE_OPTION,
+  ECMC_PLUGIN_WINDOW_HANN_OPTION,
+  ECMC_PLUGIN_WINDOW_HAMMING_OPTION,
+  ECMC_PLUGIN_WINDOW_BH_OPTION,
+  ECMC_PLUGIN_WINDOW_FLATTOP_OPTION
+};
+
+// Enum strings for averaging mode (index = FFT_AVG_MODE)
+static const char* avgModeStrings[ECMC_PLUGIN_AVG_MODE_COUNT] = {
+  ECMC_PLUGIN_AVG_MODE_NONE_OPTION,
+  ECMC_PLUGIN_AVG_MODE_LIN_OPTION,
+  ECMC_PLUGIN_AVG_MODE_EXP_OPTION,
+  ECMC_PLUGIN_AVG_MODE_MAX_OPTION
+};
+
+// Enum strings for unit of amplitude (index = FFT_UNIT)
+static const char* unitStrings[ECMC_PLUGIN_UNIT_COUNT] = {
+  ECMC_PLUGIN_UNIT_AMP_OPTION,
+  ECMC_PLUGIN_UNIT_POWER_OPTION,
+  ECMC_PLUGIN_UNIT_PSD_OPTION,
+  ECMC_PLUGIN_UNIT_DB_OPTION
+};
+
+// Parameter names of band outputs (plugin.fft<index>.band<band>.<name>)
+static const char* bandOutputStrings[ECMC_PLUGIN_BAND_OUTPUT_COUNT] = {
+  "rms",
+  "peak",
+  "peakfreq"
+};
+
 /** This callback will not be used (sample data inteface is used instead to get an stable sample freq)
   since the callback is called when data is updated it might */
 void f_dataUpdatedCallback(uint8_t* data, size_t size, ecmcEcDataType dt, void* obj) {
@@ -62,10 +146,10 @@ void f_dataUpdatedCallback(uint8_t* data, size_t size, ecmcEcDataType dt, void*
       return;
     }
   }
-  ecmcFFT * fftObj = (ecmcFFT*)obj;
+  ecmcFFTChannel * channel = (ecmcFFTChannel*)obj;
 
-  // Call the correct fft object with new data
-  fftObj->dataUpdatedCallback(data,size,dt);
+  // Call the correct fft object with new data of channel
+  channel->fft->dataUpdatedCallback(channel,data,size,dt);
 }
 
 void f_worker(void *obj) {
@@ -88,7 +172,7 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
                  char* configStr,
                  char* portName) 
                   : asynPortDriver(portName,
-                   1, /* maxAddr */
+                   getChannelCount(configStr), /* maxAddr (one per source) */
                    asynInt32Mask | asynFloat64Mask | asynFloat32ArrayMask |
                    asynFloat64ArrayMask | asynEnumMask | asynDrvUserMask |
                    asynOctetMask | asynInt8ArrayMask | asynInt16ArrayMask |
@@ -97,27 +181,30 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
                    asynFloat64ArrayMask | asynEnumMask | asynDrvUserMask |
                    asynOctetMask | asynInt8ArrayMask | asynInt16ArrayMask |
                    asynInt32ArrayMask | asynUInt32DigitalMask, /* Interrupt mask */
-                   ASYN_CANBLOCK , /*NOT ASYN_MULTI_DEVICE*/
+                   ASYN_CANBLOCK | (getChannelCount(configStr) > 1 ? ASYN_MULTIDEVICE : 0), /* MULTI_DEVICE if SOURCES */
                    1, /* Autoconnect */
                    0, /* Default priority */
                    0) /* Default stack size */
                    {
   cfgDataSourceStr_ = NULL;
+  cfgDataSourcesStr_= NULL;
   cfgBreakTableStr_ = NULL;
-  rawDataBuffer_    = NULL;
-  dataItem_         = NULL;
-  dataItemInfo_     = NULL;
-  fftDouble_        = NULL;
-  status_           = NO_STAT;
-  elementsInBuffer_ = 0;
-  fftWaitingForCalc_= 0;
+  engine_           = NULL;
+  handOverMask_     = 0;
+  allChannelsMask_  = 0;
+  workerPool_       = NULL;
+  workerJobQueued_  = 0;
+  workerThreadId_   = NULL;
+  workerPolicy_     = SCHED_OTHER;
+  workerPrio_       = 0;
+  memset(workerCpus_, 0, sizeof(workerCpus_));
+  rtStatsReset_     = 0;
+  resetRtStats();
+  workerStatsReset_ = 0;
+  resetWorkerStats();
   destructs_        = 0;
-  callbackHandle_   = -1;
+  workerCreated_    = 0;
   objectId_         = fftIndex;
-  scale_            = 1.0;
-  triggOnce_        = 0;
-  cycleCounter_     = 0;
-  ignoreCycles_     = 0;
   dataSourceLinked_ = 0;
   breakTable_       = NULL;
   lastBreakPoint_   = 0;
@@ -127,6 +214,9 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
   asynRawDataId_    = -1;    // Raw data (input) array (double)
   asynPPDataId_     = -1;    // Pre-processed data array (double)
   asynFFTAmpId_     = -1;    // FFT amplitude array (double)
+  asynFFTPhaseId_   = -1;    // FFT phase array
+  asynFFTRealId_    = -1;    // FFT real part array
+  asynFFTImagId_    = -1;    // FFT imaginary part array
   asynFFTModeId_    = -1;    // FFT mode (cont/trigg)
   asynFFTStatId_    = -1;    // FFT status (no_stat/idle/acq/calc)
   asynSourceId_     = -1;    // SOURCE
@@ -135,6 +225,45 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
   asynNfftId_       = -1;    // Nfft
   asynSRateId_      = -1;    // Sample rate Hz
   asynElementsInBuffer_= -1;
+  asynWindowId_        = -1;
+  asynFFTAvgId_        = -1;
+  asynAvgModeId_       = -1;
+  asynUnitId_          = -1;
+  asynDbRefId_         = -1;
+  asynEnbwId_          = -1;
+  asynZoomCenterId_    = -1;
+  asynZoomSpanId_      = -1;
+  asynPublishArraysId_ = -1;
+  for(size_t b = 0; b < ECMC_PLUGIN_MAX_BANDS; ++b) {
+    for(int j = 0; j < ECMC_PLUGIN_BAND_OUTPUT_COUNT; ++j) {
+      asynBandIds_[b][j] = -1;
+    }
+  }
+  asynAvgCountId_      = -1;
+  asynAvgAlphaId_      = -1;
+  asynAvgResetId_      = -1;
+  asynAvgCounterId_    = -1;
+  asynWorkerPolicyId_  = -1;
+  asynWorkerPrioId_    = -1;
+  asynWorkerCpusId_    = -1;
+  asynRtTimeLastId_    = -1;
+  asynRtTimeMinId_     = -1;
+  asynRtTimeMaxId_     = -1;
+  asynRtTimeHistId_    = -1;
+  asynSamplesIngestedId_ = -1;
+  asynSamplesDroppedId_  = -1;
+  asynSamplesIgnoredId_  = -1;
+  asynRtStatResetId_   = -1;
+  asynWorkerTimeId_    = -1;
+  asynWorkerTimeMaxId_ = -1;
+  asynSpectraRateId_   = -1;
+  asynLatencyId_       = -1;
+  asynLatencyMaxId_    = -1;
+  asynWorkerStatResetId_ = -1;
+  asynCrossAmpId_      = -1;
+  asynTfAmpId_         = -1;
+  asynTfPhaseId_       = -1;
+  asynCoherenceId_     = -1;
 
   ecmcSampleRateHz_    = getEcmcSampleRate();
   cfgFFTSampleRateHz_  = ecmcSampleRateHz_;
@@ -149,11 +278,52 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
   cfgEnable_        = 0;   // start disabled (enable over asyn)
   cfgMode_          = TRIGG;
   cfgScale_         =  1.0;
+  cfgOverlap_       = ECMC_PLUGIN_DEFAULT_OVERLAP;
+  cfgWindow_        = WINDOW_NONE;
+  cfgWindowCorr_    = WINDOW_CORR_AMP;
+  cfgAvgMode_       = AVG_NONE;
+  cfgAvgCount_      = ECMC_PLUGIN_DEFAULT_AVG_COUNT;
+  cfgAvgAlpha_      = ECMC_PLUGIN_DEFAULT_AVG_ALPHA;
+  cfgUnit_          = UNIT_AMP;
+  cfgDbRef_         = ECMC_PLUGIN_DEFAULT_DB_REF;
+  cfgPrecision_     = PRECISION_DOUBLE;
+  cfgCross_         = 0;
+  cfgZoomCenter_    = 0;
+  cfgZoomSpan_      = 0;   // No zoom
+  cfgBandsStr_      = NULL;
+  cfgPublishArrays_ = 1;
+  cfgPoolThreads_   = 0;   // Own worker thread
+  cfgPoolPrio_      = 0;
+  cfgPoolCpusStr_   = NULL;
+  cfgWorkerPolicy_  = -1;  // Derived from priority
+  cfgWorkerPrio_    = 0;
+  cfgWorkerCpusStr_ = NULL;
 
   parseConfigStr(configStr); // Assigns all configs
-  // Check valid nfft
-  if(cfgNfft_ <= 0) {
-    throw std::out_of_range("NFFT must be > 0 and even N^2.");
+  parseSources();            // One channel per source
+  std::vector<double> bandLow;
+  std::vector<double> bandHigh;
+  if(cfgBandsStr_) {
+    parseBands(&bandLow, &bandHigh);
+  }
+  publishArrays_    = cfgPublishArrays_;
+
+  // Check worker thread config (priority > 0 defaults to SCHED_FIFO)
+  if(cfgWorkerPolicy_ < 0) {
+    cfgWorkerPolicy_ = cfgWorkerPrio_ > 0 ? SCHED_FIFO : SCHED_OTHER;
+  }
+  if(cfgWorkerPolicy_ == SCHED_OTHER && cfgWorkerPrio_ != 0) {
+    throw std::out_of_range("WORKER_PRIO must be 0 for WORKER_POLICY=OTHER.");
+  }
+  if(cfgWorkerPolicy_ != SCHED_OTHER && (cfgWorkerPrio_ < 1 || cfgWorkerPrio_ > 99)) {
+    throw std::out_of_range("WORKER_PRIO must be 1..99 for WORKER_POLICY=FIFO/RR.");
+  }
+  if(cfgWorkerCpusStr_) {
+    std::vector<int> cpuList;
+    ecmcFFTWorkerPool::parseCpuList(cfgWorkerCpusStr_, &cpuList);  // Throws if invalid
+  }
+  if(cfgPoolThreads_ > 0 && (cfgWorkerPrio_ > 0 || cfgWorkerCpusStr_)) {
+    printf("Warning: WORKER_PRIO/WORKER_CPUS not used with WORKER_POOL (use POOL_PRIO/POOL_CPUS).\n");
   }
 
   // Check valid sample rate
@@ -165,68 +335,134 @@ ecmcFFT::ecmcFFT(int   fftIndex,       // index of this object (if several is cr
     cfgFFTSampleRateHz_ = ecmcSampleRateHz_;
   }
 
+  // Cross spectra of channels to first channel (reference)
+  if(cfgCross_ && channels_.size() < 2) {
+    throw std::invalid_argument("CROSS needs at least two data sources (SOURCES).");
+  }
+
   // Check if breaktable
   if(cfgBreakTableStr_) {
     verifyBreakTable(); 
   }
 
-  // Se if any data update cycles should be ignored
-  // example ecmc 1000Hz, fft 100Hz then ignore 9 cycles (could be strange if not multiples)
-  ignoreCycles_ = ecmcSampleRateHz_ / cfgFFTSampleRateHz_ -1;
+  // Fixed point works on the raw integer samples (breaktable is non linear)
+  if(cfgPrecision_ == PRECISION_FIXED && cfgBreakTableStr_) {
+    throw std::invalid_argument("BREAKTABLE not supported with PRECISION=FIXED.");
+  }
+
+  // Zoom mixes and decimates the scaled samples
+  if(cfgPrecision_ == PRECISION_FIXED && cfgZoomSpan_ > 0) {
+    throw std::invalid_argument("ZOOM_SPAN not supported with PRECISION=FIXED.");
+  }
 
-  // set scale factor
-  scale_ = 1.0 / ((double)cfgNfft_); // sqrt((double)cfgNfft_);
+  // Acquisition and DSP pipeline per channel (validates NFFT, OVERLAP, AVG_COUNT, AVG_ALPHA)
+  // Buffers and transform in double, float or fixed point (fixed for the life of the object)
+  try {
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      ecmcFFTChannel* channel = &channels_[i];
+      if(cfgPrecision_ == PRECISION_FIXED) {
+        channel->resultsFloat  = createEngine<float, int32_t>(channel);
+      } else if(cfgPrecision_ == PRECISION_FLOAT) {
+        channel->resultsFloat  = createEngine<float, float>(channel);
+      } else {
+        channel->resultsDouble = createEngine<double, double>(channel);
+      }
+      ecmcFFTEngine* engine = channel->engine;
+      engine->setEnable(cfgEnable_);
+      engine->setMode(cfgMode_);
+      engine->setScale(cfgScale_);
+      engine->setDcRemove(cfgDcRemove_);
+      engine->setLinRemove(cfgLinRemove_);
+      engine->setWindow(cfgWindow_);
+      engine->setWindowCorr(cfgWindowCorr_);
+      engine->setAvgMode(cfgAvgMode_);
+      engine->setAvgCount(cfgAvgCount_);
+      engine->setAvgAlpha(cfgAvgAlpha_);
+      engine->setUnit(cfgUnit_);
+      engine->setDbRef(cfgDbRef_);
+      engine->setSampleRate(cfgDataSampleRateHz_);  // Updated at connect (oversampling)
+      if(cfgZoomSpan_ > 0) {
+        engine->setZoom(cfgZoomCenter_, cfgZoomSpan_);  // Validates band and MODE
+      }
+      if(!bandLow.empty()) {
+        engine->setBands(&bandLow[0], &bandHigh[0], bandLow.size());
+      }
 
-  // Allocate buffers
-  rawDataBuffer_      = new double[cfgNfft_];               // Raw input data (real)
-  prepProcDataBuffer_ = new double[cfgNfft_];               // Data for preprocessing
-  fftBufferInput_     = new std::complex<double>[cfgNfft_]; // FFT input  (complex)
-  fftBufferResult_    = new std::complex<double>[cfgNfft_]; // FFT result (complex)
-  fftBufferResultAmp_ = new double[cfgNfft_ / 2 + 1];       // FFT result amplitude (real)
-  fftBufferXAxis_     = new double[cfgNfft_ / 2 + 1];       // FFT x axis with freqs
-  clearBuffers();
+      // Se if any data update cycles should be ignored
+      // example ecmc 1000Hz, fft 100Hz then ignore 9 cycles (could be strange if not multiples)
+      engine->setIgnoreCycles(ecmcSampleRateHz_ / cfgFFTSampleRateHz_ -1);
 
-  // Allocate KissFFT
-  fftDouble_ = new kissfft<double>(cfgNfft_,false);
-  
-  // Create worker thread
-  std::string threadname = "ecmc." ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_);
-  if(epicsThreadCreate(threadname.c_str(), 0, 32768, f_worker, this) == NULL) {
-    throw std::runtime_error("Error: Failed create worker thread.");
+      if(cfgCross_ && i > 0) {
+        if(channel->resultsFloat) {
+          channel->crossFloat  = new ecmcFFTCross<float>(engine->getBins());
+        } else {
+          channel->crossDouble = new ecmcFFTCross<double>(engine->getBins());
+        }
+      }
+    }
   }
-  
+  catch(std::exception& e) {
+    deleteEngines();
+    throw;
+  }
+  engine_ = channels_[0].engine;
+
   initAsyn();
+
+  // Create worker thread (if not using shared worker pool, see setWorkerPool())
+  // Policy, priority and affinity are applied by the thread itself (doCalcWorker())
+  if(cfgPoolThreads_ <= 0) {
+    std::string threadname = "ecmc." ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_);
+    if(epicsThreadCreate(threadname.c_str(), 0, ECMC_PLUGIN_WORKER_STACK_SIZE, f_worker, this) == NULL) {
+      throw std::runtime_error("Error: Failed create worker thread.");
+    }
+    workerCreated_ = 1;
+  }
 }
 
 ecmcFFT::~ecmcFFT() {
   // kill worker
-  destructs_ = 1;  // maybe need todo in other way..
+  epicsAtomicSetIntT(&destructs_, 1);  // maybe need todo in other way..
   doCalcEvent_.signal();
 
-  if(rawDataBuffer_) {
-    delete[] rawDataBuffer_;
+  // Wait for worker to finish current calc and exit (uses the buffers below)
+  if(workerCreated_) {
+    workerExitEvent_.wait();
   }
 
-  if(prepProcDataBuffer_) {
-    delete[] prepProcDataBuffer_;
+  // De register callbacks before the engines are deleted
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].callbackHandle >= 0) {
+      channels_[i].dataItem->deregDataUpdatedCallback(channels_[i].callbackHandle);
+      channels_[i].callbackHandle = -1;
+    }
   }
-  
-  // De register callback when unload
-  if(callbackHandle_ >= 0) {
-    dataItem_->deregDataUpdatedCallback(callbackHandle_);
+  // A pool thread (or asyn) could still be in calc
+  calcLock_.lock();
+  deleteEngines();
+  calcLock_.unlock();
+
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    free(channels_[i].sourceStr);
   }
   if(cfgDataSourceStr_) {
     free(cfgDataSourceStr_);
   }
+  if(cfgDataSourcesStr_) {
+    free(cfgDataSourcesStr_);
+  }
   if(cfgBreakTableStr_) {
     free(cfgBreakTableStr_);
-  }  
-  if(fftDouble_) {
-    delete fftDouble_;
   }
-  if (fftBufferInput_){
-    delete[] fftBufferInput_;
-  }  
+  if(cfgPoolCpusStr_) {
+    free(cfgPoolCpusStr_);
+  }
+  if(cfgWorkerCpusStr_) {
+    free(cfgWorkerCpusStr_);
+  }
+  if(cfgBandsStr_) {
+    free(cfgBandsStr_);
+  }
 }
 
 void ecmcFFT::parseConfigStr(char *configStr) {
@@ -256,6 +492,12 @@ void ecmcFFT::parseConfigStr(char *configStr) {
         cfgDataSourceStr_=strdup(pThisOption);
       }
 
+      // ECMC_PLUGIN_SOURCES_OPTION_CMD (Source strings separated by ',')
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_SOURCES_OPTION_CMD, strlen(ECMC_PLUGIN_SOURCES_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_SOURCES_OPTION_CMD);
+        cfgDataSourcesStr_=strdup(pThisOption);
+      }
+
       // ECMC_PLUGIN_BREAKTABLE_OPTION_CMD (EPICS breaktable name)
       else if (!strncmp(pThisOption, ECMC_PLUGIN_BREAKTABLE_OPTION_CMD, strlen(ECMC_PLUGIN_BREAKTABLE_OPTION_CMD))) {
         pThisOption += strlen(ECMC_PLUGIN_BREAKTABLE_OPTION_CMD);
@@ -315,251 +557,604 @@ void ecmcFFT::parseConfigStr(char *configStr) {
         cfgScale_ = atof(pThisOption);
       }
 
+      // ECMC_PLUGIN_OVERLAP_OPTION_CMD overlap in % of NFFT (trailing '%' allowed)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_OVERLAP_OPTION_CMD, strlen(ECMC_PLUGIN_OVERLAP_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_OVERLAP_OPTION_CMD);
+        cfgOverlap_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_WINDOW_OPTION_CMD NONE/HANN/HAMMING/BLACKMANHARRIS/FLATTOP
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WINDOW_OPTION_CMD, strlen(ECMC_PLUGIN_WINDOW_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WINDOW_OPTION_CMD);
+        for(int i = 0; i < ECMC_PLUGIN_WINDOW_COUNT; ++i) {
+          if(!strcmp(pThisOption, windowStrings[i])) {
+            cfgWindow_ = (FFT_WINDOW)i;
+          }
+        }
+      }
+
+      // ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD AMP/ENERGY
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD, strlen(ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_WINDOW_CORR_AMP_OPTION,strlen(ECMC_PLUGIN_WINDOW_CORR_AMP_OPTION))){
+          cfgWindowCorr_ = WINDOW_CORR_AMP;
+        }
+        if(!strncmp(pThisOption, ECMC_PLUGIN_WINDOW_CORR_ENERGY_OPTION,strlen(ECMC_PLUGIN_WINDOW_CORR_ENERGY_OPTION))){
+          cfgWindowCorr_ = WINDOW_CORR_ENERGY;
+        }
+      }
+
+      // ECMC_PLUGIN_AVG_MODE_OPTION_CMD NONE/LIN/EXP/MAX
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_AVG_MODE_OPTION_CMD, strlen(ECMC_PLUGIN_AVG_MODE_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_AVG_MODE_OPTION_CMD);
+        for(int i = 0; i < ECMC_PLUGIN_AVG_MODE_COUNT; ++i) {
+          if(!strcmp(pThisOption, avgModeStrings[i])) {
+            cfgAvgMode_ = (FFT_AVG_MODE)i;
+          }
+        }
+      }
+
+      // ECMC_PLUGIN_AVG_COUNT_OPTION_CMD spectra in linear average
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_AVG_COUNT_OPTION_CMD, strlen(ECMC_PLUGIN_AVG_COUNT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_AVG_COUNT_OPTION_CMD);
+        cfgAvgCount_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD alpha of exponential average
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD, strlen(ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD);
+        cfgAvgAlpha_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_UNIT_OPTION_CMD AMP/POWER/PSD/DB
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_UNIT_OPTION_CMD, strlen(ECMC_PLUGIN_UNIT_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_UNIT_OPTION_CMD);
+        for(int i = 0; i < ECMC_PLUGIN_UNIT_COUNT; ++i) {
+          if(!strcmp(pThisOption, unitStrings[i])) {
+            cfgUnit_ = (FFT_UNIT)i;
+          }
+        }
+      }
+
+      // ECMC_PLUGIN_DB_REF_OPTION_CMD reference amplitude of dB unit
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_DB_REF_OPTION_CMD, strlen(ECMC_PLUGIN_DB_REF_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_DB_REF_OPTION_CMD);
+        cfgDbRef_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PRECISION_OPTION_CMD DOUBLE/FLOAT/FIXED
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PRECISION_OPTION_CMD, strlen(ECMC_PLUGIN_PRECISION_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PRECISION_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_PRECISION_DOUBLE_OPTION,strlen(ECMC_PLUGIN_PRECISION_DOUBLE_OPTION))){
+          cfgPrecision_ = PRECISION_DOUBLE;
+        }
+        if(!strncmp(pThisOption, ECMC_PLUGIN_PRECISION_FLOAT_OPTION,strlen(ECMC_PLUGIN_PRECISION_FLOAT_OPTION))){
+          cfgPrecision_ = PRECISION_FLOAT;
+        }
+        if(!strncmp(pThisOption, ECMC_PLUGIN_PRECISION_FIXED_OPTION,strlen(ECMC_PLUGIN_PRECISION_FIXED_OPTION))){
+          cfgPrecision_ = PRECISION_FIXED;
+        }
+      }
+
+      // ECMC_PLUGIN_CROSS_OPTION_CMD cross spectra to first source
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_CROSS_OPTION_CMD, strlen(ECMC_PLUGIN_CROSS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_CROSS_OPTION_CMD);
+        cfgCross_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD centre of zoom band
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD, strlen(ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD);
+        cfgZoomCenter_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD width of zoom band (0 = no zoom)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD, strlen(ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD);
+        cfgZoomSpan_ = atof(pThisOption);
+      }
+
+      // ECMC_PLUGIN_BANDS_OPTION_CMD band limits (low-high,low-high,..)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_BANDS_OPTION_CMD, strlen(ECMC_PLUGIN_BANDS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_BANDS_OPTION_CMD);
+        cfgBandsStr_ = strdup(pThisOption);
+      }
+
+      // ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD array callbacks (1/0)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD, strlen(ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD);
+        cfgPublishArrays_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_WORKER_POOL_OPTION_CMD threads in shared worker pool (0 = own thread)
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WORKER_POOL_OPTION_CMD, strlen(ECMC_PLUGIN_WORKER_POOL_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WORKER_POOL_OPTION_CMD);
+        cfgPoolThreads_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_POOL_PRIO_OPTION_CMD priority of worker pool threads
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_POOL_PRIO_OPTION_CMD, strlen(ECMC_PLUGIN_POOL_PRIO_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_POOL_PRIO_OPTION_CMD);
+        cfgPoolPrio_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_POOL_CPUS_OPTION_CMD cpu affinity of worker pool threads
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_POOL_CPUS_OPTION_CMD, strlen(ECMC_PLUGIN_POOL_CPUS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_POOL_CPUS_OPTION_CMD);
+        cfgPoolCpusStr_ = strdup(pThisOption);
+      }
+
+      // ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD priority of worker thread
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD, strlen(ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD);
+        cfgWorkerPrio_ = atoi(pThisOption);
+      }
+
+      // ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD cpu affinity of worker thread
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD, strlen(ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD);
+        cfgWorkerCpusStr_ = strdup(pThisOption);
+      }
+
+      // ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD OTHER/FIFO/RR
+      else if (!strncmp(pThisOption, ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD, strlen(ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD))) {
+        pThisOption += strlen(ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD);
+        if(!strncmp(pThisOption, ECMC_PLUGIN_WORKER_POLICY_OTHER_OPTION,strlen(ECMC_PLUGIN_WORKER_POLICY_OTHER_OPTION))){
+          cfgWorkerPolicy_ = SCHED_OTHER;
+        }
+        if(!strncmp(pThisOption, ECMC_PLUGIN_WORKER_POLICY_FIFO_OPTION,strlen(ECMC_PLUGIN_WORKER_POLICY_FIFO_OPTION))){
+          cfgWorkerPolicy_ = SCHED_FIFO;
+        }
+        if(!strncmp(pThisOption, ECMC_PLUGIN_WORKER_POLICY_RR_OPTION,strlen(ECMC_PLUGIN_WORKER_POLICY_RR_OPTION))){
+          cfgWorkerPolicy_ = SCHED_RR;
+        }
+      }
+
       pThisOption = pNextOption;
     }    
     free(pOptions);
   }
 
   // Data source must be defined...
-  if(!cfgDataSourceStr_) { 
+  if(!cfgDataSourceStr_ && !cfgDataSourcesStr_) { 
     throw std::invalid_argument( "Data source not defined.");
   }
+  if(cfgDataSourceStr_ && cfgDataSourcesStr_) { 
+    throw std::invalid_argument( "SOURCE and SOURCES can not be combined.");
+  }
 }
 
-void ecmcFFT::connectToDataSource() {
-  /* Check if already linked (one call to enterRT per loaded FFT lib (FFT object))
-      But link should only happen once!!*/
-  if( dataSourceLinked_ ) {
-    return;
-  }
-  
-  // Get dataItem
-  dataItem_        = (ecmcDataItem*) getEcmcDataItem(cfgDataSourceStr_);
-  if(!dataItem_) {
-    throw std::runtime_error( "Data item NULL." );
+/** One channel per data source (SOURCE or each item in SOURCES). The
+ *  channel index is the asyn address of the per channel parameters.
+ *  Throws invalid_argument and out_of_range.
+*/
+void ecmcFFT::parseSources() {
+  std::vector<std::string> sources;
+  if(cfgDataSourcesStr_) {
+    std::string source;
+    for(const char* p = cfgDataSourcesStr_; ; ++p) {
+      if(*p == ECMC_PLUGIN_SOURCES_SEPARATOR || *p == '\0') {
+        if(source.empty()) {
+          throw std::invalid_argument("Empty data source in SOURCES.");
+        }
+        sources.push_back(source);
+        source.clear();
+        if(*p == '\0') {
+          break;
+        }
+      } else {
+        source += *p;
+      }
+    }
+  } else {
+    sources.push_back(cfgDataSourceStr_);
   }
-  
-  dataItemInfo_ = dataItem_->getDataItemInfo();
 
-  // Register data callback
-  callbackHandle_ = dataItem_->regDataUpdatedCallback(f_dataUpdatedCallback, this);
-  if (callbackHandle_ < 0) {
-    throw std::runtime_error( "Failed to register data source callback.");
+  if(sources.size() > ECMC_PLUGIN_MAX_CHANNELS) {
+    throw std::out_of_range("Too many data sources in SOURCES.");
+  }
+  // Must match maxAddr of asyn port (see getChannelCount())
+  if((int)sources.size() != maxAddr) {
+    throw std::invalid_argument("Invalid SOURCES.");
   }
 
-  // Check data source
-  if( !dataTypeSupported(dataItem_->getEcmcDataType()) ) {
-    throw std::invalid_argument( "Data type not supported." );
+  channels_.resize(sources.size());
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    ecmcFFTChannel* channel = &channels_[i];
+    channel->fft            = this;
+    channel->index          = (int)i;
+    channel->sourceStr      = strdup(sources[i].c_str());
+    channel->dataItem       = NULL;
+    channel->dataItemInfo   = NULL;
+    channel->callbackHandle = -1;
+    channel->engine         = NULL;
+    channel->resultsDouble  = NULL;
+    channel->resultsFloat   = NULL;
+    channel->crossDouble    = NULL;
+    channel->crossFloat     = NULL;
+    channel->calcReady      = 0;
+    channel->calcFlags      = 0;
+    channel->crossReady     = 0;
+    memset(channel->outputClients, 0, sizeof(channel->outputClients));
+    allChannelsMask_       |= (uint64_t)1 << i;
   }
+}
 
-  // Add oversampling
-  cfgDataSampleRateHz_ = cfgFFTSampleRateHz_ * dataItem_->getEcmcDataSize()/dataItem_->getEcmcDataElementSize();
-  setDoubleParam(asynSRateId_, cfgDataSampleRateHz_);
-  callParamCallbacks();
+/** Band limits of BANDS ("low-high,low-high,.." [Hz]). Values are checked
+ *  by the engine (setBands()). Throws invalid_argument and out_of_range.
+*/
+void ecmcFFT::parseBands(std::vector<double>* low, std::vector<double>* high) {
+  const char* p = cfgBandsStr_;
+  while(true) {
+    char*  end;
+    double lowHz = strtod(p, &end);
+    if(end == p || *end != ECMC_PLUGIN_BAND_LIMIT_SEPARATOR) {
+      throw std::invalid_argument("Invalid band in BANDS (low-high).");
+    }
+    p = end + 1;
+    double highHz = strtod(p, &end);
+    if(end == p || (*end != ECMC_PLUGIN_BANDS_SEPARATOR && *end != '\0')) {
+      throw std::invalid_argument("Invalid band in BANDS (low-high).");
+    }
+    low->push_back(lowHz);
+    high->push_back(highHz);
+    if(*end == '\0') {
+      break;
+    }
+    p = end + 1;
+  }
+  if(low->size() > ECMC_PLUGIN_MAX_BANDS) {
+    throw std::out_of_range("Too many bands in BANDS.");
+  }
+}
 
-  dataSourceLinked_ = 1;
-  updateStatus(IDLE);
+/** Channels in config string (items in SOURCES, else 1). Needed for the
+ *  asyn port before the config is parsed, validated in parseSources().
+*/
+int ecmcFFT::getChannelCount(const char *configStr) {
+  if(!configStr) {
+    return 1;
+  }
+  const char* sources = strstr(configStr, ECMC_PLUGIN_SOURCES_OPTION_CMD);
+  // Option must start at beginning or after ';'
+  while(sources && sources != configStr && sources[-1] != ';') {
+    sources = strstr(sources + 1, ECMC_PLUGIN_SOURCES_OPTION_CMD);
+  }
+  if(!sources) {
+    return 1;
+  }
+  int count = 1;
+  for(const char* p = sources + strlen(ECMC_PLUGIN_SOURCES_OPTION_CMD); *p && *p != ';'; ++p) {
+    if(*p == ECMC_PLUGIN_SOURCES_SEPARATOR) {
+      count++;
+    }
+  }
+  return count;
 }
 
-void ecmcFFT::dataUpdatedCallback(uint8_t*       data, 
-                                  size_t         size,
-                                  ecmcEcDataType dt) {
-  
-  if(fftWaitingForCalc_) {
-    return;
+/** Engine of channel. All channels share the transform plans of the first
+ *  channel (same NFFT, calculated by the same worker).
+ *  Throws bad_alloc and out_of_range.
+*/
+template<typename T, typename S>
+ecmcFFTEngineT<T, S>* ecmcFFT::createEngine(ecmcFFTChannel* channel) {
+  ecmcFFTPlanCache<S>* planCache = NULL;
+  if(channel->index > 0) {
+    planCache = static_cast<ecmcFFTEngineT<T, S>*>(channels_[0].engine)->getPlanCache();
   }
-  // No buffer or full or not enabled
-  if(!rawDataBuffer_ || !cfgEnable_) {
-    return;
+  ecmcFFTEngineT<T, S>* engine = new ecmcFFTEngineT<T, S>(cfgNfft_, cfgOverlap_, planCache);
+  channel->engine = engine;
+  if(cfgBreakTableStr_) {
+    engine->setRawConvert(applyBreakTable<S>, this);
   }
+  return engine;
+}
 
-  // See if data should be ignored
-  if(cycleCounter_ < ignoreCycles_) {
-    cycleCounter_++;
-    return; // ignore this callback
+// Plans are owned by engine of first channel (deleted last)
+void ecmcFFT::deleteEngines() {
+  for(size_t i = channels_.size(); i > 0; --i) {
+    delete channels_[i - 1].crossDouble;
+    delete channels_[i - 1].crossFloat;
+    channels_[i - 1].crossDouble   = NULL;
+    channels_[i - 1].crossFloat    = NULL;
+    delete channels_[i - 1].engine;
+    channels_[i - 1].engine        = NULL;
+    channels_[i - 1].resultsDouble = NULL;
+    channels_[i - 1].resultsFloat  = NULL;
   }
+  engine_ = NULL;
+}
 
-  cycleCounter_ = 0;
+/** Cross spectra of new size (NFFT or zoom band changed). Cross spectra with
+ *  old size are ignored if allocation fails.
+*/
+void ecmcFFT::setCrossBins(ecmcFFTChannel* channel) {
+  try {
+    if(channel->crossDouble) {
+      channel->crossDouble->setBins(channel->engine->getBins());
+    }
+    if(channel->crossFloat) {
+      channel->crossFloat->setBins(channel->engine->getBins());
+    }
+  }
+  catch(std::bad_alloc& e) {
+    printf("%s/%s:%d: Error: Failed allocate cross spectrum (%s).\n",
+           __FILE__, __FUNCTION__, __LINE__, e.what());
+  }
+}
 
-  if (cfgMode_ == TRIGG && !triggOnce_ ) {
-    updateStatus(IDLE);
-    return; // Wait for trigger from plc or asyn
+void ecmcFFT::resetCrossAvg() {
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].crossDouble) {
+      channels_[i].crossDouble->resetAvg();
+    }
+    if(channels_[i].crossFloat) {
+      channels_[i].crossFloat->resetAvg();
+    }
   }
+}
 
-  if(cfgDbgMode_) {
-    printEcDataArray(data, size, dt, objectId_);
+ecmcFFTChannel* ecmcFFT::getChannel(asynUser *pasynUser) {
+  int addr = 0;
+  if(getAddress(pasynUser, &addr) != asynSuccess ||
+     addr < 0 || addr >= (int)channels_.size()) {
+    return NULL;
+  }
+  return &channels_[addr];
+}
 
-    if(elementsInBuffer_ == cfgNfft_) {
-      printf("Buffer full (%zu elements appended).\n",elementsInBuffer_);
-    }
+void ecmcFFT::connectToDataSource() {
+  /* Check if already linked (one call to enterRT per loaded FFT lib (FFT object))
+      But link should only happen once!!*/
+  if( dataSourceLinked_ ) {
+    return;
   }
   
-  if(elementsInBuffer_ >= cfgNfft_) {
-    //Buffer full
-    if(!fftWaitingForCalc_){            
-      // Perform calcs
-      updateStatus(CALC);
-      fftWaitingForCalc_ = 1;
-      doCalcEvent_.signal(); // let worker start
+  // All channels share NFFT, x-axis and trigger (same sample rate needed)
+  double dataSampleRateHz = 0;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    ecmcFFTChannel* channel = &channels_[i];
+
+    // Get dataItem
+    channel->dataItem = (ecmcDataItem*) getEcmcDataItem(channel->sourceStr);
+    if(!channel->dataItem) {
+      throw std::runtime_error( "Data item NULL." );
     }
-    return;
-  }
+    
+    channel->dataItemInfo = channel->dataItem->getDataItemInfo();
 
-  updateStatus(ACQ);
+    // Check data source
+    if( !dataTypeSupported(channel->dataItem->getEcmcDataType()) ) {
+      throw std::invalid_argument( "Data type not supported." );
+    }
 
-  size_t dataElementSize = getEcDataTypeByteSize(dt);
+    // Fixed point only for integer samples that fit in int32
+    FFT_SAMPLE_TYPE sampleType = getSampleType(channel->dataItem->getEcmcDataType());
+    if( cfgPrecision_ == PRECISION_FIXED &&
+        (sampleType == SAMPLE_U32 || sampleType >= SAMPLE_U64) ) {
+      throw std::invalid_argument( "Data type not supported with PRECISION=FIXED (U8, S8, U16, S16 or S32)." );
+    }
 
-  uint8_t *pData = data;
-  for(unsigned int i = 0; i < size / dataElementSize; ++i) {
-    //printf("dataElementSize=%d, size=%d\n",dataElementSize,size);
-    switch(dt) {
-      case ECMC_EC_U8:        
-        addDataToBuffer((double)getUint8(pData));
-        break;
-      case ECMC_EC_S8:
-        addDataToBuffer((double)getInt8(pData));
-        break;
-      case ECMC_EC_U16:
-        addDataToBuffer((double)getUint16(pData));
-        break;
-      case ECMC_EC_S16:
-        addDataToBuffer((double)getInt16(pData));
-        break;
-      case ECMC_EC_U32:
-        addDataToBuffer((double)getUint32(pData));
-        break;
-      case ECMC_EC_S32:
-        addDataToBuffer((double)getInt32(pData));
-        break;
-      case ECMC_EC_U64:
-        addDataToBuffer((double)getUint64(pData));
-        break;
-      case ECMC_EC_S64:
-        addDataToBuffer((double)getInt64(pData));
-        break;
-      case ECMC_EC_F32:
-        addDataToBuffer((double)getFloat32(pData));
-        break;
-      case ECMC_EC_F64:
-        addDataToBuffer((double)getFloat64(pData));
-        break;
-      default:
-        break;
+    // Add oversampling
+    double rate = cfgFFTSampleRateHz_ * channel->dataItem->getEcmcDataSize() /
+                  channel->dataItem->getEcmcDataElementSize();
+    if(i > 0 && rate != dataSampleRateHz) {
+      throw std::invalid_argument( "All data sources in SOURCES must have the same sample rate (elements per cycle)." );
     }
-    
-    pData += dataElementSize;
+    dataSampleRateHz = rate;
+
+    // Resolve converter once for the data type of the source
+    channel->engine->setSampleType(sampleType);
+
+    // Register data callback
+    channel->callbackHandle = channel->dataItem->regDataUpdatedCallback(f_dataUpdatedCallback, channel);
+    if (channel->callbackHandle < 0) {
+      throw std::runtime_error( "Failed to register data source callback.");
+    }
+  }
+
+  cfgDataSampleRateHz_ = dataSampleRateHz;
+  setDoubleParam(asynSRateId_, cfgDataSampleRateHz_);
+  callParamCallbacks();
+
+  dataSourceLinked_ = 1;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->setSampleRate(cfgDataSampleRateHz_);  // New rate, x-axis needs update
+    channels_[i].engine->setStatus(IDLE);
+    updateStatus(&channels_[i]);
   }
 }
 
-void ecmcFFT::addDataToBuffer(double data) {
-  
-  if(rawDataBuffer_ && (elementsInBuffer_ < cfgNfft_) ) {
-    
-    if( cfgBreakTableStr_ && interruptAccept ) {
-      double breakData = data;
-      // Supply a breaktable (init=0, LINR must be > 1 but only used if init > 0)       
-      if (cvtRawToEngBpt(&breakData, 2, 0, &breakTable_, &lastBreakPoint_)!=0) {        
-        //TODO: What does status here mean.. 
-        //throw std::runtime_error("Breaktable conversion failed.\n");
-      }
-      //printf("Index %d: Before %lf, after %lf\n",objectId_,data,breakData);
-      data = breakData * cfgScale_;
-    } else {
-      data = data * cfgScale_;
+void ecmcFFT::dataUpdatedCallback(ecmcFFTChannel* channel,
+                                  uint8_t*        data, 
+                                  size_t          size,
+                                  ecmcEcDataType  dt) {
+
+  int64_t startNs = getMonotonicNs();
+
+  // Reset requested over asyn (done here since only realtime writes the stats)
+  if(epicsAtomicGetIntT(&rtStatsReset_)) {
+    epicsAtomicSetIntT(&rtStatsReset_, 0);
+    resetRtStats();
+  }
+
+  size_t dataElementSize = getEcDataTypeByteSize(dt);
+  if(dataElementSize > 0) {
+    if(cfgDbgMode_) {
+      printEcDataArray(data, size, dt, objectId_);
     }
 
-    rawDataBuffer_[elementsInBuffer_] = data;
-    prepProcDataBuffer_[elementsInBuffer_] = data;
+    // Never blocks (data is skipped if worker is reallocating buffers)
+    int flags = channel->engine->acquire(data,
+                                         size / dataElementSize,
+                                         getSampleType(dt),
+                                         startNs);
+    if(flags & ECMC_FFT_ACQ_STATUS_UPDATED) {
+      updateStatus(channel);
+    }
+    if(flags & ECMC_FFT_ACQ_HANDED_OVER) {
+      // Batch: let worker start when all channels handed over (sources are
+      // updated one by one in the same cycle), or if a channel hands over
+      // again before the others (source stopped or out of phase)
+      uint64_t channelMask = (uint64_t)1 << channel->index;
+      if(handOverMask_ & channelMask) {
+        handOverMask_ = channelMask;
+        triggerWorker();
+      } else {
+        handOverMask_ |= channelMask;
+        if(handOverMask_ == allChannelsMask_) {
+          handOverMask_ = 0;
+          triggerWorker(); // let worker start
+        }
+      }
+    }
   }
-  elementsInBuffer_ ++;
+
+  int64_t timeNs = getMonotonicNs() - startNs;
+  updateRtStats(timeNs < INT32_MAX ? (epicsInt32)timeNs : INT32_MAX);
 }
 
-void ecmcFFT::clearBuffers() {
-  memset(rawDataBuffer_,   0, cfgNfft_ * sizeof(double));
-  memset(prepProcDataBuffer_, 0, cfgNfft_ * sizeof(double));
-  memset(fftBufferResultAmp_, 0, (cfgNfft_ / 2 + 1) * sizeof(double));
-  memset(fftBufferXAxis_, 0, (cfgNfft_ / 2 + 1) * sizeof(double));  
-  for(unsigned int i = 0; i < cfgNfft_; ++i) {
-    fftBufferResult_[i].real(0);
-    fftBufferResult_[i].imag(0);
-    fftBufferInput_[i].real(0);
-    fftBufferInput_[i].imag(0);
+void ecmcFFT::updateRtStats(epicsInt32 timeNs) {
+  rtTimeLast_ = timeNs;
+  if(rtCallbacks_ == 0 || timeNs < rtTimeMin_) {
+    rtTimeMin_ = timeNs;
+  }
+  if(timeNs > rtTimeMax_) {
+    rtTimeMax_ = timeNs;
+  }
+  rtCallbacks_++;
+
+  // Log2 bins in us
+  epicsInt32 us  = timeNs / 1000;
+  int        bin = 0;
+  while(us > 0 && bin < ECMC_PLUGIN_RT_HIST_BINS - 1) {
+    us >>= 1;
+    bin++;
   }
-  elementsInBuffer_ = 0;
+  rtTimeHist_[bin]++;
 }
 
-void ecmcFFT::calcFFT() {
-  // move pre-processed data to fft input buffer
-  for(unsigned int i = 0; i < cfgNfft_; ++i) {
-    fftBufferInput_[i].real(prepProcDataBuffer_[i]);
-    fftBufferInput_[i].imag(0);
+/** Stage times, latency and spectra rate of worker. stageNs holds start time
+ *  of each stage and end time of last stage (at STAGE_TOTAL). Port locked.
+*/
+void ecmcFFT::updateWorkerStats(int64_t* stageNs, int64_t lastSampleNs) {
+  if(epicsAtomicGetIntT(&workerStatsReset_)) {
+    epicsAtomicSetIntT(&workerStatsReset_, 0);
+    resetWorkerStats();
   }
 
-  // Do fft
-  fftDouble_->transform(fftBufferInput_, fftBufferResult_);
-}
+  int64_t nowNs = stageNs[STAGE_TOTAL];
+  for(int i = 0; i < STAGE_TOTAL; ++i) {
+    workerTime_[i] = (double)(stageNs[i + 1] - stageNs[i]) / 1000.0;
+  }
+  workerTime_[STAGE_TOTAL] = (double)(nowNs - stageNs[STAGE_PREPROCESS]) / 1000.0;
+  for(int i = 0; i < ECMC_PLUGIN_WORKER_STAGE_COUNT; ++i) {
+    if(workerTime_[i] > workerTimeMax_[i]) {
+      workerTimeMax_[i] = workerTime_[i];
+    }
+  }
 
-void ecmcFFT::scaleFFT() {
-  // Always scale
-  //if(!cfgApplyScale_) {
-  //  return;
-  //}
+  latency_ = (double)(nowNs - lastSampleNs) / 1000.0;
+  if(latency_ > latencyMax_) {
+    latencyMax_ = latency_;
+  }
 
-  for(unsigned int i = 0 ; i < cfgNfft_ ; ++i ) {
-    fftBufferResult_[i] = fftBufferResult_[i] * scale_;
+  spectraCounter_++;
+  if(spectraRateStartNs_ == 0) {
+    spectraRateStartNs_ = nowNs;
+    spectraCounter_     = 0;
+  } else if(nowNs - spectraRateStartNs_ >= 1000000000) {
+    spectraRate_        = (double)spectraCounter_ * 1e9 / (double)(nowNs - spectraRateStartNs_);
+    spectraRateStartNs_ = nowNs;
+    spectraCounter_     = 0;
   }
+
+  doCallbacksFloat64Array(workerTime_, ECMC_PLUGIN_WORKER_STAGE_COUNT, asynWorkerTimeId_, 0);
+  doCallbacksFloat64Array(workerTimeMax_, ECMC_PLUGIN_WORKER_STAGE_COUNT, asynWorkerTimeMaxId_, 0);
+  setDoubleParam(asynSpectraRateId_, spectraRate_);
+  setDoubleParam(asynLatencyId_, latency_);
+  setDoubleParam(asynLatencyMaxId_, latencyMax_);
 }
 
-void ecmcFFT::calcFFTAmp() {  
-  for(unsigned int i = 0 ; i < cfgNfft_ / 2 + 1 ; ++i ) {
-    fftBufferResultAmp_[i] = std::abs(fftBufferResult_[i]);
-  }
+void ecmcFFT::resetWorkerStats() {
+  memset(workerTime_, 0, sizeof(workerTime_));
+  memset(workerTimeMax_, 0, sizeof(workerTimeMax_));
+  latency_            = 0;
+  latencyMax_         = 0;
+  spectraRate_        = 0;
+  spectraCounter_     = 0;
+  spectraRateStartNs_ = 0;
 }
 
-// Should be enough todo once
-void ecmcFFT::calcFFTXAxis() {
-  //fill x axis buffer with freqs  
-  double freq = 0;
-  double deltaFreq = cfgDataSampleRateHz_ / ((double)(cfgNfft_));
-  for(unsigned int i = 0; i < (cfgNfft_ / 2 + 1); ++i) {
-    fftBufferXAxis_[i] = freq;
-    freq = freq + deltaFreq;
-  }  
+void ecmcFFT::resetRtStats() {
+  rtTimeLast_      = 0;
+  rtTimeMin_       = 0;
+  rtTimeMax_       = 0;
+  rtCallbacks_     = 0;
+  memset(rtTimeHist_, 0, sizeof(rtTimeHist_));
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].engine) {
+      channels_[i].engine->resetSampleCounters();
+    }
+  }
 }
 
-void ecmcFFT::removeDCOffset() {
-  if(!cfgDcRemove_) {
+/** Raw conversion hook of the engine (realtime thread). Apply breaktable in
+ *  place, scale and stats are applied by the engine afterwards. Shared by all
+ *  channels (lastBreakPoint_ is only a search hint, callbacks are serial).
+*/
+template<typename T>
+void ecmcFFT::applyBreakTable(void* obj, T* data, size_t elements) {
+  ecmcFFT* fftObj = (ecmcFFT*)obj;
+  // Breaktables can only be used after iocInit
+  if(!interruptAccept) {
     return;
   }
-
-  // calc average of preprocess buffer data
-  double sum = 0;
-  for(unsigned int i = 0; i < cfgNfft_; ++i ) {
-    sum += prepProcDataBuffer_[i];
+  for(size_t i = 0; i < elements; ++i) {
+    // Supply a breaktable (init=0, LINR must be > 1 but only used if init > 0)
+    double value = data[i];
+    if (cvtRawToEngBpt(&value, 2, 0, &fftObj->breakTable_, &fftObj->lastBreakPoint_)!=0) {
+      //TODO: What does status here mean..
+      //throw std::runtime_error("Breaktable conversion failed.\n");
+    }
+    data[i] = (T)value;
   }
-  double avg = sum / ((double)cfgNfft_);
-  for(unsigned int i = 0; i < cfgNfft_; ++i ) {    
-    prepProcDataBuffer_[i] = (prepProcDataBuffer_[i]-avg);
+}
+
+/** Change NFFT. Validated here and applied by the worker before next calc.
+ *  Throws out_of_range.
+*/
+void ecmcFFT::setNfft(size_t nfft) {
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->setNfft(nfft);
   }
+  triggerWorker();
 }
 
-void ecmcFFT::removeLin() {
-  if(!cfgLinRemove_) {
+/** Called from worker (calcLock_ taken). Apply new NFFT if requested.
+ *  Asyn reads of the buffers are blocked while the engine reallocates.
+*/
+void ecmcFFT::applyNfftRequest() {
+  if(!engine_->getNfftRequest()) {
     return;
   }
 
-  double k=0;
-  double m=0;
-  // calc least square (best fit of line)
-  if(leastSquare(cfgNfft_,prepProcDataBuffer_,&k,&m)) {
-    printf("%s/%s:%d: Error: " ECMC_PLUGIN_RM_LIN_OPTION_CMD " failed, divison by 0. Data will not be processed with the option/configuration.\n",
-           __FILE__, __FUNCTION__, __LINE__);
-    return;
+  lock();  // Asyn reads of buffers
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->applyNfftRequest();
   }
-  
-  // remove linear component (now we have k and m (y=k*x+m))  
-  for(unsigned int x = 0; x < cfgNfft_; ++x ) {
-    prepProcDataBuffer_[x] = prepProcDataBuffer_[x] - (k*x + m);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setCrossBins(&channels_[i]);
+  }
+  setIntegerParam(asynNfftId_, (epicsInt32)engine_->getNfft());
+  unlock();
+  callParamCallbacks();
+}
+
+// Restart acquisition (handled in realtime thread and then by worker)
+void ecmcFFT::clearBuffers() {
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->clearBuffers();
   }
 }
 
@@ -612,7 +1207,8 @@ void ecmcFFT::printEcDataArray(uint8_t*       data,
   }
 }
 
-void ecmcFFT::printComplexArray(std::complex<double>* fftBuff,
+template<typename T>
+void ecmcFFT::printComplexArray(std::complex<T>* fftBuff,
                                 size_t elements,
                                 int objId) {
   printf("fft id: %d, results: \n",objId);
@@ -621,6 +1217,34 @@ void ecmcFFT::printComplexArray(std::complex<double>* fftBuff,
   }
 }
 
+FFT_SAMPLE_TYPE ecmcFFT::getSampleType(ecmcEcDataType dt) {
+  switch(dt) {
+    case ECMC_EC_U8:
+      return SAMPLE_U8;
+    case ECMC_EC_S8:
+      return SAMPLE_S8;
+    case ECMC_EC_U16:
+      return SAMPLE_U16;
+    case ECMC_EC_S16:
+      return SAMPLE_S16;
+    case ECMC_EC_U32:
+      return SAMPLE_U32;
+    case ECMC_EC_S32:
+      return SAMPLE_S32;
+    case ECMC_EC_U64:
+      return SAMPLE_U64;
+    case ECMC_EC_S64:
+      return SAMPLE_S64;
+    case ECMC_EC_F32:
+      return SAMPLE_F32;
+    case ECMC_EC_F64:
+      return SAMPLE_F64;
+    default:
+      return SAMPLE_NONE;
+  }
+  return SAMPLE_NONE;
+}
+
 int ecmcFFT::dataTypeSupported(ecmcEcDataType dt) {
 
   switch(dt) {
@@ -765,34 +1389,40 @@ size_t ecmcFFT::getEcDataTypeByteSize(ecmcEcDataType dt){
   return 0;
 }
 
+/** Parameters are created for all addresses. Data, status and counters of
+ *  a channel use the channel index as address, config and stats of the
+ *  object use address 0 (applied to all channels).
+*/
 void ecmcFFT::initAsyn() {
 
   // Add enable "plugin.fft%d.enable"
   std::string paramName =ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_ENABLE;
   
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynEnableId_) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynEnableId_) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter enable");
   }
   setIntegerParam(asynEnableId_, cfgEnable_);
 
+  // Result arrays in the precision of the engine
+  asynParamType resultArrayType = cfgPrecision_ == PRECISION_DOUBLE ?
+                                  asynParamFloat64Array : asynParamFloat32Array;
+
   // Add rawdata "plugin.fft%d.rawdata"
   paramName =ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_RAWDATA;
 
-  if( createParam(0, paramName.c_str(), asynParamFloat64Array, &asynRawDataId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), resultArrayType, &asynRawDataId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter rawdata");
   }
-  doCallbacksFloat64Array(rawDataBuffer_, cfgNfft_, asynRawDataId_,0);
 
   // Add rawdata "plugin.fft%d.preprocdata"
   paramName =ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_PPDATA;
 
-  if( createParam(0, paramName.c_str(), asynParamFloat64Array, &asynPPDataId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), resultArrayType, &asynPPDataId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter preprocdata");
   }
-  doCallbacksFloat64Array(prepProcDataBuffer_, cfgNfft_, asynPPDataId_,0);
 
 
 
@@ -800,16 +1430,40 @@ void ecmcFFT::initAsyn() {
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_AMP;
 
-  if( createParam(0, paramName.c_str(), asynParamFloat64Array, &asynFFTAmpId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTAmpId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter fftamplitude");
   }
-  doCallbacksFloat64Array(fftBufferResultAmp_, cfgNfft_/2+1, asynFFTAmpId_,0);
+
+  // Optional outputs, only calculated for channels with clients (see drvUserCreate())
+  // Add fft phase "plugin.fft%d.fftphase"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_FFT_PHASE;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTPhaseId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter fftphase");
+  }
+
+  // Add fft real part "plugin.fft%d.fftreal"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_FFT_REAL;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTRealId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter fftreal");
+  }
+
+  // Add fft imaginary part "plugin.fft%d.fftimag"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_FFT_IMAG;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTImagId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter fftimag");
+  }
 
   // Add fft "plugin.fft%d.mode"
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_MODE;
 
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynFFTModeId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynFFTModeId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter mode");
   }
   setIntegerParam(asynFFTModeId_, (epicsInt32)cfgMode_);
@@ -818,43 +1472,54 @@ void ecmcFFT::initAsyn() {
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_STAT;
 
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynFFTStatId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynFFTStatId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter status");
   }
-  setIntegerParam(asynFFTStatId_, (epicsInt32)status_);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynFFTStatId_, (epicsInt32)channels_[i].engine->getStatus());
+  }
 
   // Add fft "plugin.fft%d.source"
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_SOURCE;
 
-  if( createParam(0, paramName.c_str(), asynParamInt8Array, &asynSourceId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt8Array, &asynSourceId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter source");
   }
-  doCallbacksInt8Array(cfgDataSourceStr_, strlen(cfgDataSourceStr_), asynSourceId_,0);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    doCallbacksInt8Array(channels_[i].sourceStr, strlen(channels_[i].sourceStr),
+                         asynSourceId_, channels_[i].index);
+  }
 
   // Add fft "plugin.fft%d.trigg"
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_TRIGG;
 
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynTriggId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynTriggId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter trigg");
   }
-  setIntegerParam(asynTriggId_, (epicsInt32)triggOnce_);
+  setIntegerParam(asynTriggId_, (epicsInt32)getTrigg());
 
   // Add fft "plugin.fft%d.fftxaxis"
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_FFT_X_FREQS;
 
-  if( createParam(0, paramName.c_str(), asynParamFloat64Array, &asynFFTXAxisId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTXAxisId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter xaxisfreqs");
   }
-  doCallbacksFloat64Array(fftBufferXAxis_,cfgNfft_ / 2 + 1, asynFFTXAxisId_,0);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].resultsFloat) {
+      publishXAxis(channels_[i].resultsFloat, &channels_[i]);
+    } else {
+      publishXAxis(channels_[i].resultsDouble, &channels_[i]);
+    }
+  }
 
   // Add fft "plugin.fft%d.nfft"
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_NFFT;
 
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynNfftId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynNfftId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter nfft");
   }
   setIntegerParam(asynNfftId_, (epicsInt32)cfgNfft_);
@@ -863,7 +1528,7 @@ void ecmcFFT::initAsyn() {
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_RATE;
 
-  if( createParam(0, paramName.c_str(), asynParamFloat64, &asynSRateId_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynSRateId_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter rate");
   }
   setDoubleParam(asynSRateId_, cfgDataSampleRateHz_);
@@ -872,13 +1537,356 @@ void ecmcFFT::initAsyn() {
   paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
              "." + ECMC_PLUGIN_ASYN_BUFF_ID;
 
-  if( createParam(0, paramName.c_str(), asynParamInt32, &asynElementsInBuffer_ ) != asynSuccess ) {
+  if( createParam(paramName.c_str(), asynParamInt32, &asynElementsInBuffer_ ) != asynSuccess ) {
     throw std::runtime_error("Failed create asyn parameter trigg");
   }
-  setIntegerParam(asynElementsInBuffer_, (epicsInt32)elementsInBuffer_);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynElementsInBuffer_,
+                    (epicsInt32)channels_[i].engine->getElementsInBuffer());
+  }
+
+  // Add fft "plugin.fft%d.window"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WINDOW;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynWindowId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter window");
+  }
+  setIntegerParam(asynWindowId_, (epicsInt32)cfgWindow_);
+
+  // Add fft "plugin.fft%d.fftamplitudeavg"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_FFT_AVG;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynFFTAvgId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter fftamplitudeavg");
+  }
+  // Initial (zero) results
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].calcFlags = ECMC_FFT_CALC_AVG_DONE;
+    if(channels_[i].resultsFloat) {
+      publishResults(channels_[i].resultsFloat, &channels_[i]);
+    } else {
+      publishResults(channels_[i].resultsDouble, &channels_[i]);
+    }
+    channels_[i].calcFlags = 0;
+  }
+
+  // Add fft "plugin.fft%d.avgmode"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_AVG_MODE;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynAvgModeId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter avgmode");
+  }
+  setIntegerParam(asynAvgModeId_, (epicsInt32)cfgAvgMode_);
+
+  // Add fft "plugin.fft%d.unit"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_UNIT;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynUnitId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter unit");
+  }
+  setIntegerParam(asynUnitId_, (epicsInt32)cfgUnit_);
+
+  // Add fft "plugin.fft%d.dbref"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_DB_REF;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynDbRefId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter dbref");
+  }
+  setDoubleParam(asynDbRefId_, cfgDbRef_);
+
+  // Add fft "plugin.fft%d.enbw"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_ENBW;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynEnbwId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter enbw");
+  }
+  setDoubleParam(asynEnbwId_, 0);
+
+  // Add fft "plugin.fft%d.zoomcenter"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_ZOOM_CENTER;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynZoomCenterId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter zoomcenter");
+  }
+  setDoubleParam(asynZoomCenterId_, cfgZoomCenter_);
+
+  // Add fft "plugin.fft%d.zoomspan"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_ZOOM_SPAN;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynZoomSpanId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter zoomspan");
+  }
+  setDoubleParam(asynZoomSpanId_, cfgZoomSpan_);
+
+  // Add fft "plugin.fft%d.publisharrays"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_PUBLISH_ARRAYS;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynPublishArraysId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter publisharrays");
+  }
+  setIntegerParam(asynPublishArraysId_, cfgPublishArrays_);
+
+  // Add fft "plugin.fft%d.band%d.rms", ".peak" and ".peakfreq" (per channel)
+  for(size_t b = 0; b < ECMC_PLUGIN_MAX_BANDS; ++b) {
+    for(int j = 0; j < ECMC_PLUGIN_BAND_OUTPUT_COUNT && b < engine_->getBandCount(); ++j) {
+      paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) +
+                  "." + ECMC_PLUGIN_ASYN_BAND + to_string((int)b) + "." + bandOutputStrings[j];
+      if( createParam(paramName.c_str(), asynParamFloat64, &asynBandIds_[b][j] ) != asynSuccess ) {
+        throw std::runtime_error("Failed create asyn parameter " + paramName);
+      }
+      for(size_t i = 0; i < channels_.size(); ++i) {
+        setDoubleParam(channels_[i].index, asynBandIds_[b][j], 0);
+      }
+    }
+  }
+
+  // Add fft "plugin.fft%d.avgcount"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_AVG_COUNT;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynAvgCountId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter avgcount");
+  }
+  setIntegerParam(asynAvgCountId_, (epicsInt32)cfgAvgCount_);
+
+  // Add fft "plugin.fft%d.avgalpha"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_AVG_ALPHA;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynAvgAlphaId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter avgalpha");
+  }
+  setDoubleParam(asynAvgAlphaId_, cfgAvgAlpha_);
+
+  // Add fft "plugin.fft%d.avgreset"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_AVG_RESET;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynAvgResetId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter avgreset");
+  }
+  setIntegerParam(asynAvgResetId_, 0);
+
+  // Add fft "plugin.fft%d.avgcounter"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_AVG_COUNTER;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynAvgCounterId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter avgcounter");
+  }
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynAvgCounterId_, 0);
+  }
+
+  // Add fft "plugin.fft%d.workerpolicy"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_POLICY;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynWorkerPolicyId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workerpolicy");
+  }
+  setIntegerParam(asynWorkerPolicyId_, (epicsInt32)workerPolicy_);
+
+  // Add fft "plugin.fft%d.workerprio"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_PRIO;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynWorkerPrioId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workerprio");
+  }
+  setIntegerParam(asynWorkerPrioId_, (epicsInt32)workerPrio_);
+
+  // Add fft "plugin.fft%d.workercpus"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_CPUS;
+
+  if( createParam(paramName.c_str(), asynParamInt8Array, &asynWorkerCpusId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workercpus");
+  }
+
+  // Add fft "plugin.fft%d.rttimelast"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_RT_TIME_LAST;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynRtTimeLastId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter rttimelast");
+  }
+  setIntegerParam(asynRtTimeLastId_, 0);
+
+  // Add fft "plugin.fft%d.rttimemin"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_RT_TIME_MIN;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynRtTimeMinId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter rttimemin");
+  }
+  setIntegerParam(asynRtTimeMinId_, 0);
+
+  // Add fft "plugin.fft%d.rttimemax"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_RT_TIME_MAX;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynRtTimeMaxId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter rttimemax");
+  }
+  setIntegerParam(asynRtTimeMaxId_, 0);
+
+  // Add fft "plugin.fft%d.rttimehist"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_RT_TIME_HIST;
+
+  if( createParam(paramName.c_str(), asynParamInt32Array, &asynRtTimeHistId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter rttimehist");
+  }
+
+  // Add fft "plugin.fft%d.samplesingested"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_SAMPLES_INGESTED;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynSamplesIngestedId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter samplesingested");
+  }
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynSamplesIngestedId_, 0);
+  }
+
+  // Add fft "plugin.fft%d.samplesdropped"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_SAMPLES_DROPPED;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynSamplesDroppedId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter samplesdropped");
+  }
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynSamplesDroppedId_, 0);
+  }
+
+  // Add fft "plugin.fft%d.samplesignored"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_SAMPLES_IGNORED;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynSamplesIgnoredId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter samplesignored");
+  }
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    setIntegerParam(channels_[i].index, asynSamplesIgnoredId_, 0);
+  }
+
+  // Add fft "plugin.fft%d.rtstatreset"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_RT_STAT_RESET;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynRtStatResetId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter rtstatreset");
+  }
+  setIntegerParam(asynRtStatResetId_, 0);
+
+  // Add fft "plugin.fft%d.workertime"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_TIME;
+
+  if( createParam(paramName.c_str(), asynParamFloat64Array, &asynWorkerTimeId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workertime");
+  }
+
+  // Add fft "plugin.fft%d.workertimemax"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_TIME_MAX;
+
+  if( createParam(paramName.c_str(), asynParamFloat64Array, &asynWorkerTimeMaxId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workertimemax");
+  }
+
+  // Add fft "plugin.fft%d.spectrarate"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_SPECTRA_RATE;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynSpectraRateId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter spectrarate");
+  }
+  setDoubleParam(asynSpectraRateId_, 0);
+
+  // Add fft "plugin.fft%d.latency"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_LATENCY;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynLatencyId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter latency");
+  }
+  setDoubleParam(asynLatencyId_, 0);
+
+  // Add fft "plugin.fft%d.latencymax"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_LATENCY_MAX;
+
+  if( createParam(paramName.c_str(), asynParamFloat64, &asynLatencyMaxId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter latencymax");
+  }
+  setDoubleParam(asynLatencyMaxId_, 0);
+
+  // Add fft "plugin.fft%d.workerstatreset"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_WORKER_STAT_RESET;
+
+  if( createParam(paramName.c_str(), asynParamInt32, &asynWorkerStatResetId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter workerstatreset");
+  }
+  setIntegerParam(asynWorkerStatResetId_, 0);
+
+  // Cross spectra (CROSS=1) on addr of each channel but first (reference)
+  // Add fft "plugin.fft%d.crossamplitude"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_CROSS_AMP;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynCrossAmpId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter crossamplitude");
+  }
+
+  // Add fft "plugin.fft%d.tfamplitude"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_TF_AMP;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynTfAmpId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter tfamplitude");
+  }
+
+  // Add fft "plugin.fft%d.tfphase"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_TF_PHASE;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynTfPhaseId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter tfphase");
+  }
+
+  // Add fft "plugin.fft%d.coherence"
+  paramName = ECMC_PLUGIN_ASYN_PREFIX + to_string(objectId_) + 
+             "." + ECMC_PLUGIN_ASYN_COHERENCE;
+
+  if( createParam(paramName.c_str(), resultArrayType, &asynCoherenceId_ ) != asynSuccess ) {
+    throw std::runtime_error("Failed create asyn parameter coherence");
+  }
+  // Initial (zero) results
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].crossFloat) {
+      publishCross(channels_[i].crossFloat, &channels_[i]);
+    } else if(channels_[i].crossDouble) {
+      publishCross(channels_[i].crossDouble, &channels_[i]);
+    }
+  }
 
   // Update integers
-  callParamCallbacks();
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    callParamCallbacks(channels_[i].index);
+  }
 }
 
 // Avoid issues with std:to_string()
@@ -889,84 +1897,476 @@ std::string ecmcFFT::to_string(int value) {
 }
 
 void ecmcFFT::setEnable(int enable) {
-  cfgEnable_ = enable;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->setEnable(enable);
+  }
   setIntegerParam(asynEnableId_, enable);
 }
   
+  
 void ecmcFFT::triggFFT() {
-  clearBuffers();
-  triggOnce_ = 1;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->clearBuffers();
+    channels_[i].engine->setTrigg(1);
+  }
   setIntegerParam(asynTriggId_,0);
 }
 
 void ecmcFFT::setModeFFT(FFT_MODE mode) {
-  cfgMode_ = mode;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    channels_[i].engine->setMode(mode);  // Starts over if mode changed
+  }
   setIntegerParam(asynFFTModeId_,(epicsInt32)mode);
 }
 
 FFT_STATUS ecmcFFT::getStatusFFT() {
-  return status_;
+  return engine_->getStatus();
 }
 
-void ecmcFFT::updateStatus(FFT_STATUS status) {
-  status_ = status;
-  setIntegerParam(asynFFTStatId_,(epicsInt32) status);
+int ecmcFFT::getTrigg() {
+  int trigg = 0;
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    trigg |= channels_[i].engine->getTrigg();
+  }
+  return trigg;
+}
+
+// Publish status and elements in buffer of engine of channel
+void ecmcFFT::updateStatus(ecmcFFTChannel* channel) {
+  setIntegerParam(channel->index, asynFFTStatId_,(epicsInt32)channel->engine->getStatus());
   
-  setIntegerParam(asynElementsInBuffer_, (epicsInt32)elementsInBuffer_);
+  setIntegerParam(channel->index, asynElementsInBuffer_, (epicsInt32)channel->engine->getElementsInBuffer());
 
-  callParamCallbacks();
+  callParamCallbacks(channel->index);
 }
 
 // Called from low prio worker thread. Makes the hard work
 void ecmcFFT::doCalcWorker() {
+  ecmcFFTWorkerPool::setupCurrentThread(cfgWorkerPolicy_, cfgWorkerPrio_, cfgWorkerCpusStr_);
+  updateWorkerThreadInfo();
+  lock();
+  callParamCallbacks();
+  unlock();
 
   while(true) {
     doCalcEvent_.wait();
-    if(destructs_) {
+    if(epicsAtomicGetIntT(&destructs_)) {
       break;
     }
-    // Pre-process    
-    removeDCOffset();  // Remove dc on rawdata
-    removeLin();       // Remove fitted line
-    // Process
-    calcFFT();         // FFT cacluation
-    // Post-process    
-    scaleFFT();        // Scale FFT
-    calcFFTAmp();      // Calculate amplitude from complex
-    calcFFTXAxis();    // Calculate x axis
-
-    doCallbacksFloat64Array(rawDataBuffer_,     cfgNfft_,     asynRawDataId_, 0);
-    doCallbacksFloat64Array(prepProcDataBuffer_, cfgNfft_,    asynPPDataId_,  0);
-    doCallbacksFloat64Array(fftBufferResultAmp_,cfgNfft_/2+1, asynFFTAmpId_,  0);
-    doCallbacksFloat64Array(fftBufferXAxis_,    cfgNfft_/2+1, asynFFTXAxisId_,0);
-    callParamCallbacks();    
-    if(cfgDbgMode_){
-      printComplexArray(fftBufferResult_,
-                        cfgNfft_,
-                        objectId_);
-      printEcDataArray((uint8_t*)rawDataBuffer_,
-                       cfgNfft_*sizeof(double),
-                       ECMC_EC_F64,
-                       objectId_);    
+    calcLock_.lock();
+    doCalc();
+    calcLock_.unlock();
+  }
+  // Last access of this object (destructor waits for it)
+  workerExitEvent_.signal();
+}
+
+// Called from shared worker pool thread
+void ecmcFFT::doCalcJob() {
+  // Another pool thread could be calculating this object already
+  calcLock_.lock();
+  if(epicsAtomicGetIntT(&destructs_)) {
+    calcLock_.unlock();
+    return;
+  }
+  updateWorkerThreadInfo();
+  doCalc();
+  calcLock_.unlock();
+}
+
+// Called from pool thread. Take the flagged job (new data handed over from now on needs a new job)
+int ecmcFFT::claimJob() {
+  return epicsAtomicCmpAndSwapIntT(&workerJobQueued_, 1, 0) == 1;
+}
+
+int ecmcFFT::getJobPending() {
+  return epicsAtomicGetIntT(&workerJobQueued_);
+}
+
+// Let worker thread, or worker pool, process handed over data
+void ecmcFFT::triggerWorker() {
+  if(workerPool_) {
+    // Only flag one job per object (the job reads all handed over data)
+    if(epicsAtomicCmpAndSwapIntT(&workerJobQueued_, 0, 1) == 0) {
+      workerPool_->submit();
     }
-    
-    clearBuffers();
-    triggOnce_ = 0;    // Wait for next trigger if in trigg mode
-    setIntegerParam(asynTriggId_,triggOnce_);
-    fftWaitingForCalc_ = 0;
-  } 
+    return;
+  }
+  doCalcEvent_.signal();
+}
+
+// Read back effective policy, priority and cpus of calling thread (if thread changed)
+void ecmcFFT::updateWorkerThreadInfo() {
+  epicsThreadId threadId = epicsThreadGetIdSelf();
+  if(threadId == workerThreadId_) {
+    return;
+  }
+  workerThreadId_ = threadId;
+
+  if(ecmcFFTWorkerPool::getCurrentThreadInfo(&workerPolicy_,
+                                             &workerPrio_,
+                                             workerCpus_,
+                                             sizeof(workerCpus_))) {
+    printf("%s/%s:%d: Warning: Failed read worker thread scheduling info.\n",
+            __FILE__, __FUNCTION__, __LINE__);
+  }
+  lock();
+  setIntegerParam(asynWorkerPolicyId_, (epicsInt32)workerPolicy_);
+  setIntegerParam(asynWorkerPrioId_, (epicsInt32)workerPrio_);
+  doCallbacksInt8Array(workerCpus_, strlen(workerCpus_), asynWorkerCpusId_, 0);
+  unlock();
+}
+
+/** Calc all channels in one pass, stage by stage (one transform plan and
+ *  the same code and twiddles for all channels while in cache).
+*/
+void ecmcFFT::doCalc() {
+  // Stage start times (and end of last stage)
+  int64_t stageNs[ECMC_PLUGIN_WORKER_STAGE_COUNT];
+  int64_t lastSampleNs = 0;
+  int     ready        = 0;
+
+  applyNfftRequest();
+  stageNs[STAGE_PREPROCESS] = getMonotonicNs();
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    ecmcFFTChannel* channel = &channels_[i];
+    ecmcFFTEngine*  engine  = channel->engine;
+    // Collect handed over data, acq. continues meanwhile in realtime
+    channel->calcReady = engine->readAcqBuffers();
+    if(!channel->calcReady) {
+      continue;  // No complete window yet (calc not started, nothing to end)
+    }
+    // Window, scale and x axis (only if changed). Clients get the x-axis only when it changes.
+    // Port locked since asyn reads copy the x-axis (and bins) directly
+    lock();
+    if(engine->updateCachedData()) {
+      if(channel->resultsFloat) {
+        publishXAxis(channel->resultsFloat, channel);
+      } else {
+        publishXAxis(channel->resultsDouble, channel);
+      }
+      if(i == 0) {
+        setDoubleParam(asynEnbwId_, engine->getEnbw());  // Same window and rate for all channels
+      }
+      setCrossBins(channel);  // Bins of zoom band changed
+    }
+    unlock();
+    // Pre-process (remove dc or fitted line, window)
+    engine->preProcess();
+    ready++;
+  }
+  if(!ready) {
+    return;
+  }
+
+  stageNs[STAGE_TRANSFORM] = getMonotonicNs();
+  // Process
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].calcReady) {
+      channels_[i].engine->calcFFT();         // FFT cacluation
+    }
+  }
+  stageNs[STAGE_POSTPROCESS] = getMonotonicNs();
+  // Post-process (scale, amplitude and average)
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].calcReady) {
+      channels_[i].calcFlags = channels_[i].engine->postProcess();
+    }
+  }
+  // End calc of snapshots (linear average done, start next. Triggered acq. can start over)
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].calcReady) {
+      channels_[i].engine->calcDone(channels_[i].calcFlags);
+    }
+  }
+  // Cross spectra of channels to first channel (windows of the same realtime cycles)
+  for(size_t i = 1; i < channels_.size(); ++i) {
+    ecmcFFTChannel* channel = &channels_[i];
+    channel->crossReady = 0;
+    if(!channel->calcReady || !channels_[0].calcReady) {
+      continue;
+    }
+    if(channel->crossFloat) {
+      channel->crossReady = calcCross(channels_[0].resultsFloat, channel->resultsFloat,
+                                      channel->crossFloat);
+    } else if(channel->crossDouble) {
+      channel->crossReady = calcCross(channels_[0].resultsDouble, channel->resultsDouble,
+                                      channel->crossDouble);
+    }
+  }
+  stageNs[STAGE_PUBLISH] = getMonotonicNs();
+
+  // Publish snapshots (arrays optional) and band summaries. Port locked since
+  // asyn writes change the same params
+  lock();
+  int publishArrays = epicsAtomicGetIntT(&publishArrays_);
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    ecmcFFTChannel* channel = &channels_[i];
+    if(!channel->calcReady) {
+      continue;
+    }
+    publishBands(channel);
+    // Without array callbacks the arrays can still be read on request (readResultArray())
+    if(publishArrays) {
+      if(channel->resultsFloat) {
+        publishResults(channel->resultsFloat, channel);
+      } else {
+        publishResults(channel->resultsDouble, channel);
+      }
+    }
+    if(channel->crossReady && publishArrays) {
+      if(channel->crossFloat) {
+        publishCross(channel->crossFloat, channel);
+      } else {
+        publishCross(channel->crossDouble, channel);
+      }
+    }
+    setIntegerParam(channel->index, asynAvgCounterId_, (epicsInt32)channel->engine->getAvgCounter());
+    if(channel->engine->getLastSampleNs() > lastSampleNs) {
+      lastSampleNs = channel->engine->getLastSampleNs();
+    }
+  }
+  stageNs[STAGE_TOTAL] = getMonotonicNs();
+  updateWorkerStats(stageNs, lastSampleNs);
+  // Trigg is reset in realtime when triggered acq. is done
+  setIntegerParam(asynTriggId_, getTrigg());
+  for(size_t i = 0; i < channels_.size(); ++i) {
+    if(channels_[i].calcReady) {
+      callParamCallbacks(channels_[i].index);
+    }
+  }
+  if(!channels_[0].calcReady) {
+    callParamCallbacks();  // Object wide params (addr 0)
+  }
+  unlock();
+}
+
+// Clients get the x-axis only when it changes (rate or NFFT)
+template<typename T>
+void ecmcFFT::publishXAxis(ecmcFFTResults<T>* results, ecmcFFTChannel* channel) {
+  doCallbacksArray(results->getXAxis(), channel->engine->getBins(), asynFFTXAxisId_, channel->index);
+}
+
+/** Clients and readers share the latest snapshot, worker calcs next into
+ *  another. The average is only published when done (ECMC_FFT_CALC_AVG_DONE).
+*/
+template<typename T>
+void ecmcFFT::publishResults(ecmcFFTResults<T>* results, ecmcFFTChannel* channel) {
+  ecmcFFTSnapshot<T>* snapshot = results->getSnapshot();
+  if(!snapshot) {
+    return;
+  }
+  int    addr = channel->index;
+  size_t bins = snapshot->bins;
+  doCallbacksArray(snapshot->rawData,      snapshot->nfft, asynRawDataId_, addr);
+  doCallbacksArray(snapshot->prepProcData, snapshot->nfft, asynPPDataId_, addr);
+  doCallbacksArray(snapshot->amp,          bins,           asynFFTAmpId_, addr);
+  if(snapshot->outputs & ECMC_FFT_OUTPUT_PHASE) {
+    doCallbacksArray(snapshot->phase, bins, asynFFTPhaseId_, addr);
+  }
+  if(snapshot->outputs & ECMC_FFT_OUTPUT_REAL) {
+    doCallbacksArray(snapshot->real, bins, asynFFTRealId_, addr);
+  }
+  if(snapshot->outputs & ECMC_FFT_OUTPUT_IMAG) {
+    doCallbacksArray(snapshot->imag, bins, asynFFTImagId_, addr);
+  }
+  if(channel->calcFlags & ECMC_FFT_CALC_AVG_DONE) {
+    doCallbacksArray(snapshot->avg, bins, asynFFTAvgId_, addr);
+  }
+  if(cfgDbgMode_){
+    printComplexArray(snapshot->result,
+                      bins,
+                      objectId_);
+    printEcDataArray((uint8_t*)snapshot->rawData,
+                     snapshot->nfft*sizeof(T),
+                     sizeof(T) == sizeof(float) ? ECMC_EC_F32 : ECMC_EC_F64,
+                     objectId_);    
+  }
+  results->releaseSnapshot(snapshot);
+}
+
+// Scalar summary of each band (of the latest spectrum)
+void ecmcFFT::publishBands(ecmcFFTChannel* channel) {
+  size_t bands = channel->engine->getBandCount();
+  for(size_t b = 0; b < bands; ++b) {
+    for(int j = 0; j < ECMC_PLUGIN_BAND_OUTPUT_COUNT; ++j) {
+      setDoubleParam(channel->index, asynBandIds_[b][j],
+                     channel->engine->getBandValue(b, (FFT_BAND_OUTPUT)j));
+    }
+  }
+}
+
+/** Band value of first channel (PLC, any thread). Throws out_of_range if
+ *  the band is not configured.
+*/
+double ecmcFFT::getBandValue(int band, FFT_BAND_OUTPUT output) {
+  if(band < 0 || (size_t)band >= engine_->getBandCount()) {
+    throw std::out_of_range("Band index out of range.");
+  }
+  return engine_->getBandValue((size_t)band, output);
+}
+
+// Band and output of a band parameter (returns 0 if not a band parameter)
+int ecmcFFT::getBandParam(int function, size_t* band, FFT_BAND_OUTPUT* output) {
+  for(size_t b = 0; b < engine_->getBandCount(); ++b) {
+    for(int j = 0; j < ECMC_PLUGIN_BAND_OUTPUT_COUNT; ++j) {
+      if(asynBandIds_[b][j] == function) {
+        *band   = b;
+        *output = (FFT_BAND_OUTPUT)j;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+/** Add the latest spectra of reference (first channel) and channel to the
+ *  cross spectrum. Returns 1 if new cross results are available.
+*/
+template<typename T>
+int ecmcFFT::calcCross(ecmcFFTResults<T>* reference, ecmcFFTResults<T>* results,
+                       ecmcFFTCross<T>* cross) {
+  ecmcFFTSnapshot<T>* x = reference->getSnapshot();
+  ecmcFFTSnapshot<T>* y = results->getSnapshot();
+  int newResults = 0;
+  if(x && y && x->nfft == y->nfft && x->bins == y->bins) {
+    newResults = cross->add(x->result, y->result, x->bins,
+                            engine_->getAvgMode(),
+                            engine_->getAvgCount(),
+                            engine_->getAvgAlpha());
+  }
+  if(x) {
+    reference->releaseSnapshot(x);
+  }
+  if(y) {
+    results->releaseSnapshot(y);
+  }
+  return newResults;
+}
+
+// Cross results of channel (x-axis of channel)
+template<typename T>
+void ecmcFFT::publishCross(ecmcFFTCross<T>* cross, ecmcFFTChannel* channel) {
+  size_t bins = cross->getBins();
+  int    addr = channel->index;
+  doCallbacksArray((T*)cross->getOutput(CROSS_AMP),       bins, asynCrossAmpId_, addr);
+  doCallbacksArray((T*)cross->getOutput(CROSS_TF_AMP),    bins, asynTfAmpId_, addr);
+  doCallbacksArray((T*)cross->getOutput(CROSS_TF_PHASE),  bins, asynTfPhaseId_, addr);
+  doCallbacksArray((T*)cross->getOutput(CROSS_COHERENCE), bins, asynCoherenceId_, addr);
+}
+
+void ecmcFFT::doCallbacksArray(double* value, size_t nElements, int reason, int addr) {
+  doCallbacksFloat64Array(value, nElements, reason, addr);
+}
+
+void ecmcFFT::doCallbacksArray(float* value, size_t nElements, int reason, int addr) {
+  doCallbacksFloat32Array(value, nElements, reason, addr);
+}
+
+void ecmcFFT::setWorkerPool(ecmcFFTWorkerPool* pool) {
+  workerPool_ = pool;
+}
+
+int ecmcFFT::getCfgPoolThreads() {
+  return cfgPoolThreads_;
+}
+
+int ecmcFFT::getCfgPoolPrio() {
+  return cfgPoolPrio_;
+}
+
+const char* ecmcFFT::getCfgPoolCpus() {
+  return cfgPoolCpusStr_;
 }
 
 asynStatus ecmcFFT::writeInt32(asynUser *pasynUser, epicsInt32 value) {
   int function = pasynUser->reason;
   if( function == asynEnableId_ ) {
-    cfgEnable_ = value;
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setEnable(value);
+    }
     return asynSuccess;
   } else if( function == asynFFTModeId_){
-    cfgMode_ = (FFT_MODE)value;
+    if(engine_->getZoom() && value != CONT) {
+      return asynError;  // Zoom needs continous data
+    }
+    setModeFFT((FFT_MODE)value);
     return asynSuccess;
   } else if( function == asynTriggId_){
-    triggOnce_ = value > 0;
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setTrigg(value > 0);
+    }
+    return asynSuccess;
+  } else if( function == asynWindowId_){
+    if(value < 0 || value >= ECMC_PLUGIN_WINDOW_COUNT) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setWindow((FFT_WINDOW)value);  // New window table and scale
+    }
+    resetCrossAvg();
+    setIntegerParam(asynWindowId_, value);
+    return asynSuccess;
+  } else if( function == asynAvgModeId_){
+    if(value < 0 || value >= ECMC_PLUGIN_AVG_MODE_COUNT) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setAvgMode((FFT_AVG_MODE)value);
+    }
+    resetCrossAvg();
+    setIntegerParam(asynAvgModeId_, value);
+    return asynSuccess;
+  } else if( function == asynUnitId_){
+    if(value < 0 || value >= ECMC_PLUGIN_UNIT_COUNT) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setUnit((FFT_UNIT)value);  // Restarts averaging
+    }
+    setIntegerParam(asynUnitId_, value);
+    return asynSuccess;
+  } else if( function == asynAvgCountId_){
+    if(value < 1) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setAvgCount(value);
+    }
+    resetCrossAvg();
+    setIntegerParam(asynAvgCountId_, value);
+    return asynSuccess;
+  } else if( function == asynAvgResetId_){
+    if(value) {
+      for(size_t i = 0; i < channels_.size(); ++i) {
+        channels_[i].engine->resetAvg();
+      }
+      resetCrossAvg();
+    }
+    return asynSuccess;
+  } else if( function == asynRtStatResetId_){
+    if(value) {
+      epicsAtomicSetIntT(&rtStatsReset_, 1);  // Reset by realtime thread
+    }
+    return asynSuccess;
+  } else if( function == asynWorkerStatResetId_){
+    if(value) {
+      epicsAtomicSetIntT(&workerStatsReset_, 1);  // Reset by worker
+    }
+    return asynSuccess;
+  } else if( function == asynPublishArraysId_){
+    epicsAtomicSetIntT(&publishArrays_, value != 0);  // From next spectrum
+    setIntegerParam(asynPublishArraysId_, value != 0);
+    return asynSuccess;
+  } else if( function == asynNfftId_){
+    try {
+      setNfft((size_t)value);
+    }
+    catch(std::exception& e) {
+      printf("%s/%s:%d: Error: %s (%d).\n",
+             __FILE__, __FUNCTION__, __LINE__, e.what(), value);
+      return asynError;
+    }
     return asynSuccess;
   }
   return asynError;
@@ -974,62 +2374,259 @@ asynStatus ecmcFFT::writeInt32(asynUser *pasynUser, epicsInt32 value) {
 
 asynStatus ecmcFFT::readInt32(asynUser *pasynUser, epicsInt32 *value) {
   int function = pasynUser->reason;
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if(!channel) {
+    return asynError;
+  }
   if( function == asynEnableId_ ) {
-    *value = cfgEnable_;
+    *value = engine_->getEnable();
     return asynSuccess;
   } else if( function == asynFFTModeId_ ){
-    *value = cfgMode_;
+    *value = engine_->getMode();
     return asynSuccess;
   } else if( function == asynTriggId_ ){
-    *value = triggOnce_;
+    *value = getTrigg();
     return asynSuccess;
   }else if( function == asynFFTStatId_ ){
-    *value = (epicsInt32)status_;
+    *value = (epicsInt32)channel->engine->getStatus();
     return asynSuccess;
   }else if( function == asynNfftId_ ){
-    *value = (epicsInt32)cfgNfft_;
+    *value = (epicsInt32)engine_->getNfft();
     return asynSuccess;
   }else if( function == asynElementsInBuffer_){
-    *value = (epicsInt32)elementsInBuffer_;
+    *value = (epicsInt32)channel->engine->getElementsInBuffer();
+    return asynSuccess;
+  }else if( function == asynWindowId_){
+    *value = (epicsInt32)engine_->getWindow();
+    return asynSuccess;
+  }else if( function == asynAvgModeId_){
+    *value = (epicsInt32)engine_->getAvgMode();
+    return asynSuccess;
+  }else if( function == asynUnitId_){
+    *value = (epicsInt32)engine_->getUnit();
+    return asynSuccess;
+  }else if( function == asynAvgCountId_){
+    *value = (epicsInt32)engine_->getAvgCount();
+    return asynSuccess;
+  }else if( function == asynAvgCounterId_){
+    *value = (epicsInt32)channel->engine->getAvgCounter();
+    return asynSuccess;
+  }else if( function == asynWorkerPolicyId_){
+    *value = (epicsInt32)workerPolicy_;
+    return asynSuccess;
+  }else if( function == asynWorkerPrioId_){
+    *value = (epicsInt32)workerPrio_;
+    return asynSuccess;
+  }else if( function == asynRtTimeLastId_){
+    *value = epicsAtomicGetIntT(&rtTimeLast_);
+    return asynSuccess;
+  }else if( function == asynRtTimeMinId_){
+    *value = epicsAtomicGetIntT(&rtTimeMin_);
+    return asynSuccess;
+  }else if( function == asynRtTimeMaxId_){
+    *value = epicsAtomicGetIntT(&rtTimeMax_);
+    return asynSuccess;
+  }else if( function == asynSamplesIngestedId_){
+    *value = channel->engine->getSamplesIngested();
+    return asynSuccess;
+  }else if( function == asynSamplesDroppedId_){
+    *value = channel->engine->getSamplesDropped();
+    return asynSuccess;
+  }else if( function == asynSamplesIgnoredId_){
+    *value = channel->engine->getSamplesIgnored();
+    return asynSuccess;
+  }else if( function == asynPublishArraysId_){
+    *value = epicsAtomicGetIntT(&publishArrays_);
     return asynSuccess;
   }
 
   return asynError;
 }
 
-asynStatus ecmcFFT::readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
-                                     size_t nElements, size_t *nIn) {
-  int function = pasynUser->reason;
-  if( function == asynRawDataId_ ) {
-    unsigned int ncopy = cfgNfft_;
-    if(nElements < ncopy) {
-      ncopy = nElements;
-    } 
-    memcpy (value, rawDataBuffer_, ncopy);
-    *nIn = ncopy;
-    return asynSuccess;
-  } else if( function == asynPPDataId_) {
-    unsigned int ncopy = cfgNfft_;
+int ecmcFFT::isResultArray(int function) {
+  return function == asynRawDataId_ || function == asynPPDataId_ ||
+         function == asynFFTAmpId_ || function == asynFFTAvgId_ ||
+         function == asynFFTXAxisId_ || getOutputFlag(function);
+}
+
+int ecmcFFT::getOutputFlag(int function) {
+  if( function == asynFFTPhaseId_ ) {
+    return ECMC_FFT_OUTPUT_PHASE;
+  } else if( function == asynFFTRealId_ ) {
+    return ECMC_FFT_OUTPUT_REAL;
+  } else if( function == asynFFTImagId_ ) {
+    return ECMC_FFT_OUTPUT_IMAG;
+  }
+  return 0;
+}
+
+// Engine only calculates outputs with connected clients (from next spectrum)
+void ecmcFFT::updateOutputs(ecmcFFTChannel* channel) {
+  int outputs = 0;
+  for(int i = 0; i < ECMC_FFT_OUTPUT_COUNT; ++i) {
+    if(channel->outputClients[i] > 0) {
+      outputs |= 1 << i;
+    }
+  }
+  channel->engine->setOutputs(outputs);
+}
+
+/** Count clients (records, asyn clients) of the optional outputs per
+ *  channel. Called with port locked when a client connects to a parameter.
+*/
+asynStatus ecmcFFT::drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                  const char **pptypeName, size_t *psize) {
+  asynStatus status = asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
+  if(status != asynSuccess) {
+    return status;
+  }
+  int             flag    = getOutputFlag(pasynUser->reason);
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if(flag && channel) {
+    for(int i = 0; i < ECMC_FFT_OUTPUT_COUNT; ++i) {
+      if(flag == 1 << i) {
+        channel->outputClients[i]++;
+      }
+    }
+    updateOutputs(channel);
+  }
+  return asynSuccess;
+}
+
+asynStatus ecmcFFT::drvUserDestroy(asynUser *pasynUser) {
+  int             flag    = getOutputFlag(pasynUser->reason);
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if(flag && channel) {
+    for(int i = 0; i < ECMC_FFT_OUTPUT_COUNT; ++i) {
+      if(flag == 1 << i && channel->outputClients[i] > 0) {
+        channel->outputClients[i]--;
+      }
+    }
+    updateOutputs(channel);
+  }
+  return asynPortDriver::drvUserDestroy(pasynUser);
+}
+
+int ecmcFFT::getCrossOutput(int function) {
+  if( function == asynCrossAmpId_ ) {
+    return CROSS_AMP;
+  } else if( function == asynTfAmpId_ ) {
+    return CROSS_TF_AMP;
+  } else if( function == asynTfPhaseId_ ) {
+    return CROSS_TF_PHASE;
+  } else if( function == asynCoherenceId_ ) {
+    return CROSS_COHERENCE;
+  }
+  return -1;
+}
+
+// Read latest cross results (not changed while copied, no lock of worker)
+template<typename T>
+asynStatus ecmcFFT::readCrossArray(ecmcFFTCross<T>* cross, int function,
+                                   T *value, size_t nElements, size_t *nIn) {
+  *nIn = cross->read((FFT_CROSS_OUTPUT)getCrossOutput(function), value, nElements);
+  return asynSuccess;
+}
+
+template<typename T>
+asynStatus ecmcFFT::readResultArray(ecmcFFTResults<T>* results, ecmcFFTChannel* channel,
+                                    int function, T *value, size_t nElements, size_t *nIn) {
+  if( function == asynFFTXAxisId_ ) {
+    // Port locked, x-axis only reallocated and filled by worker with port locked
+    size_t ncopy = channel->engine->getBins();
     if(nElements < ncopy) {
       ncopy = nElements;
     } 
-    memcpy (value, prepProcDataBuffer_, ncopy);
+    memcpy (value, results->getXAxis(), ncopy * sizeof(T));
     *nIn = ncopy;
     return asynSuccess;
-  } else if( function == asynFFTXAxisId_ ) {
-    unsigned int ncopy = cfgNfft_/ 2 + 1;
+  }
+
+  // Read from published snapshot (not changed while referenced, no lock of worker)
+  ecmcFFTSnapshot<T>* snapshot = function == asynFFTAvgId_ ? 
+                                 results->getAvgSnapshot() : results->getSnapshot();
+  if(!snapshot) {
+    *nIn = 0;
+    return asynError;
+  }
+  const T* data  = snapshot->amp;
+  size_t   ncopy = snapshot->bins;
+  int      flag  = getOutputFlag(function);
+  if( flag ) {
+    data = flag == ECMC_FFT_OUTPUT_PHASE ? snapshot->phase :
+           flag == ECMC_FFT_OUTPUT_REAL  ? snapshot->real : snapshot->imag;
+    if(!(snapshot->outputs & flag)) {
+      ncopy = 0;  // Not calculated before a client connected
+    }
+  } else if( function == asynRawDataId_ ) {
+    data  = snapshot->rawData;
+    ncopy = snapshot->nfft;
+  } else if( function == asynPPDataId_ ) {
+    data  = snapshot->prepProcData;
+    ncopy = snapshot->nfft;
+  } else if( function == asynFFTAvgId_ ) {
+    data  = snapshot->avg;
+  }
+  if(nElements < ncopy) {
+    ncopy = nElements;
+  } 
+  if(ncopy) {
+    memcpy (value, data, ncopy * sizeof(T));
+  }
+  results->releaseSnapshot(snapshot);
+  *nIn = ncopy;
+  return asynSuccess;
+}
+
+asynStatus ecmcFFT::readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
+                                     size_t nElements, size_t *nIn) {
+  int    function = pasynUser->reason;
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if( isResultArray(function) && channel && channel->resultsDouble ) {
+    return readResultArray(channel->resultsDouble, channel, function, value, nElements, nIn);
+  } else if( getCrossOutput(function) >= 0 && channel && channel->crossDouble ) {
+    return readCrossArray(channel->crossDouble, function, value, nElements, nIn);
+  } else if( function == asynWorkerTimeId_ || function == asynWorkerTimeMaxId_ ) {
+    unsigned int ncopy = ECMC_PLUGIN_WORKER_STAGE_COUNT;
     if(nElements < ncopy) {
       ncopy = nElements;
     } 
-    memcpy (value, fftBufferXAxis_, ncopy);
+    memcpy (value, function == asynWorkerTimeId_ ? workerTime_ : workerTimeMax_,
+            ncopy * sizeof(double));
     *nIn = ncopy;
     return asynSuccess;
-  } if( function == asynFFTAmpId_ ) {
-    unsigned int ncopy = cfgNfft_/ 2 + 1;
+  }
+
+  *nIn = 0;
+  return asynError;
+}
+
+// Result arrays of PRECISION=FLOAT and FIXED
+asynStatus ecmcFFT::readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                     size_t nElements, size_t *nIn) {
+  int function = pasynUser->reason;
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if( isResultArray(function) && channel && channel->resultsFloat ) {
+    return readResultArray(channel->resultsFloat, channel, function, value, nElements, nIn);
+  } else if( getCrossOutput(function) >= 0 && channel && channel->crossFloat ) {
+    return readCrossArray(channel->crossFloat, function, value, nElements, nIn);
+  }
+
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus ecmcFFT::readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                    size_t nElements, size_t *nIn) {
+  int function = pasynUser->reason;
+  if( function == asynRtTimeHistId_ ) {
+    size_t ncopy = ECMC_PLUGIN_RT_HIST_BINS;
     if(nElements < ncopy) {
       ncopy = nElements;
-    } 
-    memcpy (value, fftBufferResultAmp_, ncopy);
+    }
+    for(size_t i = 0; i < ncopy; ++i) {
+      value[i] = epicsAtomicGetIntT(&rtTimeHist_[i]);
+    }
     *nIn = ncopy;
     return asynSuccess;
   }
@@ -1041,12 +2638,21 @@ asynStatus ecmcFFT::readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
 asynStatus ecmcFFT::readInt8Array(asynUser *pasynUser, epicsInt8 *value, 
                                    size_t nElements, size_t *nIn) {
   int function = pasynUser->reason;
-  if( function == asynSourceId_ ) {
-    unsigned int ncopy = strlen(cfgDataSourceStr_);
+  ecmcFFTChannel* channel = getChannel(pasynUser);
+  if( function == asynSourceId_ && channel ) {
+    unsigned int ncopy = strlen(channel->sourceStr);
+    if(nElements < ncopy) {
+      ncopy = nElements;
+    } 
+    memcpy (value, channel->sourceStr, ncopy);
+    *nIn = ncopy;
+    return asynSuccess;
+  } else if( function == asynWorkerCpusId_ ) {
+    unsigned int ncopy = strlen(workerCpus_);
     if(nElements < ncopy) {
       ncopy = nElements;
     } 
-    memcpy (value, cfgDataSourceStr_, ncopy);
+    memcpy (value, workerCpus_, ncopy);
     *nIn = ncopy;
     return asynSuccess;
   }
@@ -1058,41 +2664,126 @@ asynStatus ecmcFFT::readInt8Array(asynUser *pasynUser, epicsInt8 *value,
 asynStatus  ecmcFFT::readFloat64(asynUser *pasynUser, epicsFloat64 *value) {
   int function = pasynUser->reason;
   if( function == asynSRateId_ ) {
-    *value = cfgDataSampleRateHz_;
+    *value = engine_->getSampleRate();
+    return asynSuccess;
+  } else if( function == asynAvgAlphaId_ ) {
+    *value = engine_->getAvgAlpha();
+    return asynSuccess;
+  } else if( function == asynDbRefId_ ) {
+    *value = engine_->getDbRef();
+    return asynSuccess;
+  } else if( function == asynEnbwId_ ) {
+    *value = engine_->getEnbw();
+    return asynSuccess;
+  } else if( function == asynZoomCenterId_ ) {
+    *value = engine_->getZoomCenter();
+    return asynSuccess;
+  } else if( function == asynZoomSpanId_ ) {
+    *value = engine_->getZoomSpan();
+    return asynSuccess;
+  } else if( function == asynSpectraRateId_ ) {
+    *value = spectraRate_;
+    return asynSuccess;
+  } else if( function == asynLatencyId_ ) {
+    *value = latency_;
+    return asynSuccess;
+  } else if( function == asynLatencyMaxId_ ) {
+    *value = latencyMax_;
+    return asynSuccess;
+  }
+
+  // Band summaries (per channel)
+  size_t          band;
+  FFT_BAND_OUTPUT output;
+  if(getBandParam(function, &band, &output)) {
+    ecmcFFTChannel* channel = getChannel(pasynUser);
+    if(!channel) {
+      return asynError;
+    }
+    *value = channel->engine->getBandValue(band, output);
     return asynSuccess;
   }
 
   return asynError;
 }
 
-/* y = k*x+m */
-int ecmcFFT::leastSquare(int n, const double y[], double* k, double* m){
-  double   sumx  = 0.0;
-  double   sumx2 = 0.0;
-  double   sumxy = 0.0;
-  double   sumy  = 0.0;
-  double   sumy2 = 0.0;
-
-  for (int x = 0; x < n; ++x){ 
-    //simulate x by just index
-    sumx  += x;
-    sumx2 += x * x;
-    sumxy += x * y[x];
-    sumy  += y[x];
-    sumy2 += y[x] * y[x];
-  } 
+asynStatus  ecmcFFT::writeFloat64(asynUser *pasynUser, epicsFloat64 value) {
+  int function = pasynUser->reason;
+  if( function == asynAvgAlphaId_ ) {
+    if(value <= 0 || value > 1) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setAvgAlpha(value);
+    }
+    setDoubleParam(asynAvgAlphaId_, value);
+    return asynSuccess;
+  } else if( function == asynDbRefId_ ) {
+    if(value <= 0) {
+      return asynError;
+    }
+    for(size_t i = 0; i < channels_.size(); ++i) {
+      channels_[i].engine->setDbRef(value);
+    }
+    setDoubleParam(asynDbRefId_, value);
+    return asynSuccess;
+  } else if( function == asynZoomCenterId_ || function == asynZoomSpanId_ ) {
+    // Band of zoom (only if configured with ZOOM_SPAN)
+    if(!engine_->getZoom()) {
+      return asynError;
+    }
+    double center = function == asynZoomCenterId_ ? value : engine_->getZoomCenter();
+    double span   = function == asynZoomSpanId_   ? value : engine_->getZoomSpan();
+    try {
+      for(size_t i = 0; i < channels_.size(); ++i) {
+        channels_[i].engine->setZoom(center, span);  // Restarts zoom window
+      }
+    }
+    catch(std::exception& e) {
+      printf("%s/%s:%d: Error: Invalid zoom band (%s).\n",
+             __FILE__, __FUNCTION__, __LINE__, e.what());
+      return asynError;
+    }
+    setDoubleParam(asynZoomCenterId_, center);
+    setDoubleParam(asynZoomSpanId_, span);
+    return asynSuccess;
+  }
+
+  return asynError;
+}
+
+asynStatus ecmcFFT::readEnum(asynUser *pasynUser, char *strings[], int values[],
+                             int severities[], size_t nElements, size_t *nIn) {
+  int function = pasynUser->reason;
+  const char** enumStrings = NULL;
+  size_t       enumCount   = 0;
+  if( function == asynWindowId_ ) {
+    enumStrings = windowStrings;
+    enumCount   = ECMC_PLUGIN_WINDOW_COUNT;
+  } else if( function == asynAvgModeId_ ) {
+    enumStrings = avgModeStrings;
+    enumCount   = ECMC_PLUGIN_AVG_MODE_COUNT;
+  } else if( function == asynUnitId_ ) {
+    enumStrings = unitStrings;
+    enumCount   = ECMC_PLUGIN_UNIT_COUNT;
+  }
 
-  double denom = (n * sumx2 - sumx * sumx);
-  if (denom == 0) {
-    // Cannot dive by 0.. something wrong..
-    *k = 0;
-    *m = 0;
-    return 1; // Error
+  if(enumStrings) {
+    size_t i;
+    for(i = 0; i < enumCount && i < nElements; ++i) {
+      if(strings[i]) {
+        free(strings[i]);
+      }
+      strings[i]    = epicsStrDup(enumStrings[i]);
+      values[i]     = (int)i;
+      severities[i] = 0;
+    }
+    *nIn = i;
+    return asynSuccess;
   }
 
-  *k = (n * sumxy  -  sumx * sumy) / denom;
-  *m = (sumy * sumx2  -  sumx * sumxy) / denom;
-  return 0; 
+  *nIn = 0;
+  return asynError;
 }
 
 bool ecmcFFT::verifyBreakTable() {
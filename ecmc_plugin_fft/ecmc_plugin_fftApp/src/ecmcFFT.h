@@ -18,8 +18,37 @@
 #include "ecmcFFTDefs.h"
 #include "inttypes.h"
 #include <string>
-#include "kissfft/kissfft.hh"
+#include <vector>
+#include "ecmcFFTEngine.h"
+#include "ecmcFFTCross.h"
 #include "dbBase.h"
+#include "epicsMutex.h"
+#include "epicsEvent.h"
+#include "epicsThread.h"
+
+class ecmcFFTWorkerPool;
+class ecmcFFT;
+
+/** One data source of an FFT object (SOURCE or one item of SOURCES).
+ *  Index is the asyn address of the per channel parameters.
+*/
+typedef struct ecmcFFTChannel {
+  ecmcFFT*                fft;
+  int                     index;
+  char*                   sourceStr;
+  ecmcDataItem*           dataItem;
+  ecmcDataItemInfo*       dataItemInfo;
+  int                     callbackHandle;   // ecmc callback handle for use when deregister at unload
+  ecmcFFTEngine*          engine;           // Acquisition and DSP pipeline of channel
+  ecmcFFTResults<double>* resultsDouble;    // Results of engine if PRECISION=DOUBLE (else NULL)
+  ecmcFFTResults<float>*  resultsFloat;     // Results of engine if PRECISION=FLOAT or FIXED (else NULL)
+  ecmcFFTCross<double>*   crossDouble;      // Cross spectrum to first channel if CROSS and PRECISION=DOUBLE (else NULL)
+  ecmcFFTCross<float>*    crossFloat;       // Cross spectrum to first channel if CROSS and PRECISION=FLOAT or FIXED (else NULL)
+  int                     calcReady;        // New window in current calc (worker)
+  int                     calcFlags;        // ECMC_FFT_CALC_* of current calc (worker)
+  int                     crossReady;       // New cross results in current calc (worker)
+  int                     outputClients[ECMC_FFT_OUTPUT_COUNT]; // Clients of optional outputs (phase, real, imag)
+} ecmcFFTChannel;
 
 class ecmcFFT : public asynPortDriver {
  public:
@@ -36,69 +65,116 @@ class ecmcFFT : public asynPortDriver {
           char* portName);
   ~ecmcFFT();  
 
-  // Add data to buffer (called from "external" callback)
-  void                  dataUpdatedCallback(uint8_t* data, 
+  // Add data to buffer of channel (called from "external" callback)
+  void                  dataUpdatedCallback(ecmcFFTChannel* channel,
+                                            uint8_t* data, 
                                             size_t size,
                                             ecmcEcDataType dt);
   // Call just before realtime because then all data sources should be available
   void                  connectToDataSource();
   void                  setEnable(int enable);
   void                  setModeFFT(FFT_MODE mode);
-  FFT_STATUS            getStatusFFT();
+  FFT_STATUS            getStatusFFT();  // Of first channel
   void                  clearBuffers();
   void                  triggFFT();
+  void                  setNfft(size_t nfft);  // Applied by worker between acquisitions
+  double                getBandValue(int band, FFT_BAND_OUTPUT output);  // Of first channel
   void                  doCalcWorker();  // Called from worker thread calc the results
+  void                  doCalcJob();     // Called from shared worker pool thread
+  int                   claimJob();      // Called from pool thread, 1 if job was flagged
+  int                   getJobPending();
+  void                  setWorkerPool(ecmcFFTWorkerPool* pool);
+  int                   getCfgPoolThreads();
+  int                   getCfgPoolPrio();
+  const char*           getCfgPoolCpus();
   virtual asynStatus    writeInt32(asynUser *pasynUser, epicsInt32 value);
   virtual asynStatus    readInt32(asynUser *pasynUser, epicsInt32 *value);
   virtual asynStatus    readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
                                          size_t nElements, size_t *nIn);
+  virtual asynStatus    readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                         size_t nElements, size_t *nIn);
+  virtual asynStatus    readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                       size_t nElements, size_t *nIn);
   virtual asynStatus    readInt8Array(asynUser *pasynUser, epicsInt8 *value, 
                                       size_t nElements, size_t *nIn);
   virtual asynStatus    readFloat64(asynUser *pasynUser, epicsFloat64 *value);
+  virtual asynStatus    writeFloat64(asynUser *pasynUser, epicsFloat64 value);
+  virtual asynStatus    readEnum(asynUser *pasynUser, char *strings[], int values[],
+                                 int severities[], size_t nElements, size_t *nIn);
+  virtual asynStatus    drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                      const char **pptypeName, size_t *psize);
+  virtual asynStatus    drvUserDestroy(asynUser *pasynUser);
 
 
  private:
   void                  parseConfigStr(char *configStr);
-  void                  addDataToBuffer(double data);
-  void                  calcFFT();
-  void                  scaleFFT();
-  void                  calcFFTAmp();
-  void                  calcFFTXAxis();
-  void                  removeDCOffset();
-  void                  removeLin();
+  void                  parseSources();
+  void                  parseBands(std::vector<double>* low, std::vector<double>* high);
+  static int            getChannelCount(const char *configStr);  // Before parse (maxAddr)
+  template<typename T, typename S>
+  ecmcFFTEngineT<T, S>* createEngine(ecmcFFTChannel* channel);
+  void                  deleteEngines();     // And cross spectra
+  void                  resetCrossAvg();
+  void                  setCrossBins(ecmcFFTChannel* channel);
+  ecmcFFTChannel*       getChannel(asynUser *pasynUser);  // NULL if invalid addr
+  template<typename T>
+  static void           applyBreakTable(void* obj,
+                                        T* data,
+                                        size_t elements);  // Raw conversion hook of engine
+  template<typename T>
+  void                  publishXAxis(ecmcFFTResults<T>* results, ecmcFFTChannel* channel);
+  template<typename T>
+  void                  publishResults(ecmcFFTResults<T>* results, ecmcFFTChannel* channel);
+  template<typename T>
+  asynStatus            readResultArray(ecmcFFTResults<T>* results, ecmcFFTChannel* channel,
+                                        int function, T *value, size_t nElements, size_t *nIn);
+  void                  publishBands(ecmcFFTChannel* channel);
+  int                   getBandParam(int function, size_t* band, FFT_BAND_OUTPUT* output);
+  template<typename T>
+  int                   calcCross(ecmcFFTResults<T>* reference, ecmcFFTResults<T>* results,
+                                  ecmcFFTCross<T>* cross);
+  template<typename T>
+  void                  publishCross(ecmcFFTCross<T>* cross, ecmcFFTChannel* channel);
+  template<typename T>
+  asynStatus            readCrossArray(ecmcFFTCross<T>* cross, int function,
+                                       T *value, size_t nElements, size_t *nIn);
+  void                  doCallbacksArray(double* value, size_t nElements, int reason, int addr);
+  void                  doCallbacksArray(float* value, size_t nElements, int reason, int addr);
+  int                   isResultArray(int function);
+  int                   getCrossOutput(int function);  // FFT_CROSS_OUTPUT (-1 if not cross array)
+  int                   getOutputFlag(int function);   // ECMC_FFT_OUTPUT_* (0 if not optional output)
+  void                  updateOutputs(ecmcFFTChannel* channel);  // Outputs with clients to engine
+  void                  updateRtStats(epicsInt32 timeNs);
+  void                  resetRtStats();
+  void                  updateWorkerStats(int64_t* stageNs, int64_t lastSampleNs);
+  void                  resetWorkerStats();
+  void                  applyNfftRequest();
+  void                  doCalc();
+  void                  triggerWorker();
+  void                  updateWorkerThreadInfo();  // Called from worker thread
   void                  initAsyn();
-  void                  updateStatus(FFT_STATUS status);  // Also updates asynparam
+  void                  updateStatus(ecmcFFTChannel* channel);  // Publish status of engine
+  int                   getTrigg();          // Any channel in triggered acq.
   static int            dataTypeSupported(ecmcEcDataType dt);
+  static FFT_SAMPLE_TYPE getSampleType(ecmcEcDataType dt);
   bool                  verifyBreakTable();
 
-  ecmcDataItem         *dataItem_;
-  ecmcDataItemInfo     *dataItemInfo_;
   ecmcAsynPortDriver   *asynPort_;
-  kissfft<double>*      fftDouble_;
-  double*               rawDataBuffer_;      // Input data (real)
-  double*               prepProcDataBuffer_; // Preprocessed data (real)
-  std::complex<double>* fftBufferInput_;     // Result (complex)
-  std::complex<double>* fftBufferResult_;    // Result (complex)
-  double*               fftBufferResultAmp_; // Resulting amplitude (abs of fftBufferResult_)
-  double*               fftBufferXAxis_;     // FFT x axis with freqs
-  size_t                elementsInBuffer_;
+  std::vector<ecmcFFTChannel> channels_;     // One per source (not resized after construction)
+  ecmcFFTEngine*        engine_;             // Engine of first channel (object wide readbacks)
+  uint64_t              handOverMask_;       // Channels handed over since worker was triggered (realtime)
+  uint64_t              allChannelsMask_;
   double                ecmcSampleRateHz_;
   int                   dataSourceLinked_;   // To avoid link several times
-  // ecmc callback handle for use when deregister at unload
-  int                   callbackHandle_;
-  int                   fftWaitingForCalc_;
   int                   destructs_;
+  int                   workerCreated_;      // Own worker thread created (exit with workerExitEvent_)
   int                   objectId_;           // Unique object id
-  int                   triggOnce_;
-  int                   cycleCounter_;
-  int                   ignoreCycles_;
   void                  *breakTable_;
   short                 lastBreakPoint_;
-  double                scale_;              // Config: Data set size  
-  FFT_STATUS            status_;             // Status/state  (NO_STAT, IDLE, ACQ, CALC)
 
-  // Config options
-  char*                 cfgDataSourceStr_;   // Config: data source string
+  // Config options (as parsed, runtime values in engine_)
+  char*                 cfgDataSourceStr_;   // Config: data source string (SOURCE)
+  char*                 cfgDataSourcesStr_;  // Config: data source list (SOURCES)
   char*                 cfgBreakTableStr_;   // Config: EPICS breaktable name
   int                   cfgDbgMode_;         // Config: allow dbg printouts
   int                   cfgApplyScale_;      // Config: apply scale 1/nfft
@@ -110,12 +186,30 @@ class ecmcFFT : public asynPortDriver {
   double                cfgFFTSampleRateHz_; // Config: Sample rate (defaults to ecmc rate)
   double                cfgScale_;
   double                cfgDataSampleRateHz_; // Config: Sample for data
+  double                cfgOverlap_;         // Config: Overlap between spectra in % of NFFT (CONT mode)
+  FFT_WINDOW            cfgWindow_;          // Config: Window function
+  FFT_WINDOW_CORR       cfgWindowCorr_;      // Config: Window correction (amplitude or energy)
+  FFT_AVG_MODE          cfgAvgMode_;         // Config: Averaging mode
+  int                   cfgAvgCount_;        // Config: Spectra in linear average
+  double                cfgAvgAlpha_;        // Config: Alpha of exponential average (0..1]
+  FFT_UNIT              cfgUnit_;            // Config: Unit of amplitude spectrum
+  double                cfgDbRef_;           // Config: Reference amplitude of dB unit
+  FFT_PRECISION         cfgPrecision_;       // Config: Buffers and transform in double or float
+  int                   cfgCross_;           // Config: Cross spectra of channels to first channel
+  double                cfgZoomCenter_;      // Config: Centre of zoom band [Hz]
+  double                cfgZoomSpan_;        // Config: Width of zoom band [Hz] (0 = no zoom)
+  char*                 cfgBandsStr_;        // Config: Band limits (BANDS)
+  int                   cfgPublishArrays_;   // Config: Array callbacks of results
+  int                   publishArrays_;      // Array callbacks of results (atomic)
 
   // Asyn
   int                   asynEnableId_;       // Enable/disable acq./calcs
-  int                   asynRawDataId_;      // Raw data (input) array (double)
-  int                   asynPPDataId_;       // Pre-processed data array (double)
-  int                   asynFFTAmpId_;       // FFT amplitude array (double)
+  int                   asynRawDataId_;      // Raw data (input) array (double or float)
+  int                   asynPPDataId_;       // Pre-processed data array (double or float)
+  int                   asynFFTAmpId_;       // FFT amplitude array (double or float)
+  int                   asynFFTPhaseId_;     // FFT phase array [deg] (only calculated if clients)
+  int                   asynFFTRealId_;      // FFT real part array (only calculated if clients)
+  int                   asynFFTImagId_;      // FFT imaginary part array (only calculated if clients)
   int                   asynFFTModeId_;      // FFT mode (cont/trigg)
   int                   asynFFTStatId_;      // FFT status (no_stat/idle/acq/calc)
   int                   asynSourceId_;       // SOURCE
@@ -124,9 +218,76 @@ class ecmcFFT : public asynPortDriver {
   int                   asynNfftId_;         // NFFT
   int                   asynSRateId_;        // Sample rate
   int                   asynElementsInBuffer_;  // Current buffer index
+  int                   asynWindowId_;       // Window function (enum)
+  int                   asynFFTAvgId_;       // Averaged amplitude array (double or float)
+  int                   asynAvgModeId_;      // Averaging mode (enum)
+  int                   asynUnitId_;         // Unit of amplitude (enum)
+  int                   asynDbRefId_;        // Reference amplitude of dB unit
+  int                   asynEnbwId_;         // Equivalent noise bandwidth of window [Hz]
+  int                   asynZoomCenterId_;   // Centre of zoom band
+  int                   asynZoomSpanId_;     // Width of zoom band
+  int                   asynPublishArraysId_;// Array callbacks of results on/off
+  int                   asynBandIds_[ECMC_PLUGIN_MAX_BANDS][ECMC_PLUGIN_BAND_OUTPUT_COUNT]; // Band summaries
+  int                   asynAvgCountId_;     // Spectra in linear average
+  int                   asynAvgAlphaId_;     // Alpha of exponential average
+  int                   asynAvgResetId_;     // Restart averaging
+  int                   asynAvgCounterId_;   // Spectra in current average
+  int                   asynWorkerPolicyId_; // Effective scheduling policy of worker thread
+  int                   asynWorkerPrioId_;   // Effective priority of worker thread
+  int                   asynWorkerCpusId_;   // Effective cpu affinity of worker thread
+  int                   asynRtTimeLastId_;   // Time of last realtime callback [ns]
+  int                   asynRtTimeMinId_;    // Min time of realtime callback [ns]
+  int                   asynRtTimeMaxId_;    // Max time of realtime callback [ns]
+  int                   asynRtTimeHistId_;   // Histogram of realtime callback time (array)
+  int                   asynSamplesIngestedId_; // Samples added to buffers
+  int                   asynSamplesDroppedId_;  // Samples lost
+  int                   asynSamplesIgnoredId_;  // Samples in ignored cycles
+  int                   asynRtStatResetId_;  // Reset realtime stats
+  int                   asynWorkerTimeId_;   // Time of worker stages (array) [us]
+  int                   asynWorkerTimeMaxId_;// Max time of worker stages (array) [us]
+  int                   asynSpectraRateId_;  // Spectra/s
+  int                   asynLatencyId_;      // Last sample to published [us]
+  int                   asynLatencyMaxId_;   // Max latency [us]
+  int                   asynWorkerStatResetId_; // Reset worker stats
+  int                   asynCrossAmpId_;     // Cross spectrum amplitude array (double or float)
+  int                   asynTfAmpId_;        // Transfer function amplitude array (double or float)
+  int                   asynTfPhaseId_;      // Transfer function phase array [deg] (double or float)
+  int                   asynCoherenceId_;    // Coherence array (double or float)
 
   // Thread related
   epicsEvent            doCalcEvent_;
+  epicsEvent            workerExitEvent_;    // Own worker thread done
+  epicsMutex            calcLock_;           // Only one thread calc at the time (worker pool)
+  ecmcFFTWorkerPool*    workerPool_;         // Shared worker pool (NULL if own worker thread)
+  int                   workerJobQueued_;    // Job flagged for worker pool (atomic)
+  int                   cfgPoolThreads_;     // Config: Use shared worker pool with threads (0 = own thread)
+  int                   cfgPoolPrio_;        // Config: Priority of worker pool threads
+  char*                 cfgPoolCpusStr_;     // Config: CPU affinity of worker pool threads
+  int                   cfgWorkerPolicy_;    // Config: Scheduling policy of worker thread (-1 = from prio)
+  int                   cfgWorkerPrio_;      // Config: Priority of worker thread
+  char*                 cfgWorkerCpusStr_;   // Config: CPU affinity of worker thread
+  epicsThreadId         workerThreadId_;     // Thread of last calc (for readback of effective values)
+  int                   workerPolicy_;       // Effective scheduling policy of worker thread
+  int                   workerPrio_;         // Effective priority of worker thread
+  char                  workerCpus_[ECMC_PLUGIN_MAX_CPUS_STR_LEN]; // Effective cpu affinity
+
+  // Realtime callback stats. Only written by realtime thread (read over asyn, counters wrap)
+  epicsInt32            rtTimeLast_;         // Time of last callback [ns]
+  epicsInt32            rtTimeMin_;
+  epicsInt32            rtTimeMax_;
+  epicsInt32            rtTimeHist_[ECMC_PLUGIN_RT_HIST_BINS];
+  epicsInt32            rtCallbacks_;
+  int                   rtStatsReset_;       // Reset requested over asyn (atomic)
+
+  // Worker stats (worker thread only)
+  double                workerTime_[ECMC_PLUGIN_WORKER_STAGE_COUNT];    // Last [us]
+  double                workerTimeMax_[ECMC_PLUGIN_WORKER_STAGE_COUNT]; // Max [us]
+  double                latency_;            // Last sample to published [us]
+  double                latencyMax_;
+  double                spectraRate_;        // Spectra/s (over at least 1s)
+  size_t                spectraCounter_;
+  int64_t               spectraRateStartNs_;
+  int                   workerStatsReset_;   // Reset requested over asyn (atomic)
 
 
   // Some generic utility functions
@@ -145,14 +306,11 @@ class ecmcFFT : public asynPortDriver {
                                          size_t         size,
                                          ecmcEcDataType dt,
                                          int objId);
-  static void           printComplexArray(std::complex<double>* fftBuff,
+  template<typename T>
+  static void           printComplexArray(std::complex<T>* fftBuff,
                                           size_t elements,
                                           int objId);
   static std::string    to_string(int value);
-  static int            leastSquare(int n,
-                                    const double y[],
-                                    double* k,
-                                    double* m);  // y=kx+m
 };
 
 #endif  /* ECMC_FFT_H_ */
@@ -0,0 +1,225 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTCross.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <string.h>
+#include <math.h>
+#include "ecmcFFTCross.h"
+
+template<typename T>
+ecmcFFTCross<T>::ecmcFFTCross(size_t bins) {
+  bins_       = 0;
+  avgCounter_ = 0;
+  avgReset_   = 0;
+  sumXY_      = NULL;
+  sumXX_      = NULL;
+  sumYY_      = NULL;
+  published_  = 0;
+  memset(outputs_, 0, sizeof(outputs_));
+  setBins(bins);
+}
+
+template<typename T>
+ecmcFFTCross<T>::~ecmcFFTCross() {
+  freeBuffers();
+}
+
+template<typename T>
+void ecmcFFTCross<T>::freeBuffers() {
+  delete[] sumXY_;
+  delete[] sumXX_;
+  delete[] sumYY_;
+  sumXY_ = NULL;
+  sumXX_ = NULL;
+  sumYY_ = NULL;
+  for(int i = 0; i < 2; ++i) {
+    for(int j = 0; j < ECMC_FFT_CROSS_OUTPUT_COUNT; ++j) {
+      delete[] outputs_[i][j];
+      outputs_[i][j] = NULL;
+    }
+  }
+}
+
+/** Buffers of new size (zeros), old buffers are kept if allocation fails.
+ *  Throws bad_alloc.
+*/
+template<typename T>
+void ecmcFFTCross<T>::setBins(size_t bins) {
+  if(bins == bins_) {
+    return;
+  }
+
+  std::complex<T>* sumXY = NULL;
+  T*               sumXX = NULL;
+  T*               sumYY = NULL;
+  T*               outputs[2][ECMC_FFT_CROSS_OUTPUT_COUNT];
+  memset(outputs, 0, sizeof(outputs));
+  try {
+    sumXY = new std::complex<T>[bins];
+    sumXX = new T[bins];
+    sumYY = new T[bins];
+    for(int i = 0; i < 2; ++i) {
+      for(int j = 0; j < ECMC_FFT_CROSS_OUTPUT_COUNT; ++j) {
+        outputs[i][j] = new T[bins];
+        memset(outputs[i][j], 0, bins * sizeof(T));
+      }
+    }
+  }
+  catch(std::bad_alloc& e) {
+    delete[] sumXY;
+    delete[] sumXX;
+    delete[] sumYY;
+    for(int i = 0; i < 2; ++i) {
+      for(int j = 0; j < ECMC_FFT_CROSS_OUTPUT_COUNT; ++j) {
+        delete[] outputs[i][j];
+      }
+    }
+    throw;
+  }
+
+  outputLock_.lock();
+  freeBuffers();
+  sumXY_      = sumXY;
+  sumXX_      = sumXX;
+  sumYY_      = sumYY;
+  memcpy(outputs_, outputs, sizeof(outputs_));
+  bins_       = bins;
+  published_  = 0;
+  avgCounter_ = 0;
+  outputLock_.unlock();
+}
+
+/** Add spectra of one window. Auto and cross spectra are summed (or
+ *  exponentially averaged) and the results calculated when an average
+ *  is done. Spectra with other size than the buffers are ignored (failed
+ *  NFFT change).
+*/
+template<typename T>
+int ecmcFFTCross<T>::add(const std::complex<T>* x,
+                         const std::complex<T>* y,
+                         size_t                 bins,
+                         FFT_AVG_MODE           avgMode,
+                         int                    avgCount,
+                         double                 avgAlpha) {
+  if(bins != bins_) {
+    return 0;
+  }
+
+  if(avgReset_.exchange(0)) {
+    avgCounter_ = 0;
+  }
+
+  // Start over (first spectrum, no averaging or previous linear average done)
+  if(avgCounter_ == 0 || avgMode == AVG_NONE ||
+     (avgMode == AVG_LIN && avgCounter_ >= (size_t)avgCount)) {
+    for(size_t i = 0; i < bins; ++i) {
+      sumXY_[i] = std::conj(x[i]) * y[i];
+      sumXX_[i] = std::norm(x[i]);
+      sumYY_[i] = std::norm(y[i]);
+    }
+    avgCounter_ = 1;
+  } else if(avgMode == AVG_EXP) {
+    T alpha = (T)avgAlpha;
+    for(size_t i = 0; i < bins; ++i) {
+      sumXY_[i] += (std::conj(x[i]) * y[i] - sumXY_[i]) * alpha;
+      sumXX_[i] += (std::norm(x[i]) - sumXX_[i]) * alpha;
+      sumYY_[i] += (std::norm(y[i]) - sumYY_[i]) * alpha;
+    }
+    avgCounter_++;
+  } else {
+    for(size_t i = 0; i < bins; ++i) {
+      sumXY_[i] += std::conj(x[i]) * y[i];
+      sumXX_[i] += std::norm(x[i]);
+      sumYY_[i] += std::norm(y[i]);
+    }
+    avgCounter_++;
+  }
+
+  switch(avgMode) {
+    case AVG_LIN:
+      if(avgCounter_ < (size_t)avgCount) {
+        return 0;
+      }
+      calcOutputs((T)(1.0 / (double)avgCounter_));
+      break;
+    case AVG_MAX:
+      calcOutputs((T)(1.0 / (double)avgCounter_));
+      break;
+    default:
+      calcOutputs(1);  // Exponential average (or one spectrum)
+      break;
+  }
+  return 1;
+}
+
+/** Results of sums (norm = 1/spectra in sum) into the set not published,
+ *  which is then published. The norm cancels in transfer function and
+ *  coherence.
+*/
+template<typename T>
+void ecmcFFTCross<T>::calcOutputs(T norm) {
+  T** out       = outputs_[published_ ^ 1];
+  T*  amp       = out[CROSS_AMP];
+  T*  tfAmp     = out[CROSS_TF_AMP];
+  T*  tfPhase   = out[CROSS_TF_PHASE];
+  T*  coherence = out[CROSS_COHERENCE];
+  T   radToDeg  = (T)(180.0 / M_PI);
+
+  for(size_t i = 0; i < bins_; ++i) {
+    T absXY    = std::abs(sumXY_[i]);
+    T xx       = sumXX_[i];
+    T xxyy     = xx * sumYY_[i];
+    amp[i]     = absXY * norm;
+    tfAmp[i]   = xx > 0 ? absXY / xx : 0;
+    tfPhase[i] = std::arg(sumXY_[i]) * radToDeg;  // Gxx is real
+    T coh      = xxyy > 0 ? absXY * absXY / xxyy : 0;
+    coherence[i] = coh < 1 ? coh : 1;                 // Rounding
+  }
+
+  outputLock_.lock();
+  published_ ^= 1;
+  outputLock_.unlock();
+}
+
+template<typename T>
+const T* ecmcFFTCross<T>::getOutput(FFT_CROSS_OUTPUT output) {
+  return outputs_[published_][output];
+}
+
+template<typename T>
+size_t ecmcFFTCross<T>::getBins() {
+  return bins_;
+}
+
+template<typename T>
+size_t ecmcFFTCross<T>::getAvgCounter() {
+  return avgCounter_;
+}
+
+template<typename T>
+void ecmcFFTCross<T>::resetAvg() {
+  avgReset_ = 1;
+}
+
+template<typename T>
+size_t ecmcFFTCross<T>::read(FFT_CROSS_OUTPUT output, T* dest, size_t elements) {
+  if(output < 0 || output >= ECMC_FFT_CROSS_OUTPUT_COUNT) {
+    return 0;
+  }
+  outputLock_.lock();
+  size_t ncopy = bins_ < elements ? bins_ : elements;
+  memcpy(dest, outputs_[published_][output], ncopy * sizeof(T));
+  outputLock_.unlock();
+  return ncopy;
+}
+
+template class ecmcFFTCross<double>;
+template class ecmcFFTCross<float>;
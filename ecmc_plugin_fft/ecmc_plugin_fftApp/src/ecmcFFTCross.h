@@ -0,0 +1,86 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTCross.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_CROSS_H_
+#define ECMC_FFT_CROSS_H_
+
+#include <stdexcept>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <complex>
+#include "ecmcFFTDefs.h"
+
+// Results of ecmcFFTCross (CROSS=1)
+typedef enum FFT_CROSS_OUTPUT{
+  CROSS_AMP             = 0,  // Magnitude of averaged cross spectrum |Gxy|
+  CROSS_TF_AMP          = 1,  // Magnitude of H1 transfer function |Gxy/Gxx|
+  CROSS_TF_PHASE        = 2,  // Phase of H1 transfer function [deg]
+  CROSS_COHERENCE       = 3,  // |Gxy|^2/(Gxx*Gyy) (0..1)
+} FFT_CROSS_OUTPUT;
+
+#define ECMC_FFT_CROSS_OUTPUT_COUNT 4
+
+template<typename T>
+class ecmcFFTCross {
+ public:
+
+  /** ecmc FFT cross spectrum class
+   * Cross spectrum, H1 transfer function and coherence between the spectra
+   * of a reference x (drive) and a response y. Both spectra must be of
+   * windows acquired in the same realtime cycles (same NFFT, window and
+   * scale). Auto and cross spectra are averaged as configured for the
+   * amplitude spectra:
+   *   - AVG_NONE: Each spectrum (coherence is then always 1)
+   *   - AVG_LIN:  Mean of AVG_COUNT spectra (published when done)
+   *   - AVG_EXP:  Exponential with AVG_ALPHA
+   *   - AVG_MAX:  Mean of all spectra since reset (no max hold of complex spectra)
+   * Worker calls add(), results are read from any thread with read().
+   * This object can throw:
+   *    - bad_alloc
+  */
+  ecmcFFTCross(size_t bins);
+  ~ecmcFFTCross();
+
+  // Worker thread
+  void                  setBins(size_t bins);  // New NFFT (bins = NFFT/2+1), restarts average
+  int                   add(const std::complex<T>* x,
+                            const std::complex<T>* y,
+                            size_t                 bins,
+                            FFT_AVG_MODE           avgMode,
+                            int                    avgCount,
+                            double                 avgAlpha);  // Returns 1 if new results
+  const T*              getOutput(FFT_CROSS_OUTPUT output);  // Latest results (worker)
+  size_t                getBins();
+  size_t                getAvgCounter();     // Spectra in current average
+
+  // Any thread
+  void                  resetAvg();
+  size_t                read(FFT_CROSS_OUTPUT output,
+                             T*               dest,
+                             size_t           elements);  // Returns copied elements
+
+ private:
+  void                  calcOutputs(T norm);
+  void                  freeBuffers();
+
+  size_t                bins_;
+  size_t                avgCounter_;
+  std::atomic<int>      avgReset_;
+  std::complex<T>*      sumXY_;              // Sum (or exp. average) of conj(X)*Y
+  T*                    sumXX_;              // Sum (or exp. average) of |X|^2
+  T*                    sumYY_;              // Sum (or exp. average) of |Y|^2
+  T*                    outputs_[2][ECMC_FFT_CROSS_OUTPUT_COUNT];  // Calc and published set
+  int                   published_;          // Index of published set
+  std::mutex            outputLock_;         // Protects published_ (short, never in realtime)
+};
+
+#endif  /* ECMC_FFT_CROSS_H_ */
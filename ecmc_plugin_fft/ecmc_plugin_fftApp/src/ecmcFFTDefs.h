@@ -17,6 +17,7 @@
 // Options
 #define ECMC_PLUGIN_DBG_PRINT_OPTION_CMD   "DBG_PRINT="
 #define ECMC_PLUGIN_SOURCE_OPTION_CMD      "SOURCE="
+#define ECMC_PLUGIN_SOURCES_OPTION_CMD     "SOURCES="
 #define ECMC_PLUGIN_NFFT_OPTION_CMD        "NFFT="
 //#define ECMC_PLUGIN_APPLY_SCALE_OPTION_CMD "APPLY_SCALE="
 #define ECMC_PLUGIN_RM_DC_OPTION_CMD       "RM_DC="
@@ -25,18 +26,129 @@
 #define ECMC_PLUGIN_RM_LIN_OPTION_CMD      "RM_LIN="
 #define ECMC_PLUGIN_SCALE_OPTION_CMD       "SCALE="
 #define ECMC_PLUGIN_BREAKTABLE_OPTION_CMD  "BREAKTABLE="
+#define ECMC_PLUGIN_OVERLAP_OPTION_CMD     "OVERLAP="
+#define ECMC_PLUGIN_WORKER_POOL_OPTION_CMD "WORKER_POOL="
+#define ECMC_PLUGIN_POOL_PRIO_OPTION_CMD   "POOL_PRIO="
+#define ECMC_PLUGIN_POOL_CPUS_OPTION_CMD   "POOL_CPUS="
+#define ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD "WORKER_PRIO="
+#define ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD "WORKER_CPUS="
+#define ECMC_PLUGIN_CROSS_OPTION_CMD       "CROSS="
+#define ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD "ZOOM_CENTER="
+#define ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD   "ZOOM_SPAN="
+#define ECMC_PLUGIN_BANDS_OPTION_CMD       "BANDS="
+#define ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD "PUBLISH_ARRAYS="
+
+// OTHER, FIFO, RR (scheduling policy of worker thread)
+#define ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD "WORKER_POLICY="
+#define ECMC_PLUGIN_WORKER_POLICY_OTHER_OPTION "OTHER"
+#define ECMC_PLUGIN_WORKER_POLICY_FIFO_OPTION  "FIFO"
+#define ECMC_PLUGIN_WORKER_POLICY_RR_OPTION    "RR"
 
 // CONT, TRIGG
 #define ECMC_PLUGIN_MODE_OPTION_CMD        "MODE="
 #define ECMC_PLUGIN_MODE_CONT_OPTION       "CONT"
 #define ECMC_PLUGIN_MODE_TRIGG_OPTION      "TRIGG"
 
+// NONE, HANN, HAMMING, BLACKMANHARRIS, FLATTOP
+#define ECMC_PLUGIN_WINDOW_OPTION_CMD      "WINDOW="
+#define ECMC_PLUGIN_WINDOW_NONE_OPTION     "NONE"
+#define ECMC_PLUGIN_WINDOW_HANN_OPTION     "HANN"
+#define ECMC_PLUGIN_WINDOW_HAMMING_OPTION  "HAMMING"
+#define ECMC_PLUGIN_WINDOW_BH_OPTION       "BLACKMANHARRIS"
+#define ECMC_PLUGIN_WINDOW_FLATTOP_OPTION  "FLATTOP"
+
+// AMP, ENERGY (window correction folded into scale)
+#define ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD "WINDOW_CORR="
+#define ECMC_PLUGIN_WINDOW_CORR_AMP_OPTION "AMP"
+#define ECMC_PLUGIN_WINDOW_CORR_ENERGY_OPTION "ENERGY"
+
+// NONE, LIN, EXP, MAX (averaging of amplitude spectra)
+#define ECMC_PLUGIN_AVG_MODE_OPTION_CMD    "AVG_MODE="
+#define ECMC_PLUGIN_AVG_MODE_NONE_OPTION   "NONE"
+#define ECMC_PLUGIN_AVG_MODE_LIN_OPTION    "LIN"
+#define ECMC_PLUGIN_AVG_MODE_EXP_OPTION    "EXP"
+#define ECMC_PLUGIN_AVG_MODE_MAX_OPTION    "MAX"
+#define ECMC_PLUGIN_AVG_COUNT_OPTION_CMD   "AVG_COUNT="
+#define ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD   "AVG_ALPHA="
+
+// AMP, POWER, PSD, DB (unit of amplitude spectrum and averages)
+#define ECMC_PLUGIN_UNIT_OPTION_CMD        "UNIT="
+#define ECMC_PLUGIN_UNIT_AMP_OPTION        "AMP"
+#define ECMC_PLUGIN_UNIT_POWER_OPTION      "POWER"
+#define ECMC_PLUGIN_UNIT_PSD_OPTION        "PSD"
+#define ECMC_PLUGIN_UNIT_DB_OPTION         "DB"
+#define ECMC_PLUGIN_DB_REF_OPTION_CMD      "DB_REF="
+
+// DOUBLE, FLOAT, FIXED (precision of buffers and transform)
+#define ECMC_PLUGIN_PRECISION_OPTION_CMD   "PRECISION="
+#define ECMC_PLUGIN_PRECISION_DOUBLE_OPTION "DOUBLE"
+#define ECMC_PLUGIN_PRECISION_FLOAT_OPTION "FLOAT"
+#define ECMC_PLUGIN_PRECISION_FIXED_OPTION "FIXED"
+
 typedef enum FFT_MODE{
   NO_MODE = 0,
   CONT    = 1,
   TRIGG   = 2,
 } FFT_MODE;
 
+typedef enum FFT_WINDOW{
+  WINDOW_NONE           = 0,  // Rectangular
+  WINDOW_HANN           = 1,
+  WINDOW_HAMMING        = 2,
+  WINDOW_BLACKMANHARRIS = 3,  // 4-term
+  WINDOW_FLATTOP        = 4,
+} FFT_WINDOW;
+
+#define ECMC_PLUGIN_WINDOW_COUNT 5
+
+typedef enum FFT_WINDOW_CORR{
+  WINDOW_CORR_AMP       = 0,  // Correct amplitude of sinusoids (coherent gain)
+  WINDOW_CORR_ENERGY    = 1,  // Correct energy (rms of broadband signals)
+} FFT_WINDOW_CORR;
+
+typedef enum FFT_AVG_MODE{
+  AVG_NONE              = 0,  // No averaging
+  AVG_LIN               = 1,  // Mean of AVG_COUNT spectra (published when done)
+  AVG_EXP               = 2,  // Exponential: avg += alpha*(amp-avg)
+  AVG_MAX               = 3,  // Max hold (until reset)
+} FFT_AVG_MODE;
+
+#define ECMC_PLUGIN_AVG_MODE_COUNT 4
+
+typedef enum FFT_UNIT{
+  UNIT_AMP              = 0,  // Amplitude |X| (window corrected)
+  UNIT_POWER            = 1,  // Power |X|^2
+  UNIT_PSD              = 2,  // One-sided power spectral density [unit^2/Hz] (window ENBW)
+  UNIT_DB               = 3,  // 20*log10(|X|/DB_REF)
+} FFT_UNIT;
+
+#define ECMC_PLUGIN_UNIT_COUNT 4
+
+typedef enum FFT_BAND_OUTPUT{
+  BAND_RMS              = 0,  // RMS of band (sum of PSD, independent of UNIT)
+  BAND_PEAK             = 1,  // Max of amplitude spectrum in band (configured UNIT)
+  BAND_PEAK_FREQ        = 2,  // Frequency of max [Hz]
+} FFT_BAND_OUTPUT;
+
+#define ECMC_PLUGIN_BAND_OUTPUT_COUNT 3
+
+typedef enum FFT_PRECISION{
+  PRECISION_DOUBLE      = 0,  // Buffers and transform in double
+  PRECISION_FLOAT       = 1,  // Buffers and transform in float (published as Float32Array)
+  PRECISION_FIXED       = 2,  // Integer samples, Q31 transform (published as Float32Array)
+} FFT_PRECISION;
+
+// Worker stages (index in worker time arrays)
+typedef enum FFT_WORKER_STAGE{
+  STAGE_PREPROCESS      = 0,  // Collect data (zoom mix/decimate), cached data, dc/lin removal, window
+  STAGE_TRANSFORM       = 1,  // FFT
+  STAGE_POSTPROCESS     = 2,  // Scale, unit, bands, averaging, cross spectra
+  STAGE_PUBLISH         = 3,  // Array callbacks
+  STAGE_TOTAL           = 4,
+} FFT_WORKER_STAGE;
+
+#define ECMC_PLUGIN_WORKER_STAGE_COUNT 5
+
 typedef enum FFT_STATUS{
   NO_STAT = 0,
   IDLE    = 1,  // Doing nothing, waiting for trigg
@@ -51,4 +163,67 @@ typedef enum FFT_STATUS{
 // Default size (must be n²)
 #define ECMC_PLUGIN_DEFAULT_NFFT 4096
 
+// Default overlap in percent of NFFT between spectra in CONT mode
+#define ECMC_PLUGIN_DEFAULT_OVERLAP 0.0
+
+// Default number of spectra in linear average
+#define ECMC_PLUGIN_DEFAULT_AVG_COUNT 10
+
+// Default alpha of exponential average
+#define ECMC_PLUGIN_DEFAULT_AVG_ALPHA 0.1
+
+// Default reference of dB unit (amplitude)
+#define ECMC_PLUGIN_DEFAULT_DB_REF 1.0
+
+// Zoom: decimated rate is at least span*oversampling (filter transition outside span)
+#define ECMC_PLUGIN_ZOOM_OVERSAMPLING 1.25
+
+// Zoom: length of low pass filter in samples per decimation
+#define ECMC_PLUGIN_ZOOM_TAPS_PER_DECIMATION 32
+
+// Zoom: max decimation (sample rate/(span*oversampling))
+#define ECMC_PLUGIN_ZOOM_MAX_DECIMATION 4096
+
+// Number of acquisition buffers (one hop each) shared between realtime and worker thread
+#define ECMC_PLUGIN_ACQ_BUFFER_COUNT 4
+
+// Stack size of worker threads
+#define ECMC_PLUGIN_WORKER_STACK_SIZE 32768
+
+// Max NFFT when changed at runtime
+#define ECMC_PLUGIN_MAX_NFFT 1048576
+
+// Alignment of window table (bytes)
+#define ECMC_PLUGIN_BUFFER_ALIGNMENT 64
+
+// Number of kissfft plans (twiddles) cached per FFT object (for fast NFFT change,
+// shared by all channels of the object)
+#define ECMC_PLUGIN_PLAN_CACHE_SIZE 4
+
+// Max number of result snapshots per FFT object (published, in calc and held by readers)
+#define ECMC_PLUGIN_MAX_SNAPSHOTS 8
+
+// Max number of data sources (channels) per FFT object (SOURCES, asyn addresses)
+#define ECMC_PLUGIN_MAX_CHANNELS 64
+
+// Separator of data sources in SOURCES
+#define ECMC_PLUGIN_SOURCES_SEPARATOR ','
+
+// Max number of bands (BANDS) per FFT object
+#define ECMC_PLUGIN_MAX_BANDS 16
+
+// Separator of bands in BANDS and of low and high frequency of one band
+#define ECMC_PLUGIN_BANDS_SEPARATOR ','
+#define ECMC_PLUGIN_BAND_LIMIT_SEPARATOR '-'
+
+// Max number of threads in shared worker pool
+#define ECMC_PLUGIN_MAX_POOL_THREADS 64
+
+// Max length of cpu list string of worker thread (asyn readback)
+#define ECMC_PLUGIN_MAX_CPUS_STR_LEN 256
+
+// Bins in histogram of realtime callback time. Bin 0 < 1us, bin i = [2^(i-1),2^i) us,
+// last bin also holds all longer times
+#define ECMC_PLUGIN_RT_HIST_BINS 16
+
 #endif  /* ECMC_FFT_DEFS_H_ */
@@ -0,0 +1,1954 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTEngine.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include <limits>
+#include <string>
+#include "ecmcFFTEngine.h"
+
+/** Block converter: convert elements of type R to S, scale and accumulate
+ *  stats (j = firstIndex..). Unaligned source is read with memcpy.
+ *  One tight loop without branches so it can be vectorized.
+*/
+template<typename R, typename S>
+static void convertBlock(const uint8_t* src,
+                         size_t         elements,
+                         double         scale,
+                         S*             dest,
+                         size_t         firstIndex,
+                         double*        sumY,
+                         double*        sumJY) {
+  double sy  = 0;
+  double sjy = 0;
+  for(size_t i = 0; i < elements; ++i) {
+    R raw;
+    memcpy(&raw, src + i * sizeof(R), sizeof(R));
+    S y      = (S)((double)raw * scale);
+    dest[i]  = y;
+    sy      += y;
+    sjy     += (double)(firstIndex + i) * y;
+  }
+  *sumY  += sy;
+  *sumJY += sjy;
+}
+
+/** Block converter for PRECISION=FIXED: native integer samples are copied
+ *  (scale is applied to the output bins) and stats are in raw counts.
+*/
+template<typename R>
+static void convertBlockFixed(const uint8_t* src,
+                              size_t         elements,
+                              double         /*scale*/,
+                              int32_t*       dest,
+                              size_t         firstIndex,
+                              double*        sumY,
+                              double*        sumJY) {
+  int64_t sy  = 0;
+  double  sjy = 0;
+  for(size_t i = 0; i < elements; ++i) {
+    R raw;
+    memcpy(&raw, src + i * sizeof(R), sizeof(R));
+    int32_t y = (int32_t)raw;
+    dest[i]   = y;
+    sy       += y;
+    sjy      += (double)(firstIndex + i) * y;
+  }
+  *sumY  += (double)sy;
+  *sumJY += sjy;
+}
+
+// Window coefficient in sample type (Q31 for PRECISION=FIXED)
+template<typename S>
+static inline S windowCoeff(double w) {
+  return (S)w;
+}
+
+template<>
+inline int32_t windowCoeff<int32_t>(double w) {
+  return (int32_t)floor(0.5 + w * ECMC_FFT_FIXED_ONE);
+}
+
+/** ecmc FFT engine base class
+ * This object can throw:
+ *    - out_of_range
+*/
+ecmcFFTEngine::ecmcFFTEngine(size_t nfft, double overlap) {
+  avgCounter_         = 0;
+  avgReset_           = 0;
+  windowCorr_         = 1.0;
+  windowEnbw_         = 1.0;
+  windowSumSq_        = 1.0;
+  unit_               = UNIT_AMP;
+  unitScale_          = 1.0;
+  bandScale_          = 1.0;
+  bandCount_          = 0;
+  for(size_t i = 0; i < ECMC_PLUGIN_MAX_BANDS; ++i) {
+    cfgBandLow_[i]    = 0;
+    cfgBandHigh_[i]   = 0;
+    bandFirstBin_[i]  = 0;
+    bandEndBin_[i]    = 0;
+    for(size_t j = 0; j < ECMC_PLUGIN_BAND_OUTPUT_COUNT; ++j) {
+      bandValues_[i][j] = 0;
+    }
+  }
+  ringSize_           = 0;
+  ringWriteIndex_     = 0;
+  ringElements_       = 0;
+  blockStats_         = NULL;
+  blockStatsSize_     = 0;
+  blockStatsFirst_    = 0;
+  blockStatsCount_    = 0;
+  blockStatsElements_ = 0;
+  hopSize_            = 0;
+  acqSequence_        = 0;
+  workerSequence_     = 0;
+  acqRestart_         = 1;
+  acqReset_           = 0;
+  nfftCapacity_       = 0;
+  acqCapacity_        = 0;
+  nfftRequest_        = 0;
+  elementsInBuffer_   = 0;
+  fftWaitingForCalc_  = 0;
+  triggOnce_          = 0;
+  cycleCounter_       = 0;
+  ignoreCycles_       = 0;
+  convertType_        = SAMPLE_NONE;
+  rawConvertDummySum_ = 0;
+  scale_              = 1.0;
+  cachedDataInvalid_  = 1;
+  status_             = NO_STAT;
+  lastSampleNs_       = 0;
+  samplesIngested_    = 0;
+  samplesDropped_     = 0;
+  samplesIgnored_     = 0;
+
+  // Config defaults
+  cfgNfft_            = nfft;
+  cfgOverlap_         = overlap;
+  cfgDcRemove_        = 0;
+  cfgLinRemove_       = 0;
+  cfgEnable_          = 0;
+  cfgMode_            = TRIGG;
+  cfgOutputs_         = 0;
+  cfgScale_           = 1.0;
+  cfgDataSampleRateHz_= 1.0;
+  cfgWindow_          = WINDOW_NONE;
+  cfgWindowCorr_      = WINDOW_CORR_AMP;
+  cfgAvgMode_         = AVG_NONE;
+  cfgAvgCount_        = ECMC_PLUGIN_DEFAULT_AVG_COUNT;
+  cfgAvgAlpha_        = ECMC_PLUGIN_DEFAULT_AVG_ALPHA;
+  cfgUnit_            = UNIT_AMP;
+  cfgDbRef_           = ECMC_PLUGIN_DEFAULT_DB_REF;
+  cfgZoomCenter_      = 0;
+  cfgZoomSpan_        = 0;
+  zoomInvalid_        = 0;
+  zoomBins_           = 0;
+  zoomRate_           = 0;
+  zoomFirstFreq_      = 0;
+
+  // Check valid nfft
+  if(cfgNfft_ <= 0 || cfgNfft_ > ECMC_PLUGIN_MAX_NFFT) {
+    throw std::out_of_range("NFFT must be > 0 and <= " + std::to_string(ECMC_PLUGIN_MAX_NFFT) + ".");
+  }
+  // Real input transform is made as a complex transform of size NFFT/2
+  if(cfgNfft_ % 2) {
+    throw std::out_of_range("NFFT must be even.");
+  }
+
+  // Check valid overlap
+  if(cfgOverlap_ < 0 || cfgOverlap_ >= 100) {
+    throw std::out_of_range("OVERLAP must be >= 0% and < 100%.");
+  }
+
+  // Samples between spectra in CONT mode (at least one sample)
+  hopSize_  = getHopSize(cfgNfft_);
+  ringSize_ = cfgNfft_;
+}
+
+ecmcFFTEngine::~ecmcFFTEngine() {
+  delete[] blockStats_;
+}
+
+template<typename S>
+ecmcFFTPlanCache<S>::ecmcFFTPlanCache() {
+  counter_ = 0;
+  for(int i = 0; i < ECMC_PLUGIN_PLAN_CACHE_SIZE; ++i) {
+    plans_[i].plan     = NULL;
+    plans_[i].nfft     = 0;
+    plans_[i].lastUsed = 0;
+  }
+}
+
+template<typename S>
+ecmcFFTPlanCache<S>::~ecmcFFTPlanCache() {
+  for(int i = 0; i < ECMC_PLUGIN_PLAN_CACHE_SIZE; ++i) {
+    delete plans_[i].plan;
+    plans_[i].plan = NULL;
+  }
+}
+
+/** Get transform plan for nfft from cache (created if not in cache).
+ *  The least recently used plan is replaced if cache is full.
+ *  Throws bad_alloc.
+*/
+template<typename S>
+typename ecmcFFTTransform<S>::type* ecmcFFTPlanCache<S>::getPlan(size_t nfft) {
+  int lru = 0;
+  counter_++;
+  for(int i = 0; i < ECMC_PLUGIN_PLAN_CACHE_SIZE; ++i) {
+    if(plans_[i].plan && plans_[i].nfft == nfft) {
+      plans_[i].lastUsed = counter_;
+      return plans_[i].plan;
+    }
+    if(!plans_[i].plan) {
+      lru = i;
+      plans_[i].lastUsed = 0;  // Use free slot first
+    } else if(plans_[i].lastUsed < plans_[lru].lastUsed) {
+      lru = i;
+    }
+  }
+
+  // Real input of size NFFT is transformed as NFFT/2 complex
+  typename ecmcFFTTransform<S>::type* plan =
+      new typename ecmcFFTTransform<S>::type(nfft / 2, false);
+  if(plans_[lru].plan) {
+    delete plans_[lru].plan;
+  }
+  plans_[lru].plan     = plan;
+  plans_[lru].nfft     = nfft;
+  plans_[lru].lastUsed = counter_;
+  return plan;
+}
+
+/** ecmc FFT engine with buffers and transform of type T
+ * This object can throw:
+ *    - bad_alloc
+ *    - out_of_range
+*/
+template<typename T, typename S>
+ecmcFFTEngineT<T, S>::ecmcFFTEngineT(size_t nfft,
+                                     double overlap,
+                                     ecmcFFTPlanCache<S>* planCache)
+                                     : ecmcFFTEngine(nfft, overlap) {
+  fft_                = NULL;
+  zoom_               = NULL;
+  planCache_          = planCache;
+  ownPlanCache_       = 0;
+  for(int i = 0; i < ECMC_PLUGIN_MAX_SNAPSHOTS; ++i) {
+    snapshots_[i]     = NULL;
+  }
+  calcSnapshot_       = NULL;
+  avgSnapshot_        = NULL;
+  publishedSnapshot_  = NULL;
+  publishedAvgSnapshot_ = NULL;
+  fftBufferXAxis_     = NULL;
+  ringBuffer_         = NULL;
+  windowBuffer_       = NULL;
+  fftInput_           = NULL;
+  fixedShift_         = 0;
+  for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+    acqBuffers_[i].data       = NULL;
+    acqBuffers_[i].elements   = 0;
+    acqBuffers_[i].sequence   = 0;
+    acqBuffers_[i].restart    = 0;
+    acqBuffers_[i].state      = ECMC_FFT_ACQ_BUFF_FREE;
+    acqBuffers_[i].sumY       = 0;
+    acqBuffers_[i].sumJY      = 0;
+    acqBuffers_[i].handOverNs = 0;
+  }
+  acqBuffer_          = NULL;
+  convertFunc_        = NULL;
+  rawConvertFunc_     = NULL;
+  rawConvertData_     = NULL;
+
+  try {
+    if(!planCache_) {
+      planCache_    = new ecmcFFTPlanCache<S>();
+      ownPlanCache_ = 1;
+    }
+
+    // Allocate buffers (and acquisition buffer pool)
+    allocBuffers(cfgNfft_, hopSize_);
+
+    // Transform plan (real input of size NFFT is transformed as NFFT/2 complex)
+    fft_ = planCache_->getPlan(cfgNfft_);
+
+    // Readers get zeros until first spectrum
+    publishEmptySnapshot();
+  }
+  catch(std::bad_alloc& e) {
+    freeBuffers();
+    if(ownPlanCache_) {
+      delete planCache_;
+    }
+    throw;
+  }
+
+  calcFFTXAxis();  // Initial values (rate of data source set later)
+}
+
+template<typename T, typename S>
+ecmcFFTEngineT<T, S>::~ecmcFFTEngineT() {
+  freeBuffers();
+  delete zoom_;
+  if(ownPlanCache_) {
+    delete planCache_;
+  }
+}
+
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::freeBuffers() {
+  delete[] fftBufferXAxis_;
+  delete[] ringBuffer_;
+  free(windowBuffer_);
+  delete[] fftInput_;
+  fftBufferXAxis_     = NULL;
+  ringBuffer_         = NULL;
+  windowBuffer_       = NULL;
+  fftInput_           = NULL;
+
+  for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+    delete[] acqBuffers_[i].data;
+    acqBuffers_[i].data = NULL;
+  }
+
+  for(int i = 0; i < ECMC_PLUGIN_MAX_SNAPSHOTS; ++i) {
+    if(snapshots_[i]) {
+      delete[] snapshots_[i]->rawData;
+      delete[] snapshots_[i]->prepProcData;
+      delete[] snapshots_[i]->result;
+      delete[] snapshots_[i]->amp;
+      delete[] snapshots_[i]->avg;
+      delete[] snapshots_[i]->phase;
+      delete[] snapshots_[i]->real;
+      delete[] snapshots_[i]->imag;
+      delete snapshots_[i];
+      snapshots_[i] = NULL;
+    }
+  }
+  calcSnapshot_         = NULL;
+  avgSnapshot_          = NULL;
+  publishedSnapshot_    = NULL;
+  publishedAvgSnapshot_ = NULL;
+  fft_                  = NULL;  // Plans deleted with cache
+}
+
+void ecmcFFTEngine::setOutputs(int outputs) {
+  cfgOutputs_ = outputs;
+}
+
+int ecmcFFTEngine::getOutputs() {
+  return cfgOutputs_;
+}
+
+void ecmcFFTEngine::setEnable(int enable) {
+  cfgEnable_ = enable;
+}
+
+int ecmcFFTEngine::getEnable() {
+  return cfgEnable_;
+}
+
+void ecmcFFTEngine::setMode(FFT_MODE mode) {
+  if(cfgZoomSpan_ > 0 && mode != CONT) {
+    throw std::out_of_range("ZOOM needs MODE=CONT.");
+  }
+  if(mode != (FFT_MODE)cfgMode_.load()) {
+    // Buffers are used differently in CONT and TRIGG mode so start over
+    clearBuffers();
+  }
+  cfgMode_ = mode;
+}
+
+FFT_MODE ecmcFFTEngine::getMode() {
+  return (FFT_MODE)cfgMode_.load();
+}
+
+void ecmcFFTEngine::setScale(double scale) {
+  cfgScale_ = scale;
+}
+
+void ecmcFFTEngine::setDcRemove(int remove) {
+  cfgDcRemove_ = remove;
+}
+
+void ecmcFFTEngine::setLinRemove(int remove) {
+  cfgLinRemove_ = remove;
+}
+
+void ecmcFFTEngine::setWindow(FFT_WINDOW window) {
+  if(window < 0 || window >= ECMC_PLUGIN_WINDOW_COUNT) {
+    throw std::out_of_range("Invalid window.");
+  }
+  cfgWindow_ = window;
+  cachedDataInvalid_ = 1;  // New window table and scale
+}
+
+FFT_WINDOW ecmcFFTEngine::getWindow() {
+  return cfgWindow_;
+}
+
+void ecmcFFTEngine::setWindowCorr(FFT_WINDOW_CORR corr) {
+  cfgWindowCorr_ = corr;
+  cachedDataInvalid_ = 1;
+}
+
+void ecmcFFTEngine::setUnit(FFT_UNIT unit) {
+  if(unit < 0 || unit >= ECMC_PLUGIN_UNIT_COUNT) {
+    throw std::out_of_range("Invalid unit.");
+  }
+  cfgUnit_ = unit;
+  cachedDataInvalid_ = 1;  // New unit scale (restarts averaging)
+}
+
+FFT_UNIT ecmcFFTEngine::getUnit() {
+  return cfgUnit_;
+}
+
+void ecmcFFTEngine::setDbRef(double ref) {
+  if(ref <= 0) {
+    throw std::out_of_range("DB_REF must be > 0.");
+  }
+  cfgDbRef_ = ref;
+  cachedDataInvalid_ = 1;
+}
+
+double ecmcFFTEngine::getDbRef() {
+  return cfgDbRef_;
+}
+
+double ecmcFFTEngine::getEnbw() {
+  return windowEnbw_ * getSpectrumRate() / (double)cfgNfft_;
+}
+
+/** Band must be inside 0..fs/2 and give a decimation that is not too large.
+ *  Only the lower limit is checked if the rate is not known yet (0, the rate
+ *  of an oversampled source is set at connect). Throws out_of_range.
+*/
+void ecmcFFTEngine::checkZoom(double centerHz, double spanHz, double sampleRateHz) {
+  if(spanHz <= 0) {
+    throw std::out_of_range("ZOOM_SPAN must be > 0.");
+  }
+  if(centerHz - spanHz / 2 < 0) {
+    throw std::out_of_range("Zoom band (ZOOM_CENTER +- ZOOM_SPAN/2) must be within 0..samplerate/2.");
+  }
+  if(sampleRateHz <= 0) {
+    return;
+  }
+  if(centerHz + spanHz / 2 > sampleRateHz / 2) {
+    throw std::out_of_range("Zoom band (ZOOM_CENTER +- ZOOM_SPAN/2) must be within 0..samplerate/2.");
+  }
+  if(ecmcFFTZoom<double>::getDecimation(sampleRateHz, spanHz) > ECMC_PLUGIN_ZOOM_MAX_DECIMATION) {
+    throw std::out_of_range("ZOOM_SPAN too small for sample rate (max decimation exceeded).");
+  }
+}
+
+int ecmcFFTEngine::getZoom() {
+  return cfgZoomSpan_ > 0;
+}
+
+double ecmcFFTEngine::getZoomCenter() {
+  return cfgZoomCenter_;
+}
+
+double ecmcFFTEngine::getZoomSpan() {
+  return cfgZoomSpan_;
+}
+
+double ecmcFFTEngine::getSpectrumRate() {
+  return zoomBins_ ? zoomRate_ : cfgDataSampleRateHz_;
+}
+
+/** Bands [lowHz, highHz] summarized for each spectrum (see calcBands()).
+ *  Bands outside the spectrum (or zoom band) give 0. Throws out_of_range.
+*/
+void ecmcFFTEngine::setBands(const double* lowHz, const double* highHz, size_t count) {
+  if(count > ECMC_PLUGIN_MAX_BANDS) {
+    throw std::out_of_range("Too many bands in BANDS.");
+  }
+  for(size_t i = 0; i < count; ++i) {
+    if(lowHz[i] < 0 || highHz[i] <= lowHz[i]) {
+      throw std::out_of_range("Band must be low-high with 0 <= low < high [Hz].");
+    }
+  }
+  for(size_t i = 0; i < count; ++i) {
+    cfgBandLow_[i]  = lowHz[i];
+    cfgBandHigh_[i] = highHz[i];
+  }
+  bandCount_         = count;
+  cachedDataInvalid_ = 1;
+}
+
+size_t ecmcFFTEngine::getBandCount() {
+  return bandCount_;
+}
+
+double ecmcFFTEngine::getBandValue(size_t band, FFT_BAND_OUTPUT output) {
+  if(band >= bandCount_ || output < 0 || output >= ECMC_PLUGIN_BAND_OUTPUT_COUNT) {
+    return 0;
+  }
+  return bandValues_[band][output].load(std::memory_order_relaxed);
+}
+
+void ecmcFFTEngine::setAvgMode(FFT_AVG_MODE mode) {
+  if(mode < 0 || mode >= ECMC_PLUGIN_AVG_MODE_COUNT) {
+    throw std::out_of_range("Invalid averaging mode.");
+  }
+  cfgAvgMode_ = mode;
+  resetAvg();
+}
+
+FFT_AVG_MODE ecmcFFTEngine::getAvgMode() {
+  return cfgAvgMode_;
+}
+
+void ecmcFFTEngine::setAvgCount(int count) {
+  if(count < 1) {
+    throw std::out_of_range("AVG_COUNT must be > 0.");
+  }
+  cfgAvgCount_ = count;
+  resetAvg();
+}
+
+int ecmcFFTEngine::getAvgCount() {
+  return cfgAvgCount_;
+}
+
+void ecmcFFTEngine::setAvgAlpha(double alpha) {
+  if(alpha <= 0 || alpha > 1) {
+    throw std::out_of_range("AVG_ALPHA must be > 0 and <= 1.");
+  }
+  cfgAvgAlpha_ = alpha;
+}
+
+double ecmcFFTEngine::getAvgAlpha() {
+  return cfgAvgAlpha_;
+}
+
+// Restart averaging with next spectrum
+void ecmcFFTEngine::resetAvg() {
+  avgReset_ = 1;
+}
+
+void ecmcFFTEngine::setSampleRate(double sampleRateHz) {
+  if(sampleRateHz <= 0) {
+    throw std::out_of_range("FFT Invalid sample rate");
+  }
+  if(cfgZoomSpan_ > 0) {
+    checkZoom(cfgZoomCenter_, cfgZoomSpan_, sampleRateHz);
+    zoomInvalid_ = 1;
+  }
+  cfgDataSampleRateHz_ = sampleRateHz;
+  cachedDataInvalid_   = 1;  // New rate, x-axis needs update
+}
+
+double ecmcFFTEngine::getSampleRate() {
+  return cfgDataSampleRateHz_;
+}
+
+void ecmcFFTEngine::setIgnoreCycles(int cycles) {
+  ignoreCycles_ = cycles;
+}
+
+// Resolve converter once for the data type of the source
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::setSampleType(FFT_SAMPLE_TYPE type) {
+  convertType_ = type;
+  convertFunc_ = getConvertFunc(type);
+  // PRECISION=FIXED: samples in Q31 with headroom for DC/linear removal
+  fixedShift_  = 30 - 8 * (int)getSampleTypeByteSize(type);
+}
+
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::setRawConvert(RawConvertFunc func, void* userData) {
+  rawConvertFunc_ = func;
+  rawConvertData_ = userData;
+}
+
+/** Change NFFT. Validated here and applied by the worker before next calc.
+ *  Throws out_of_range.
+*/
+void ecmcFFTEngine::setNfft(size_t nfft) {
+  if(nfft <= 0 || nfft > ECMC_PLUGIN_MAX_NFFT) {
+    throw std::out_of_range("NFFT must be > 0 and <= " + std::to_string(ECMC_PLUGIN_MAX_NFFT) + ".");
+  }
+  if(nfft % 2) {
+    throw std::out_of_range("NFFT must be even.");
+  }
+  nfftRequest_ = nfft;
+}
+
+size_t ecmcFFTEngine::getNfftRequest() {
+  return nfftRequest_;
+}
+
+void ecmcFFTEngine::setStatus(FFT_STATUS status) {
+  status_ = status;
+}
+
+FFT_STATUS ecmcFFTEngine::getStatus() {
+  return (FFT_STATUS)status_.load();
+}
+
+// Restart acquisition (handled in realtime thread and then by worker)
+void ecmcFFTEngine::clearBuffers() {
+  acqReset_ = 1;
+}
+
+void ecmcFFTEngine::setTrigg(int trigg) {
+  triggOnce_ = trigg;
+}
+
+int ecmcFFTEngine::getTrigg() {
+  return triggOnce_;
+}
+
+/** Called from realtime thread. Convert samples into acquisition buffers and
+ *  hand over full buffers to worker. Skips the data (never blocks) if the
+ *  worker is reallocating buffers (NFFT change).
+*/
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::acquire(const uint8_t*  data,
+                                  size_t          elements,
+                                  FFT_SAMPLE_TYPE type,
+                                  int64_t         timeNs) {
+
+  if(!reallocLock_.try_lock()) {
+    addDroppedSamples(elements);
+    return 0;
+  }
+
+  // Restart of acquisition requested (clearBuffers())
+  if(acqReset_.load()) {
+    acqReset_ = 0;
+    if(acqBuffer_) {
+      acqBuffer_->elements = 0;
+      acqBuffer_->sumY     = 0;
+      acqBuffer_->sumJY    = 0;
+    }
+    elementsInBuffer_ = 0;
+    acqRestart_       = 1;
+  }
+
+  FFT_MODE mode = (FFT_MODE)cfgMode_.load();
+
+  // In TRIGG mode wait for calc to finish. In CONT mode acq. continues during calc
+  if(fftWaitingForCalc_.load() && mode != CONT) {
+    addDroppedSamples(elements);
+    reallocLock_.unlock();
+    return 0;
+  }
+  // No buffer or full or not enabled
+  if(!ringBuffer_ || !cfgEnable_.load()) {
+    reallocLock_.unlock();
+    return 0;
+  }
+
+  // See if data should be ignored
+  if(cycleCounter_ < ignoreCycles_) {
+    cycleCounter_++;
+    addSampleCount(&samplesIgnored_, elements);
+    reallocLock_.unlock();
+    return 0; // ignore this callback
+  }
+
+  cycleCounter_ = 0;
+
+  if (mode == TRIGG && !triggOnce_.load()) {
+    status_ = IDLE;
+    reallocLock_.unlock();
+    return ECMC_FFT_ACQ_STATUS_UPDATED; // Wait for trigger from plc or asyn
+  }
+
+  status_ = ACQ;
+
+  // Converter (and Q31 shift of FIXED) resolved at setSampleType() (data type of
+  // source is fixed). Other types can not be converted correctly
+  ConvertFunc convert = convertFunc_;
+  if(!convert || type != convertType_) {
+    addDroppedSamples(elements);
+    reallocLock_.unlock();
+    return ECMC_FFT_ACQ_STATUS_UPDATED;
+  }
+  size_t elementSize = getSampleTypeByteSize(type);
+
+  // Triggered window is handed over at once (OVERLAP only in CONT mode)
+  size_t hopSize = mode == CONT ? hopSize_ : cfgNfft_;
+
+  // Convert in blocks directly into the acquisition buffer(s)
+  const uint8_t *pData     = data;
+  int            handedOver = 0;
+  while(elements > 0) {
+    // Triggered acq. done
+    if(mode != CONT && elementsInBuffer_ >= cfgNfft_) {
+      break;
+    }
+
+    if(!acqBuffer_) {
+      acqBuffer_ = getFreeAcqBuffer();
+      if(!acqBuffer_) {
+        // Worker can not keep up, all buffers in use. History needs to restart
+        acqRestart_ = 1;
+        break;
+      }
+    }
+
+    // Fill up to one hop (or to NFFT in triggered mode). Buffer can be longer
+    // than hop if mode just changed (restart of acq. pending)
+    size_t block = acqBuffer_->elements < hopSize ? hopSize - acqBuffer_->elements : 0;
+    if(mode != CONT && cfgNfft_ - elementsInBuffer_ < block) {
+      block = cfgNfft_ - elementsInBuffer_;
+    }
+    if(block > elements) {
+      block = elements;
+    }
+
+    S *dest = &acqBuffer_->data[acqBuffer_->elements];
+    if(rawConvertFunc_) {
+      convert(pData, block, 1.0, dest, 0, &rawConvertDummySum_, &rawConvertDummySum_);
+      rawConvertFunc_(rawConvertData_, dest, block);
+      scaleBlock(dest, block, acqBuffer_->elements);
+    } else {
+      convert(pData, block, cfgScale_, dest, acqBuffer_->elements,
+              &acqBuffer_->sumY, &acqBuffer_->sumJY);
+    }
+    acqBuffer_->elements += block;
+    elementsInBuffer_    += block;
+    if(elementsInBuffer_ > cfgNfft_) {
+      elementsInBuffer_ = cfgNfft_;
+    }
+    pData    += block * elementSize;
+    elements -= block;
+    addSampleCount(&samplesIngested_, block);
+
+    // One hop acquired (or triggered acq. done) => hand over to worker
+    int triggDone = mode != CONT && elementsInBuffer_ >= cfgNfft_;
+    if(acqBuffer_->elements >= hopSize || triggDone) {
+      if(triggDone) {
+        // Set before hand over, an awake worker can consume the window (and clear the flag) at once
+        status_            = CALC;
+        fftWaitingForCalc_ = 1;
+        triggOnce_         = 0;
+      }
+      handOverAcqBuffer(timeNs);
+      handedOver = 1;
+    }
+  }
+
+  // Not fitted in buffers (no free buffer or triggered acq. done)
+  addDroppedSamples(elements);
+
+  int flags = ECMC_FFT_ACQ_STATUS_UPDATED;
+  // Data handed over to worker
+  if(handedOver) {
+    if(mode != CONT && elementsInBuffer_ >= cfgNfft_) {
+      // Triggered acq. done, start over at next trigger
+      elementsInBuffer_ = 0;
+      acqRestart_       = 1;
+    }
+    flags |= ECMC_FFT_ACQ_HANDED_OVER; // let worker start
+  }
+  reallocLock_.unlock();
+  return flags;
+}
+
+/** Scale converted data (in place) and accumulate stats. Used after the raw
+ *  conversion hook (stats must be of the converted data).
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::scaleBlock(S* data, size_t elements, size_t firstIndex) {
+  double sumY  = 0;
+  double sumJY = 0;
+  for(size_t i = 0; i < elements; ++i) {
+    S y      = (S)(data[i] * cfgScale_);
+    data[i]  = y;
+    sumY    += y;
+    sumJY   += (double)(firstIndex + i) * y;
+  }
+  acqBuffer_->sumY  += sumY;
+  acqBuffer_->sumJY += sumJY;
+}
+
+// Hand over the current acquisition buffer to worker and take next free
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::handOverAcqBuffer(int64_t timeNs) {
+  acqBuffer_->sequence   = acqSequence_;
+  acqBuffer_->restart    = acqRestart_;
+  acqBuffer_->handOverNs = timeNs;
+  acqSequence_++;
+  acqRestart_            = 0;
+  // Release store makes sure the data is visible to worker before the state
+  acqBuffer_->state.store(ECMC_FFT_ACQ_BUFF_FULL, std::memory_order_release);
+  acqBuffer_             = getFreeAcqBuffer();
+}
+
+void ecmcFFTEngine::addDroppedSamples(size_t elements) {
+  addSampleCount(&samplesDropped_, elements);
+}
+
+// Called from realtime thread (only writer of the counters)
+void ecmcFFTEngine::resetSampleCounters() {
+  samplesIngested_ = 0;
+  samplesDropped_  = 0;
+  samplesIgnored_  = 0;
+}
+
+int32_t ecmcFFTEngine::getSamplesIngested() {
+  return samplesIngested_.load(std::memory_order_relaxed);
+}
+
+int32_t ecmcFFTEngine::getSamplesDropped() {
+  return samplesDropped_.load(std::memory_order_relaxed);
+}
+
+int32_t ecmcFFTEngine::getSamplesIgnored() {
+  return samplesIgnored_.load(std::memory_order_relaxed);
+}
+
+size_t ecmcFFTEngine::getElementsInBuffer() {
+  return elementsInBuffer_;
+}
+
+// Add to wrapping sample counter (single writer)
+void ecmcFFTEngine::addSampleCount(std::atomic<int32_t>* counter, size_t samples) {
+  uint32_t value = (uint32_t)counter->load(std::memory_order_relaxed) + (uint32_t)samples;
+  counter->store((int32_t)value, std::memory_order_relaxed);
+}
+
+// Samples between spectra in CONT mode (at least one sample)
+size_t ecmcFFTEngine::getHopSize(size_t nfft) {
+  size_t hopSize = nfft - (size_t)((double)nfft * cfgOverlap_ / 100.0 + 0.5);
+  if(hopSize < 1) {
+    hopSize = 1;
+  }
+  return hopSize;
+}
+
+/** Make sure buffers can hold nfft samples (acquisition buffers too, a
+ *  triggered window is one buffer) and stats hops of hopSize samples. Buffers only grow (lazy), so switching back to a smaller NFFT is free.
+ *  Not allowed while the realtime thread or worker use the buffers.
+ *  Throws bad_alloc (old buffers are then left untouched).
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::allocBuffers(size_t nfft, size_t hopSize) {
+  if(nfft > nfftCapacity_) {
+    T*                    xAxis    = NULL;
+    S*                    ring     = NULL;
+    void*                 window   = NULL;
+    S*                    input    = NULL;
+    try {
+      xAxis    = new T[getBinCapacity(nfft)];           // FFT x axis with freqs
+      ring     = new S[nfft];                           // Window history (worker)
+      // Window coefficients aligned for vectorized multiply
+      if(posix_memalign(&window, ECMC_PLUGIN_BUFFER_ALIGNMENT, nfft * sizeof(S))) {
+        window = NULL;
+        throw std::bad_alloc();
+      }
+      if(!std::is_same<T, S>::value) {
+        input  = new S[nfft];                           // Transform input (fixed point)
+      }
+    }
+    catch(std::bad_alloc& e) {
+      delete[] xAxis;
+      delete[] ring;
+      free(window);
+      delete[] input;
+      throw;
+    }
+    delete[] fftBufferXAxis_;
+    delete[] ringBuffer_;
+    free(windowBuffer_);
+    delete[] fftInput_;
+    fftBufferXAxis_     = xAxis;
+    ringBuffer_         = ring;
+    windowBuffer_       = (S*)window;
+    fftInput_           = input;
+    nfftCapacity_       = nfft;
+  }
+
+  // Stats of the buffers that can be in the ring at the same time
+  size_t blockStatsSize = nfft / hopSize + 2;
+  if(blockStatsSize > blockStatsSize_) {
+    ecmcFFTBlockStats* blockStats = new ecmcFFTBlockStats[blockStatsSize];
+    delete[] blockStats_;
+    blockStats_     = blockStats;
+    blockStatsSize_ = blockStatsSize;
+  }
+  blockStatsFirst_    = 0;
+  blockStatsCount_    = 0;
+  blockStatsElements_ = 0;
+
+  if(nfft > acqCapacity_) {
+    S* data[ECMC_PLUGIN_ACQ_BUFFER_COUNT];
+    memset(data, 0, sizeof(data));
+    try {
+      for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+        data[i] = new S[nfft];
+      }
+    }
+    catch(std::bad_alloc& e) {
+      for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+        delete[] data[i];
+      }
+      throw;
+    }
+    for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+      delete[] acqBuffers_[i].data;
+      acqBuffers_[i].data = data[i];
+    }
+    acqCapacity_ = nfft;
+  }
+
+  memset(fftBufferXAxis_, 0, getBinCapacity(nfft) * sizeof(T));
+  avgCounter_ = 0;
+  memset(ringBuffer_, 0, nfft * sizeof(S));
+  for(unsigned int i = 0; i < nfft; ++i) {
+    windowBuffer_[i] = windowCoeff<S>(1.0);  // Calculated by worker (calcWindow())
+  }
+
+  // Acquisition buffer pool (filled in realtime, one hop per buffer)
+  for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+    acqBuffers_[i].elements = 0;
+    acqBuffers_[i].sumY     = 0;
+    acqBuffers_[i].sumJY    = 0;
+    acqBuffers_[i].state    = ECMC_FFT_ACQ_BUFF_FREE;
+  }
+}
+
+// Zoom bins are within NFFT (complex transform), else NFFT/2+1
+template<typename T, typename S>
+size_t ecmcFFTEngineT<T, S>::getBinCapacity(size_t nfft) {
+  return zoom_ ? nfft : nfft / 2 + 1;
+}
+
+/** Enable zoom FFT at config (before data is added), or change band (any
+ *  thread, applied by worker). Throws out_of_range and bad_alloc.
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::setZoom(double centerHz, double spanHz) {
+  checkZoom(centerHz, spanHz, zoom_ ? cfgDataSampleRateHz_ : 0);  // Rate checked at setSampleRate()
+  if(cfgMode_ != CONT) {
+    throw std::out_of_range("ZOOM needs MODE=CONT.");
+  }
+  if(!zoom_) {
+    // Bins of x-axis (and snapshots) up to NFFT
+    T* xAxis = new T[nfftCapacity_];
+    zoom_    = new ecmcFFTZoom<T>();
+    memset(xAxis, 0, nfftCapacity_ * sizeof(T));
+    delete[] fftBufferXAxis_;
+    fftBufferXAxis_ = xAxis;
+  }
+  cfgZoomCenter_     = centerHz;
+  cfgZoomSpan_       = spanHz;
+  zoomInvalid_       = 1;
+  cachedDataInvalid_ = 1;
+}
+
+/** Called from worker. New band, rate or NFFT of zoom (filter and window
+ *  restart). The old band is kept if allocation fails.
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::configureZoom() {
+  try {
+    zoom_->configure(cfgDataSampleRateHz_, cfgZoomCenter_, cfgZoomSpan_, cfgNfft_, hopSize_);
+  }
+  catch(std::bad_alloc& e) {
+    printf("%s/%s:%d: Error: Failed configure zoom (%s).\n",
+           __FILE__, __FUNCTION__, __LINE__, e.what());
+  }
+  zoomBins_          = zoom_->getBins();
+  zoomRate_          = zoom_->getRate();
+  zoomFirstFreq_     = zoom_->getFirstFreq();
+  cachedDataInvalid_ = 1;  // New x-axis and unit scale
+}
+
+/** Called from worker. Apply new NFFT if requested. The realtime thread
+ *  skips data while buffers are reallocated and the acquisition is
+ *  restarted with the new NFFT. Readers of the x-axis must be blocked by
+ *  the caller (snapshots are not touched). Returns 1 if NFFT changed.
+*/
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::applyNfftRequest() {
+  size_t nfft = nfftRequest_.exchange(0);
+  if(nfft == 0 || nfft == cfgNfft_) {
+    return 0;
+  }
+
+  int changed = 0;
+  reallocLock_.lock();  // Realtime will not touch the buffers
+  try {
+    typename ecmcFFTTransform<S>::type* plan = planCache_->getPlan(nfft);
+    size_t      hopSize = getHopSize(nfft);
+    allocBuffers(nfft, hopSize);
+    fft_               = plan;
+    cfgNfft_           = nfft;
+    ringSize_          = nfft;
+    hopSize_           = hopSize;
+    ringWriteIndex_    = 0;
+    ringElements_      = 0;
+    acqBuffer_         = NULL;
+    acqSequence_       = 0;
+    workerSequence_    = 0;
+    acqRestart_        = 1;
+    acqReset_          = 1;  // elementsInBuffer_ is reset by realtime (only writer)
+    fftWaitingForCalc_ = 0;
+    changed            = 1;
+  }
+  catch(std::exception& e) {
+    printf("%s/%s:%d: Error: Failed change NFFT to %zu (%s). NFFT = %zu.\n",
+           __FILE__, __FUNCTION__, __LINE__, nfft, e.what(), cfgNfft_);
+  }
+  reallocLock_.unlock();
+
+  if(changed) {
+    // Average of old NFFT can not continue. Readers get zeros of new NFFT
+    releaseSnapshot(avgSnapshot_);
+    avgSnapshot_ = NULL;
+    try {
+      publishEmptySnapshot();
+    }
+    catch(std::bad_alloc& e) {
+      printf("%s/%s:%d: Warning: Failed allocate snapshot (%s).\n",
+             __FILE__, __FUNCTION__, __LINE__, e.what());
+    }
+  }
+
+  cachedDataInvalid_ = 1;  // New x-axis and scale
+  zoomInvalid_       = zoom_ ? 1 : 0;
+  return changed;
+}
+
+/** Called from worker. Take a snapshot that is not referenced (by readers,
+ *  publishing or average) and make room for nfft and the requested outputs
+ *  (ECMC_FFT_OUTPUT_*). Snapshots are allocated when needed, so normally
+ *  only a few exist. Returns NULL if all in use.
+ *  Throws bad_alloc.
+*/
+template<typename T, typename S>
+ecmcFFTSnapshot<T>* ecmcFFTEngineT<T, S>::getFreeSnapshot(size_t nfft, int outputs) {
+  for(int i = 0; i < ECMC_PLUGIN_MAX_SNAPSHOTS; ++i) {
+    if(!snapshots_[i]) {
+      ecmcFFTSnapshot<T>* snapshot = new ecmcFFTSnapshot<T>;
+      snapshot->refCount     = 0;
+      snapshot->capacity     = 0;
+      snapshot->nfft         = 0;
+      snapshot->binCapacity  = 0;
+      snapshot->bins         = 0;
+      snapshot->rawData      = NULL;
+      snapshot->prepProcData = NULL;
+      snapshot->result       = NULL;
+      snapshot->amp          = NULL;
+      snapshot->avg          = NULL;
+      snapshot->phase        = NULL;
+      snapshot->real         = NULL;
+      snapshot->imag         = NULL;
+      snapshot->outputs      = 0;
+      snapshots_[i] = snapshot;
+    }
+
+    ecmcFFTSnapshot<T>* snapshot = snapshots_[i];
+    // Acquire pairs with release of last reader (data no longer read)
+    if(snapshot->refCount.load(std::memory_order_acquire) != 0) {
+      continue;
+    }
+
+    size_t binCapacity = getBinCapacity(nfft);
+    if(nfft > snapshot->capacity || binCapacity > snapshot->binCapacity) {
+      T*                    rawData  = NULL;
+      T*                    prepData = NULL;
+      std::complex<T>*      result   = NULL;
+      T*                    amp      = NULL;
+      T*                    avg      = NULL;
+      try {
+        rawData  = new T[nfft];
+        prepData = new T[nfft];
+        result   = new std::complex<T>[binCapacity];
+        amp      = new T[binCapacity];
+        avg      = new T[binCapacity];
+      }
+      catch(std::bad_alloc& e) {
+        delete[] rawData;
+        delete[] prepData;
+        delete[] result;
+        delete[] amp;
+        delete[] avg;
+        throw;
+      }
+      delete[] snapshot->rawData;
+      delete[] snapshot->prepProcData;
+      delete[] snapshot->result;
+      delete[] snapshot->amp;
+      delete[] snapshot->avg;
+      delete[] snapshot->phase;
+      delete[] snapshot->real;
+      delete[] snapshot->imag;
+      snapshot->rawData      = rawData;
+      snapshot->prepProcData = prepData;
+      snapshot->result       = result;
+      snapshot->amp          = amp;
+      snapshot->avg          = avg;
+      snapshot->phase        = NULL;
+      snapshot->real         = NULL;
+      snapshot->imag         = NULL;
+      snapshot->capacity     = nfft;
+      snapshot->binCapacity  = binCapacity;
+    }
+
+    // Optional outputs (kept when no longer requested)
+    T** outputArrays[ECMC_FFT_OUTPUT_COUNT] = {&snapshot->phase, &snapshot->real, &snapshot->imag};
+    for(int j = 0; j < ECMC_FFT_OUTPUT_COUNT; ++j) {
+      if((outputs & (1 << j)) && !*outputArrays[j]) {
+        *outputArrays[j] = new T[snapshot->binCapacity];
+      }
+    }
+    snapshot->nfft     = nfft;
+    snapshot->bins     = getBins();
+    snapshot->outputs  = outputs;
+    snapshot->refCount = 1;  // Reference of caller
+    return snapshot;
+  }
+  return NULL;
+}
+
+/** Publish snapshot as latest spectrum (and as latest average if avg).
+ *  The reference of the caller is moved to the published pointer.
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::publishSnapshot(ecmcFFTSnapshot<T>* snapshot, int avg) {
+  ecmcFFTSnapshot<T>* old    = NULL;
+  ecmcFFTSnapshot<T>* oldAvg = NULL;
+  if(avg) {
+    snapshot->refCount++;
+  }
+  snapshotLock_.lock();
+  old                = publishedSnapshot_;
+  publishedSnapshot_ = snapshot;
+  if(avg) {
+    oldAvg                = publishedAvgSnapshot_;
+    publishedAvgSnapshot_ = snapshot;
+  }
+  snapshotLock_.unlock();
+  releaseSnapshot(old);
+  releaseSnapshot(oldAvg);
+}
+
+// Publish zeros (at start and NFFT change). Throws bad_alloc
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::publishEmptySnapshot() {
+  ecmcFFTSnapshot<T>* snapshot = getFreeSnapshot(cfgNfft_, 0);
+  if(!snapshot) {
+    return;
+  }
+  size_t bins = snapshot->bins;
+  memset(snapshot->rawData, 0, cfgNfft_ * sizeof(T));
+  memset(snapshot->prepProcData, 0, cfgNfft_ * sizeof(T));
+  memset(snapshot->amp, 0, bins * sizeof(T));
+  memset(snapshot->avg, 0, bins * sizeof(T));
+  for(size_t i = 0; i < bins; ++i) {
+    snapshot->result[i] = 0;
+  }
+  publishSnapshot(snapshot, 1);
+}
+
+// Any thread. Take a reference to latest spectrum (NULL if none)
+template<typename T, typename S>
+ecmcFFTSnapshot<T>* ecmcFFTEngineT<T, S>::getSnapshot() {
+  snapshotLock_.lock();
+  ecmcFFTSnapshot<T>* snapshot = publishedSnapshot_;
+  if(snapshot) {
+    snapshot->refCount++;
+  }
+  snapshotLock_.unlock();
+  return snapshot;
+}
+
+// Any thread. Take a reference to latest published average (NULL if none)
+template<typename T, typename S>
+ecmcFFTSnapshot<T>* ecmcFFTEngineT<T, S>::getAvgSnapshot() {
+  snapshotLock_.lock();
+  ecmcFFTSnapshot<T>* snapshot = publishedAvgSnapshot_;
+  if(snapshot) {
+    snapshot->refCount++;
+  }
+  snapshotLock_.unlock();
+  return snapshot;
+}
+
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::releaseSnapshot(ecmcFFTSnapshot<T>* snapshot) {
+  if(snapshot) {
+    snapshot->refCount.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+// Called from realtime thread. Take a free buffer from the pool (NULL if none free)
+template<typename T, typename S>
+ecmcFFTAcqBuffer<S>* ecmcFFTEngineT<T, S>::getFreeAcqBuffer() {
+  for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+    int expected = ECMC_FFT_ACQ_BUFF_FREE;
+    if(acqBuffers_[i].state.compare_exchange_strong(expected, ECMC_FFT_ACQ_BUFF_FILLING)) {
+      acqBuffers_[i].elements = 0;
+      acqBuffers_[i].sumY     = 0;
+      acqBuffers_[i].sumJY    = 0;
+      return &acqBuffers_[i];
+    }
+  }
+  return NULL;
+}
+
+/** Called from worker thread. Move all handed over buffers (in order) to the
+ *  history ring buffer (or mix and decimate them if zoom) and give them back
+ *  to the pool. Returns 1 if a new window of NFFT samples is available.
+*/
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::readAcqBuffers() {
+  int newData = 0;
+
+  if(zoom_ && zoomInvalid_.exchange(0)) {
+    configureZoom();
+  }
+
+  while(true) {
+    ecmcFFTAcqBuffer<S> *buffer = NULL;
+    for(int i = 0; i < ECMC_PLUGIN_ACQ_BUFFER_COUNT; ++i) {
+      if(acqBuffers_[i].state.load(std::memory_order_acquire) == ECMC_FFT_ACQ_BUFF_FULL &&
+         acqBuffers_[i].sequence == workerSequence_) {
+        buffer = &acqBuffers_[i];
+        break;
+      }
+    }
+    if(!buffer) {
+      break;
+    }
+
+    // Gap in data (clear, trigg or overrun)
+    if(buffer->restart) {
+      ringWriteIndex_     = 0;
+      ringElements_       = 0;
+      blockStatsCount_    = 0;
+      blockStatsElements_ = 0;
+      if(zoom_) {
+        zoom_->reset();
+      }
+    }
+    lastSampleNs_ = buffer->handOverNs;
+
+    // Zoom: mixed, filtered and decimated directly (no history of raw data)
+    if(zoom_) {
+      zoom_->add(buffer->data, buffer->elements);
+      workerSequence_++;
+      buffer->state.store(ECMC_FFT_ACQ_BUFF_FREE, std::memory_order_release);
+      newData = 1;
+      continue;
+    }
+    addBlockStats(buffer->elements, buffer->sumY, buffer->sumJY);
+
+    size_t firstPart = ringSize_ - ringWriteIndex_;
+    if(firstPart > buffer->elements) {
+      firstPart = buffer->elements;
+    }
+    memcpy(&ringBuffer_[ringWriteIndex_], buffer->data, firstPart * sizeof(S));
+    memcpy(ringBuffer_, &buffer->data[firstPart], (buffer->elements - firstPart) * sizeof(S));
+    ringWriteIndex_ = (ringWriteIndex_ + buffer->elements) % ringSize_;
+    ringElements_  += buffer->elements;
+    if(ringElements_ > cfgNfft_) {
+      ringElements_ = cfgNfft_;
+    }
+
+    workerSequence_++;
+    // Give back to pool
+    buffer->state.store(ECMC_FFT_ACQ_BUFF_FREE, std::memory_order_release);
+    newData = 1;
+  }
+
+  if(!newData || (zoom_ ? !zoom_->windowReady() : ringElements_ < cfgNfft_)) {
+    return 0;
+  }
+
+  // Results go to a free snapshot, published ones can still be read
+  try {
+    calcSnapshot_ = getFreeSnapshot(cfgNfft_, cfgOutputs_);
+  }
+  catch(std::bad_alloc& e) {
+    calcSnapshot_ = NULL;
+  }
+  if(!calcSnapshot_) {
+    printf("%s/%s:%d: Warning: No free snapshot, spectrum skipped.\n",
+           __FILE__, __FUNCTION__, __LINE__);
+    fftWaitingForCalc_ = 0;  // Window consumed (triggered acq. can start over)
+    return 0;
+  }
+  return 1;
+}
+
+// Add stats of buffer (worker). Stats of buffers that left the window are dropped
+void ecmcFFTEngine::addBlockStats(size_t elements, double sumY, double sumJY) {
+  size_t last = (blockStatsFirst_ + blockStatsCount_) % blockStatsSize_;
+  blockStats_[last].elements = elements;
+  blockStats_[last].sumY     = sumY;
+  blockStats_[last].sumJY    = sumJY;
+  blockStatsCount_++;
+  blockStatsElements_ += elements;
+
+  while(blockStatsCount_ > 1 &&
+        blockStatsElements_ - blockStats_[blockStatsFirst_].elements >= cfgNfft_) {
+    blockStatsElements_ -= blockStats_[blockStatsFirst_].elements;
+    blockStatsFirst_     = (blockStatsFirst_ + 1) % blockStatsSize_;
+    blockStatsCount_--;
+  }
+}
+
+/** Sum of y and x*y (x = 0..NFFT-1) of the latest window, combined from the
+ *  buffer stats accumulated in realtime. Only the part of the oldest buffer
+ *  that is inside the window (if hop does not divide NFFT) is summed here.
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcWindowSums(double* sumY, double* sumXY) {
+  double sy  = 0;
+  double sxy = 0;
+  size_t offset = 0;  // Window index of first sample in buffer
+
+  for(size_t b = 0; b < blockStatsCount_; ++b) {
+    ecmcFFTBlockStats* stats = &blockStats_[(blockStatsFirst_ + b) % blockStatsSize_];
+    if(b == 0 && blockStatsElements_ > cfgNfft_) {
+      // Oldest buffer partly outside window, sum the part inside
+      size_t inside = stats->elements - (blockStatsElements_ - cfgNfft_);
+      size_t index  = ringWriteIndex_;  // Oldest sample
+      for(size_t i = 0; i < inside; ++i) {
+        double y = ringBuffer_[index];
+        sy  += y;
+        sxy += (double)i * y;
+        index++;
+        if(index >= ringSize_) {
+          index = 0;
+        }
+      }
+      offset = inside;
+      continue;
+    }
+    sy     += stats->sumY;
+    sxy    += stats->sumJY + (double)offset * stats->sumY;
+    offset += stats->elements;
+  }
+  *sumY  = sy;
+  *sumXY = sxy;
+}
+
+/** Fused pre-processing: one pass over the window that copies raw data and
+ *  writes detrended (DC or line removed) and windowed data to the FFT input.
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::preProcess() {
+  double k = 0;  // y = k*x + m
+  double m = 0;
+
+  // Zoom: window of decimated data (dc and line are outside band or filtered)
+  if(zoom_) {
+    zoom_->getWindow(windowBuffer_, calcSnapshot_->rawData, calcSnapshot_->prepProcData);
+    return;
+  }
+
+  if(cfgDcRemove_ || cfgLinRemove_) {
+    double sumY  = 0;
+    double sumXY = 0;
+    calcWindowSums(&sumY, &sumXY);
+    m = sumY / ((double)cfgNfft_);  // DC
+    // Line also removes DC
+    if(cfgLinRemove_) {
+      if(leastSquare(cfgNfft_, sumY, sumXY, &k, &m)) {
+        printf("%s/%s:%d: Error: " ECMC_PLUGIN_RM_LIN_OPTION_CMD " failed, divison by 0. Data will not be processed with the option/configuration.\n",
+               __FILE__, __FUNCTION__, __LINE__);
+        k = 0;
+        m = cfgDcRemove_ ? sumY / ((double)cfgNfft_) : 0;
+      }
+    }
+  }
+
+  const S* window = NULL;
+  if(cfgWindow_ != WINDOW_NONE) {
+    window = windowBuffer_;
+  }
+
+  // Ring is NFFT long so oldest sample is next to write
+  size_t start     = ringWriteIndex_;
+  size_t firstPart = ringSize_ - start;
+  preProcessSegment(&ringBuffer_[start], 0, firstPart, k, m, window);
+  preProcessSegment(ringBuffer_, firstPart, cfgNfft_ - firstPart, k, m, window);
+}
+
+// Simple loops without dependencies, vectorized by compiler
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::preProcessSegment(const S* src,
+                                             size_t offset,
+                                             size_t elements,
+                                             double k,
+                                             double m,
+                                             const S* window) {
+  T* raw   = &calcSnapshot_->rawData[offset];
+  T* prep  = &calcSnapshot_->prepProcData[offset];
+  T  base  = (T)(k * (double)offset + m);
+  T  slope = (T)k;
+
+  if(window) {
+    const S* w = &window[offset];
+    for(size_t i = 0; i < elements; ++i) {
+      T y      = src[i];
+      raw[i]   = y;
+      prep[i]  = (y - (base + slope * (T)i)) * w[i];
+    }
+  } else {
+    for(size_t i = 0; i < elements; ++i) {
+      T y      = src[i];
+      raw[i]   = y;
+      prep[i]  = y - (base + slope * (T)i);
+    }
+  }
+}
+
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcFFT() {
+  std::complex<T>* result = calcSnapshot_->result;
+  if(zoom_) {
+    zoom_->transform(result);  // Complex transform, bins of band
+    return;
+  }
+
+  // Do fft directly on the real pre-processed data (results in bin 0..NFFT/2-1)
+  fft_->transform_real(calcSnapshot_->prepProcData, result);
+
+  // DC and nyquist are both real and packed in bin 0, move nyquist to bin NFFT/2
+  T nyquist = result[0].imag();
+  result[0].imag(0);
+  result[cfgNfft_ / 2].real(nyquist);
+  result[cfgNfft_ / 2].imag(0);
+}
+
+// Scale, unit (and requested outputs) and averaging
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::postProcess() {
+  calcSpectrum();    // Scale, unit (and requested outputs)
+  calcBands();
+  return calcFFTAvg() ? ECMC_FFT_CALC_AVG_DONE : 0;
+}
+
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcDone(int flags) {
+  // No window consumed: a triggered window may have been handed over after
+  // readAcqBuffers(), its wait flag must stay set until it is calculated
+  if(!calcSnapshot_) {
+    return;
+  }
+  publishSnapshot(calcSnapshot_, flags & ECMC_FFT_CALC_AVG_DONE);
+  calcSnapshot_ = NULL;
+  // Linear average done, start next
+  if((flags & ECMC_FFT_CALC_AVG_DONE) && cfgAvgMode_ == AVG_LIN) {
+    avgCounter_ = 0;
+  }
+  fftWaitingForCalc_ = 0;
+}
+
+template<typename T, typename S>
+double ecmcFFTEngineT<T, S>::getResultScale() {
+  return scale_;
+}
+
+/** Scale of result, amplitude in configured unit and the requested outputs
+ *  of the snapshot in one pass over the bins (outputs nobody reads are not
+ *  calculated). Units are calculated from |X|^2 (no sqrt except for AMP):
+ *    - UNIT_AMP:   |X|
+ *    - UNIT_POWER: |X|^2
+ *    - UNIT_PSD:   unitScale_*|X|^2, dc and nyquist bins not doubled
+ *    - UNIT_DB:    10*log10(unitScale_*|X|^2), floored at smallest T
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcSpectrum() {
+  std::complex<T>* result  = calcSnapshot_->result;
+  T*               amp     = calcSnapshot_->amp;
+  int              outputs = calcSnapshot_->outputs;
+  T*               phase   = outputs & ECMC_FFT_OUTPUT_PHASE ? calcSnapshot_->phase : NULL;
+  T*               real    = outputs & ECMC_FFT_OUTPUT_REAL  ? calcSnapshot_->real  : NULL;
+  T*               imag    = outputs & ECMC_FFT_OUTPUT_IMAG  ? calcSnapshot_->imag  : NULL;
+  T                scale   = (T)getResultScale();
+  T                k       = (T)unitScale_;
+  T                minPow  = std::numeric_limits<T>::min();
+  T                radToDeg = (T)(180.0 / M_PI);
+  FFT_UNIT         unit    = unit_;
+  size_t           bins    = getBins();
+
+  for(size_t i = 0 ; i < bins ; ++i ) {
+    T re = result[i].real() * scale;
+    T im = result[i].imag() * scale;
+    result[i] = std::complex<T>(re, im);
+    T pow = re * re + im * im;
+    switch(unit) {
+      case UNIT_AMP:
+        amp[i] = std::sqrt(pow);
+        break;
+      case UNIT_DB:
+        pow *= k;
+        amp[i] = 10 * std::log10(pow > minPow ? pow : minPow);
+        break;
+      default:
+        amp[i] = pow * k;
+        break;
+    }
+    if(!outputs) {
+      continue;
+    }
+    if(phase) {
+      phase[i] = std::atan2(im, re) * radToDeg;
+    }
+    if(real) {
+      real[i] = re;
+    }
+    if(imag) {
+      imag[i] = im;
+    }
+  }
+
+  // One-sided density: dc and nyquist have no mirrored bin (zoom band has none of them)
+  if(unit == UNIT_PSD && !zoom_) {
+    amp[0]        *= (T)0.5;
+    amp[bins - 1] *= (T)0.5;
+  }
+}
+
+/** Summary of each band from the scaled result (only the bins of the bands):
+ *    - BAND_RMS:       sqrt(sum(PSD*df)), dc and nyquist bins not doubled
+ *    - BAND_PEAK:      max of amplitude spectrum (configured unit)
+ *    - BAND_PEAK_FREQ: frequency of the max bin
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcBands() {
+  const std::complex<T>* result = calcSnapshot_->result;
+  const T*               amp    = calcSnapshot_->amp;
+  size_t                 bins   = getBins();
+  double firstFreq = zoomBins_ ? zoomFirstFreq_ : 0;
+  double deltaFreq = getSpectrumRate() / (double)cfgNfft_;
+
+  for(size_t b = 0; b < bandCount_; ++b) {
+    size_t first = bandFirstBin_[b];
+    size_t end   = bandEndBin_[b];
+    double sumSq = 0;
+    size_t peak  = first;
+    for(size_t i = first; i < end; ++i) {
+      double pow = std::norm(result[i]);
+      // One-sided: dc and nyquist have no mirrored bin (zoom band has none of them)
+      sumSq += !zoom_ && (i == 0 || i == bins - 1) ? 0.5 * pow : pow;
+      if(amp[i] > amp[peak]) {
+        peak = i;
+      }
+    }
+    int valid = end > first;
+    bandValues_[b][BAND_RMS].store(sqrt(sumSq * bandScale_), std::memory_order_relaxed);
+    bandValues_[b][BAND_PEAK].store(valid ? (double)amp[peak] : 0, std::memory_order_relaxed);
+    bandValues_[b][BAND_PEAK_FREQ].store(valid ? firstFreq + (double)peak * deltaFreq : 0,
+                                         std::memory_order_relaxed);
+  }
+}
+
+// Only called when rate or nfft changed (see updateCachedData())
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcFFTXAxis() {
+  //fill x axis buffer with freqs
+  double freq = zoomBins_ ? zoomFirstFreq_ : 0;
+  double deltaFreq = getSpectrumRate() / ((double)(cfgNfft_));
+  for(unsigned int i = 0; i < getBins(); ++i) {
+    fftBufferXAxis_[i] = (T)freq;
+    freq = freq + deltaFreq;
+  }
+}
+
+/** Average amplitude spectra. The running average of the previous snapshot
+ *  (not changed, can be published) is combined with the new amplitude into
+ *  the average of the snapshot in calc, which then holds the running average.
+ *  UNIT_DB is averaged in power (LIN and EXP). Returns 1 if the average
+ *  should be published.
+*/
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::calcFFTAvg() {
+  if(cfgAvgMode_ == AVG_NONE) {
+    return 0;
+  }
+
+  if(avgReset_.exchange(0)) {
+    avgCounter_ = 0;
+  }
+
+  size_t   bins = calcSnapshot_->bins;
+  const T* amp  = calcSnapshot_->amp;
+  T*       avg  = calcSnapshot_->avg;
+  const T* prev = avgSnapshot_ ? avgSnapshot_->avg : NULL;
+
+  // Snapshot in calc holds the running average from now
+  calcSnapshot_->refCount++;
+  releaseSnapshot(avgSnapshot_);
+  avgSnapshot_ = calcSnapshot_;
+
+  // First spectrum
+  if(avgCounter_ == 0 || !prev) {
+    memcpy(avg, amp, bins * sizeof(T));
+    avgCounter_ = 1;
+    return cfgAvgMode_ != AVG_LIN || cfgAvgCount_ <= 1;
+  }
+
+  int publish = 1;
+  switch(cfgAvgMode_) {
+    case AVG_LIN:
+    case AVG_EXP:
+      {
+        // Running mean or exponential average
+        T k = cfgAvgMode_ == AVG_LIN ? (T)(1.0 / (double)(avgCounter_ + 1)) : (T)cfgAvgAlpha_;
+        if(unit_ == UNIT_DB) {
+          // Averaged in power (mean of dB values is biased, about -2.5 dB for noise)
+          T minPow = std::numeric_limits<T>::min();
+          for(size_t i = 0; i < bins; ++i) {
+            T prevPow = std::pow((T)10, prev[i] / 10);
+            T pow     = prevPow + (std::pow((T)10, amp[i] / 10) - prevPow) * k;
+            avg[i]    = 10 * std::log10(pow > minPow ? pow : minPow);
+          }
+        } else {
+          for(size_t i = 0; i < bins; ++i) {
+            avg[i] = prev[i] + (amp[i] - prev[i]) * k;
+          }
+        }
+        avgCounter_++;
+        publish = cfgAvgMode_ != AVG_LIN || avgCounter_ >= (size_t)cfgAvgCount_;
+      }
+      break;
+    case AVG_MAX:
+      for(size_t i = 0; i < bins; ++i) {
+        avg[i] = amp[i] > prev[i] ? amp[i] : prev[i];
+      }
+      avgCounter_++;
+      break;
+    default:
+      break;
+  }
+  return publish;
+}
+
+// Data only depending on config (rate, nfft, window). Returns 1 if x-axis changed.
+// Readers of the x-axis must be blocked by the caller
+template<typename T, typename S>
+int ecmcFFTEngineT<T, S>::updateCachedData() {
+  if(!cachedDataInvalid_.exchange(0)) {
+    return 0;
+  }
+
+  calcWindow();
+  resetAvg();  // Scale or bins changed
+  // Window correction folded into scale (1/NFFT if no window)
+  scale_ = windowCorr_;
+  calcUnitScale();
+  calcFFTXAxis();
+  calcBandBins();
+  return 1;
+}
+
+// Cosine sum coefficients: w = a0 - a1*cos(x) + a2*cos(2x) - a3*cos(3x) + a4*cos(4x)
+void ecmcFFTEngine::calcWindowCoeffs(double* a) {
+  a[0] = 1.0;
+  a[1] = 0.0;
+  a[2] = 0.0;
+  a[3] = 0.0;
+  a[4] = 0.0;
+  switch(cfgWindow_) {
+    case WINDOW_HANN:
+      a[0] = 0.5;
+      a[1] = 0.5;
+      break;
+    case WINDOW_HAMMING:
+      a[0] = 0.54;
+      a[1] = 0.46;
+      break;
+    case WINDOW_BLACKMANHARRIS:
+      a[0] = 0.35875;
+      a[1] = 0.48829;
+      a[2] = 0.14128;
+      a[3] = 0.01168;
+      break;
+    case WINDOW_FLATTOP:
+      a[0] = 0.21557895;
+      a[1] = 0.41663158;
+      a[2] = 0.277263158;
+      a[3] = 0.083578947;
+      a[4] = 0.006947368;
+      break;
+    default:
+      break;
+  }
+}
+
+/** Factor of the scaled |X|^2 for the configured unit (latched for the worker).
+ *  PSD is one-sided and independent of window correction:
+ *    PSD = 2*|Xraw|^2/(fs*sum(w²)) = 2*|X|^2/(scale²*fs*sum(w²)),
+ *  for WINDOW_CORR=AMP this is 2*|X|^2/ENBW[Hz] (fs is the decimated rate if zoom).
+ *  DB is relative to DB_REF: 10*log10(|X|^2/ref²).
+*/
+void ecmcFFTEngine::calcUnitScale() {
+  unit_ = cfgUnit_;
+  switch(unit_) {
+    case UNIT_PSD:
+      unitScale_ = 2.0 / (windowCorr_ * windowCorr_ * getSpectrumRate() * windowSumSq_);
+      break;
+    case UNIT_DB:
+      unitScale_ = 1.0 / (cfgDbRef_ * cfgDbRef_);
+      break;
+    default:
+      unitScale_ = 1.0;
+      break;
+  }
+  // Sum of PSD*df over bins (df = fs/NFFT), window independent as PSD
+  bandScale_ = 2.0 / (windowCorr_ * windowCorr_ * (double)cfgNfft_ * windowSumSq_);
+}
+
+// Bins with frequency within the limits of each band (same axis as calcFFTXAxis())
+void ecmcFFTEngine::calcBandBins() {
+  double firstFreq = zoomBins_ ? zoomFirstFreq_ : 0;
+  double deltaFreq = getSpectrumRate() / (double)cfgNfft_;
+  double bins      = (double)getBins();
+  for(size_t i = 0; i < bandCount_; ++i) {
+    double first = ceil((cfgBandLow_[i] - firstFreq) / deltaFreq);
+    double end   = floor((cfgBandHigh_[i] - firstFreq) / deltaFreq) + 1;
+    first = first < 0 ? 0 : first;
+    end   = end > bins ? bins : end;
+    bandFirstBin_[i] = (size_t)first;
+    bandEndBin_[i]   = end > first ? (size_t)end : (size_t)first;
+  }
+}
+
+/** Calc window coefficients for NFFT (periodic windows), the correction
+ *  to get calibrated amplitude (1/sum(w)) or energy (1/sqrt(NFFT*sum(w²)))
+ *  and the equivalent noise bandwidth NFFT*sum(w²)/sum(w)² [bins].
+*/
+template<typename T, typename S>
+void ecmcFFTEngineT<T, S>::calcWindow() {
+  double a[5];
+  calcWindowCoeffs(a);
+
+  double sum   = 0;
+  double sumSq = 0;
+  for(unsigned int i = 0; i < cfgNfft_; ++i) {
+    double x = 2 * M_PI * i / (double)cfgNfft_;
+    double w = a[0] - a[1] * cos(x) + a[2] * cos(2 * x) - a[3] * cos(3 * x) + a[4] * cos(4 * x);
+    windowBuffer_[i] = windowCoeff<S>(w);
+    sum   += w;
+    sumSq += w * w;
+  }
+
+  windowSumSq_ = sumSq;
+  windowEnbw_  = (double)cfgNfft_ * sumSq / (sum * sum);
+  if(cfgWindowCorr_ == WINDOW_CORR_ENERGY) {
+    windowCorr_ = 1.0 / sqrt((double)cfgNfft_ * sumSq);
+  } else {
+    windowCorr_ = 1.0 / sum;
+  }
+}
+
+size_t ecmcFFTEngine::getNfft() {
+  return cfgNfft_;
+}
+
+size_t ecmcFFTEngine::getBins() {
+  return zoomBins_ ? zoomBins_ : cfgNfft_ / 2 + 1;
+}
+
+template<typename T, typename S>
+T* ecmcFFTEngineT<T, S>::getXAxis() {
+  return fftBufferXAxis_;
+}
+
+template<typename T, typename S>
+ecmcFFTPlanCache<S>* ecmcFFTEngineT<T, S>::getPlanCache() {
+  return planCache_;
+}
+
+template<>
+FFT_PRECISION ecmcFFTEngineT<double>::getPrecision() {
+  return PRECISION_DOUBLE;
+}
+
+template<>
+FFT_PRECISION ecmcFFTEngineT<float>::getPrecision() {
+  return PRECISION_FLOAT;
+}
+
+size_t ecmcFFTEngine::getAvgCounter() {
+  return avgCounter_;
+}
+
+int64_t ecmcFFTEngine::getLastSampleNs() {
+  return lastSampleNs_;
+}
+
+template<typename T, typename S>
+typename ecmcFFTEngineT<T, S>::ConvertFunc ecmcFFTEngineT<T, S>::getConvertFunc(FFT_SAMPLE_TYPE type) {
+  switch(type) {
+    case SAMPLE_U8:
+      return convertBlock<uint8_t, S>;
+    case SAMPLE_S8:
+      return convertBlock<int8_t, S>;
+    case SAMPLE_U16:
+      return convertBlock<uint16_t, S>;
+    case SAMPLE_S16:
+      return convertBlock<int16_t, S>;
+    case SAMPLE_U32:
+      return convertBlock<uint32_t, S>;
+    case SAMPLE_S32:
+      return convertBlock<int32_t, S>;
+    case SAMPLE_U64:
+      return convertBlock<uint64_t, S>;
+    case SAMPLE_S64:
+      return convertBlock<int64_t, S>;
+    case SAMPLE_F32:
+      return convertBlock<float, S>;
+    case SAMPLE_F64:
+      return convertBlock<double, S>;
+    default:
+      return NULL;
+  }
+  return NULL;
+}
+
+size_t ecmcFFTEngine::getSampleTypeByteSize(FFT_SAMPLE_TYPE type) {
+  switch(type) {
+    case SAMPLE_U8:
+    case SAMPLE_S8:
+      return 1;
+    case SAMPLE_U16:
+    case SAMPLE_S16:
+      return 2;
+    case SAMPLE_U32:
+    case SAMPLE_S32:
+    case SAMPLE_F32:
+      return 4;
+    case SAMPLE_U64:
+    case SAMPLE_S64:
+    case SAMPLE_F64:
+      return 8;
+    default:
+      return 0;
+  }
+  return 0;
+}
+
+/* y = k*x+m, x = 0..n-1 (sums of x and x² in closed form) */
+int ecmcFFTEngine::leastSquare(size_t n, double sumy, double sumxy, double* k, double* m){
+  double   dn    = (double)n;
+  double   sumx  = dn * (dn - 1) / 2;
+  double   sumx2 = (dn - 1) * dn * (2 * dn - 1) / 6;
+
+  double denom = (dn * sumx2 - sumx * sumx);
+  if (denom == 0) {
+    // Cannot dive by 0.. something wrong..
+    *k = 0;
+    *m = 0;
+    return 1; // Error
+  }
+
+  *k = (dn * sumxy  -  sumx * sumy) / denom;
+  *m = (sumy * sumx2  -  sumx * sumxy) / denom;
+  return 0;
+}
+
+/** PRECISION=FIXED: native integer samples (that fit in int32_t), the
+ *  transform is made in Q31 (see ecmcFFTFixed).
+*/
+template<>
+typename ecmcFFTEngineT<float, int32_t>::ConvertFunc ecmcFFTEngineT<float, int32_t>::getConvertFunc(FFT_SAMPLE_TYPE type) {
+  switch(type) {
+    case SAMPLE_U8:
+      return convertBlockFixed<uint8_t>;
+    case SAMPLE_S8:
+      return convertBlockFixed<int8_t>;
+    case SAMPLE_U16:
+      return convertBlockFixed<uint16_t>;
+    case SAMPLE_S16:
+      return convertBlockFixed<int16_t>;
+    case SAMPLE_S32:
+      return convertBlockFixed<int32_t>;
+    default:
+      return NULL;
+  }
+  return NULL;
+}
+
+/** Detrend and window in integer into the Q31 transform input (samples
+ *  shifted by fixedShift_). Raw and pre-processed data are published in
+ *  engineering units.
+*/
+template<>
+void ecmcFFTEngineT<float, int32_t>::preProcessSegment(const int32_t* src,
+                                                       size_t offset,
+                                                       size_t elements,
+                                                       double k,
+                                                       double m,
+                                                       const int32_t* window) {
+  float*   raw       = &calcSnapshot_->rawData[offset];
+  float*   prep      = &calcSnapshot_->prepProcData[offset];
+  int32_t* input     = &fftInput_[offset];
+  int      up        = fixedShift_ > 0 ? fixedShift_ : 0;
+  int      down      = fixedShift_ < 0 ? -fixedShift_ : 0;
+  double   q         = ldexp(1.0, fixedShift_);  // Counts to Q31
+  double   base      = (k * (double)offset + m) * q;
+  double   slope     = k * q;
+  float    rawScale  = (float)cfgScale_;
+  float    prepScale = (float)(cfgScale_ / q);
+  const int32_t* w   = window ? &window[offset] : NULL;
+
+  for(size_t i = 0; i < elements; ++i) {
+    int32_t y = src[i];
+    int64_t v = (((int64_t)y << up) >> down) - (int64_t)(base + slope * (double)i);
+    if(w) {
+      v = (v * w[i]) >> 31;
+    }
+    // Headroom of the transform (only if the removed line does not fit the data)
+    if(v > ECMC_FFT_FIXED_INPUT_MAX) {
+      v = ECMC_FFT_FIXED_INPUT_MAX;
+    } else if(v < -ECMC_FFT_FIXED_INPUT_MAX) {
+      v = -ECMC_FFT_FIXED_INPUT_MAX;
+    }
+    input[i] = (int32_t)v;
+    raw[i]   = (float)y * rawScale;
+    prep[i]  = (float)v * prepScale;
+  }
+}
+
+// Converted to engineering units (scale and window correction) on the NFFT/2+1 bins
+template<>
+void ecmcFFTEngineT<float, int32_t>::calcFFT() {
+  fft_->transformReal(fftInput_, calcSnapshot_->result,
+                      scale_ * cfgScale_ * ldexp(1.0, -fixedShift_));
+}
+
+template<>
+double ecmcFFTEngineT<float, int32_t>::getResultScale() {
+  return 1.0;  // Scaled in calcFFT()
+}
+
+template<>
+FFT_PRECISION ecmcFFTEngineT<float, int32_t>::getPrecision() {
+  return PRECISION_FIXED;
+}
+
+// Engines selectable with the PRECISION option
+template class ecmcFFTPlanCache<double>;
+template class ecmcFFTPlanCache<float>;
+template class ecmcFFTPlanCache<int32_t>;
+template class ecmcFFTEngineT<double>;
+template class ecmcFFTEngineT<float>;
+template class ecmcFFTEngineT<float, int32_t>;
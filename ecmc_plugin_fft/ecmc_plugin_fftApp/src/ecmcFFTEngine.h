@@ -0,0 +1,446 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTEngine.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_ENGINE_H_
+#define ECMC_FFT_ENGINE_H_
+
+#include <stdexcept>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <mutex>
+#include <complex>
+#include "ecmcFFTDefs.h"
+#include "ecmcFFTSimd.h"
+#include "ecmcFFTFixed.h"
+#include "ecmcFFTZoom.h"
+
+// Data type of samples added with acquire() (fixed width, little endian)
+typedef enum FFT_SAMPLE_TYPE{
+  SAMPLE_NONE = 0,
+  SAMPLE_U8   = 1,
+  SAMPLE_S8   = 2,
+  SAMPLE_U16  = 3,
+  SAMPLE_S16  = 4,
+  SAMPLE_U32  = 5,
+  SAMPLE_S32  = 6,
+  SAMPLE_U64  = 7,
+  SAMPLE_S64  = 8,
+  SAMPLE_F32  = 9,
+  SAMPLE_F64  = 10,
+} FFT_SAMPLE_TYPE;
+
+// Return flags of acquire()
+#define ECMC_FFT_ACQ_STATUS_UPDATED 0x1  // Status or elements in buffer changed
+#define ECMC_FFT_ACQ_HANDED_OVER    0x2  // Data handed over, trigger worker
+
+// Return flags of postProcess()
+#define ECMC_FFT_CALC_AVG_DONE      0x1  // Average should be published
+
+// Optional outputs calculated by postProcess() (setOutputs())
+#define ECMC_FFT_OUTPUT_PHASE       0x1  // Phase of result [deg]
+#define ECMC_FFT_OUTPUT_REAL        0x2  // Real part of result
+#define ECMC_FFT_OUTPUT_IMAG        0x4  // Imaginary part of result
+#define ECMC_FFT_OUTPUT_COUNT       3
+
+// Acquisition buffer states (ownership of buffer)
+#define ECMC_FFT_ACQ_BUFF_FREE    0  // In pool, free to use
+#define ECMC_FFT_ACQ_BUFF_FILLING 1  // Owned by realtime thread
+#define ECMC_FFT_ACQ_BUFF_FULL    2  // Handed over to worker thread
+
+// One hop of acquired data, handed from realtime to worker thread
+template<typename T>
+struct ecmcFFTAcqBuffer {
+  T*                    data;
+  size_t                elements;            // Valid samples in data
+  size_t                sequence;            // Hand over order
+  int                   restart;             // Gap in data before this buffer (restart history)
+  std::atomic<int>      state;               // ECMC_FFT_ACQ_BUFF_*
+  double                sumY;                // Sum of data (accumulated in realtime)
+  double                sumJY;               // Sum of index*data (j = 0..elements-1)
+  int64_t               handOverNs;          // Time of callback with last sample
+};
+
+// Statistics of one acquisition buffer in the history ring (for DC/linear removal)
+typedef struct ecmcFFTBlockStats {
+  size_t                elements;
+  double                sumY;
+  double                sumJY;
+} ecmcFFTBlockStats;
+
+/** Results of one spectrum. Written by worker into a free snapshot, then
+ *  published and never changed while referenced (readers and asyn callbacks
+ *  share the data without copies). Free (reused) when refCount is 0.
+*/
+template<typename T>
+struct ecmcFFTSnapshot {
+  std::atomic<int>      refCount;
+  size_t                capacity;            // Allocated NFFT
+  size_t                nfft;                // NFFT of results
+  size_t                binCapacity;         // Allocated bins
+  size_t                bins;                // Bins of results (NFFT/2+1, or band of zoom)
+  T*                    rawData;             // Input data (real)
+  T*                    prepProcData;        // Preprocessed data (real)
+  std::complex<T>*      result;              // Result (complex, bins)
+  T*                    amp;                 // Amplitude of result in configured unit (FFT_UNIT)
+  T*                    avg;                 // Averaged amplitude (same unit)
+  T*                    phase;               // Phase of result [deg] (allocated when requested)
+  T*                    real;                // Real part of result (allocated when requested)
+  T*                    imag;                // Imaginary part of result (allocated when requested)
+  int                   outputs;             // ECMC_FFT_OUTPUT_* calculated in this snapshot
+};
+
+// Transform of samples of type S (SIMD kissfft, fixed point for PRECISION=FIXED)
+template<typename S>
+struct ecmcFFTTransform {
+  typedef ecmcFFTSimd<S> type;
+};
+
+template<>
+struct ecmcFFTTransform<int32_t> {
+  typedef ecmcFFTFixed  type;
+};
+
+// Cached transform plan (twiddles) for one NFFT
+template<typename S>
+struct ecmcFFTPlan {
+  typename ecmcFFTTransform<S>::type* plan;
+  size_t                nfft;
+  size_t                lastUsed;            // For LRU replacement
+};
+
+/** Transform plans of type S, least recently used plan is replaced when
+ *  full. Shared by the engines of a multi channel object (same NFFT, same
+ *  worker thread). Only accessed by worker (and in constructor).
+ *  This object can throw:
+ *    - bad_alloc
+*/
+template<typename S>
+class ecmcFFTPlanCache {
+ public:
+  ecmcFFTPlanCache();
+  ~ecmcFFTPlanCache();
+  typename ecmcFFTTransform<S>::type* getPlan(size_t nfft);  // Created if not in cache
+
+ private:
+  ecmcFFTPlan<S>        plans_[ECMC_PLUGIN_PLAN_CACHE_SIZE];
+  size_t                counter_;
+};
+
+/** Published results of type T (any thread), independent of the sample
+ *  type of the engine. Release snapshots with releaseSnapshot().
+*/
+template<typename T>
+class ecmcFFTResults {
+ public:
+  virtual ~ecmcFFTResults() {}
+  virtual ecmcFFTSnapshot<T>* getSnapshot() = 0;     // Latest spectrum
+  virtual ecmcFFTSnapshot<T>* getAvgSnapshot() = 0;  // Latest published average
+  virtual void          releaseSnapshot(ecmcFFTSnapshot<T>* snapshot) = 0;
+  virtual T*            getXAxis() = 0;      // Worker, also readable while NFFT is unchanged
+};
+
+class ecmcFFTEngine {
+ public:
+
+  /** ecmc FFT engine base class
+   * Acquisition and DSP pipeline of one FFT object, without EPICS/asyn/ecmc
+   * dependencies (no threads, no publishing). Config, status and counters
+   * are kept here, buffers and calc in ecmcFFTEngineT<T, S> (see PRECISION
+   * option). Realtime thread calls acquire(), worker
+   * calls the calc stages in order:
+   *   applyNfftRequest(), readAcqBuffers(), updateCachedData(),
+   *   preProcess(), calcFFT(), postProcess(), calcDone()
+   * Results are published by calcDone() as reference counted snapshots,
+   * band summaries (setBands()) as scalars readable from any thread.
+   * This object can throw:
+   *    - bad_alloc
+   *    - out_of_range
+  */
+  ecmcFFTEngine(size_t nfft,
+                double overlap);     // Overlap between spectra in % of NFFT (CONT mode)
+  virtual ~ecmcFFTEngine();
+
+  // Config (any thread)
+  void                  setEnable(int enable);
+  int                   getEnable();
+  void                  setMode(FFT_MODE mode);
+  FFT_MODE              getMode();
+  void                  setScale(double scale);
+  void                  setDcRemove(int remove);
+  void                  setLinRemove(int remove);
+  void                  setWindow(FFT_WINDOW window);
+  FFT_WINDOW            getWindow();
+  void                  setWindowCorr(FFT_WINDOW_CORR corr);
+  void                  setUnit(FFT_UNIT unit);
+  FFT_UNIT              getUnit();
+  void                  setDbRef(double ref);    // Reference amplitude of UNIT_DB (> 0)
+  double                getDbRef();
+  double                getEnbw();               // Equivalent noise bandwidth of window [Hz] (worker)
+  void                  setAvgMode(FFT_AVG_MODE mode);
+  FFT_AVG_MODE          getAvgMode();
+  void                  setAvgCount(int count);
+  int                   getAvgCount();
+  void                  setAvgAlpha(double alpha);
+  double                getAvgAlpha();
+  void                  resetAvg();
+  void                  setSampleRate(double sampleRateHz);  // Rate of data (x-axis)
+  double                getSampleRate();
+  void                  setIgnoreCycles(int cycles);  // acquire() calls to skip between samples
+  virtual void          setSampleType(FFT_SAMPLE_TYPE type) = 0;  // Resolve converter once
+  void                  setNfft(size_t nfft);  // Applied by worker between acquisitions
+  size_t                getNfftRequest();      // 0 if none
+  void                  setStatus(FFT_STATUS status);
+  FFT_STATUS            getStatus();
+  void                  clearBuffers();
+  void                  setTrigg(int trigg);  // Start triggered acq. (reset when acq. done)
+  int                   getTrigg();
+  void                  setOutputs(int outputs);  // ECMC_FFT_OUTPUT_* (from next spectrum)
+  virtual void          setZoom(double centerHz,
+                                double spanHz) = 0;  // Zoom FFT of band (enabled at config, MODE=CONT)
+  int                   getZoom();           // 1 if zoom FFT
+  double                getZoomCenter();
+  double                getZoomSpan();
+  int                   getOutputs();
+  void                  setBands(const double* lowHz,
+                                 const double* highHz,
+                                 size_t count);  // Band summaries (at config, before data is added)
+  size_t                getBandCount();
+  double                getBandValue(size_t band,
+                                     FFT_BAND_OUTPUT output);  // Of latest spectrum (any thread, 0 if no bins)
+  virtual FFT_PRECISION getPrecision() = 0;
+
+  // Realtime thread (never blocks)
+  virtual int           acquire(const uint8_t*  data,
+                                size_t          elements,
+                                FFT_SAMPLE_TYPE type,
+                                int64_t         timeNs) = 0;  // Returns ECMC_FFT_ACQ_* flags
+  void                  addDroppedSamples(size_t elements);
+  void                  resetSampleCounters();
+  int32_t               getSamplesIngested();  // Counters wrap
+  int32_t               getSamplesDropped();
+  int32_t               getSamplesIgnored();
+  size_t                getElementsInBuffer();
+
+  // Worker thread (one thread at the time)
+  virtual int           applyNfftRequest() = 0;  // Returns 1 if NFFT changed
+  virtual int           readAcqBuffers() = 0;    // Returns 1 if a new window (and snapshot) is available
+  virtual int           updateCachedData() = 0;  // Returns 1 if x-axis changed
+  virtual void          preProcess() = 0;
+  virtual void          calcFFT() = 0;
+  virtual int           postProcess() = 0;       // Returns ECMC_FFT_CALC_* flags
+  virtual void          calcDone(int flags) = 0; // Publish and end calc (no-op if no new window)
+
+  // Results (worker thread)
+  size_t                getNfft();
+  size_t                getBins();           // NFFT/2+1 (bins in band if zoom)
+  double                getSpectrumRate();   // Rate of transformed data (decimated if zoom)
+  size_t                getAvgCounter();
+  int64_t               getLastSampleNs();   // Hand over time of newest data in window
+
+  static size_t         getSampleTypeByteSize(FFT_SAMPLE_TYPE type);
+  static int            leastSquare(size_t n,
+                                    double sumY,
+                                    double sumXY,
+                                    double* k,
+                                    double* m);  // y=kx+m, x=0..n-1
+
+ protected:
+  size_t                getHopSize(size_t nfft);
+  void                  addBlockStats(size_t elements, double sumY, double sumJY);
+  void                  calcWindowCoeffs(double* a);  // Cosine sum coefficients of window
+  void                  calcUnitScale();
+  void                  calcBandBins();      // Bins of bands (after x-axis changed)
+  void                  checkZoom(double centerHz, double spanHz, double sampleRateHz);
+  static void           addSampleCount(std::atomic<int32_t>* counter, size_t samples);
+
+  size_t                avgCounter_;         // Spectra in current average
+  std::atomic<int>      avgReset_;           // Restart averaging
+  double                windowCorr_;         // Window correction (folded into scale_)
+  double                windowEnbw_;         // Equivalent noise bandwidth of window [bins]
+  double                windowSumSq_;        // sum(w²) of window
+  FFT_UNIT              unit_;               // Unit of calc (latched with unitScale_ by worker)
+  double                unitScale_;          // Factor of |X|^2 for POWER, PSD and DB (see calcUnitScale())
+  double                bandScale_;          // Factor of |X|^2 to mean square of bin (PSD*df)
+  size_t                ringSize_;           // Size of ring buffer (NFFT)
+  size_t                ringWriteIndex_;     // Next write position in ring buffer
+  size_t                ringElements_;       // Valid samples in ring buffer
+  ecmcFFTBlockStats*    blockStats_;         // Stats of buffers in ring buffer (ring, oldest first)
+  size_t                blockStatsSize_;     // Allocated entries
+  size_t                blockStatsFirst_;    // Oldest entry
+  size_t                blockStatsCount_;    // Valid entries
+  size_t                blockStatsElements_; // Samples in valid entries
+  size_t                hopSize_;            // Samples between two spectra in CONT mode
+  size_t                acqSequence_;        // Next sequence to hand over (realtime)
+  size_t                workerSequence_;     // Next sequence to read (worker)
+  int                   acqRestart_;         // Next buffer starts after a gap in data
+  std::atomic<int>      acqReset_;           // Restart of acquisition requested
+  size_t                nfftCapacity_;       // Allocated size of NFFT long buffers
+  size_t                acqCapacity_;        // Allocated size of acquisition buffers
+  std::atomic<size_t>   nfftRequest_;        // New NFFT requested (0 = none)
+  std::mutex            reallocLock_;        // Held by realtime during acquire (only try_lock)
+  size_t                elementsInBuffer_;
+  std::atomic<int>      fftWaitingForCalc_;
+  std::atomic<int>      triggOnce_;
+  int                   cycleCounter_;
+  int                   ignoreCycles_;
+  FFT_SAMPLE_TYPE       convertType_;
+  double                rawConvertDummySum_; // Stats are calculated after raw conversion
+  double                scale_;              // Window correction (and 1/NFFT)
+  std::atomic<int>      cachedDataInvalid_;  // X-axis/scale needs recalc
+  std::atomic<int>      status_;             // FFT_STATUS (NO_STAT, IDLE, ACQ, CALC)
+  int64_t               lastSampleNs_;
+
+  // Sample counters. Only written by realtime thread
+  std::atomic<int32_t>  samplesIngested_;    // Added to acq. buffers
+  std::atomic<int32_t>  samplesDropped_;     // Lost (waiting for calc, no free buffer, realloc)
+  std::atomic<int32_t>  samplesIgnored_;     // In ignored cycles
+
+  // Config
+  size_t                cfgNfft_;            // Data set size
+  double                cfgOverlap_;         // Overlap between spectra in % of NFFT (CONT mode)
+  int                   cfgDcRemove_;        // Remove dc (average)
+  int                   cfgLinRemove_;       // Remove linear componet (by least square)
+  std::atomic<int>      cfgEnable_;          // Enable data acq./calc.
+  std::atomic<int>      cfgMode_;            // FFT_MODE, continous or triggered
+  std::atomic<int>      cfgOutputs_;         // ECMC_FFT_OUTPUT_* (only calculated if requested)
+  double                cfgScale_;
+  double                cfgDataSampleRateHz_;// Sample rate of data
+  FFT_WINDOW            cfgWindow_;          // Window function
+  FFT_WINDOW_CORR       cfgWindowCorr_;      // Window correction (amplitude or energy)
+  FFT_AVG_MODE          cfgAvgMode_;         // Averaging mode
+  int                   cfgAvgCount_;        // Spectra in linear average
+  double                cfgAvgAlpha_;        // Alpha of exponential average (0..1]
+  FFT_UNIT              cfgUnit_;            // Unit of amplitude spectrum
+  double                cfgDbRef_;           // Reference amplitude of UNIT_DB
+  double                cfgZoomCenter_;      // Centre of zoom band [Hz]
+  double                cfgZoomSpan_;        // Width of zoom band [Hz] (0 = no zoom)
+
+  // Bands (limits at config, bins and values by worker)
+  size_t                bandCount_;
+  double                cfgBandLow_[ECMC_PLUGIN_MAX_BANDS];   // [Hz]
+  double                cfgBandHigh_[ECMC_PLUGIN_MAX_BANDS];  // [Hz]
+  size_t                bandFirstBin_[ECMC_PLUGIN_MAX_BANDS];
+  size_t                bandEndBin_[ECMC_PLUGIN_MAX_BANDS];   // One after last bin (first if no bins)
+  std::atomic<double>   bandValues_[ECMC_PLUGIN_MAX_BANDS][ECMC_PLUGIN_BAND_OUTPUT_COUNT];
+
+  // Zoom (worker, applied with configureZoom())
+  std::atomic<int>      zoomInvalid_;        // Band, rate or NFFT changed
+  size_t                zoomBins_;           // Bins in band (0 = no zoom)
+  double                zoomRate_;           // Rate of decimated data
+  double                zoomFirstFreq_;      // Frequency of first bin
+};
+
+/** Engine with samples (buffers and transform) of type S and results of
+ *  type T. Instantiated in ecmcFFTEngine.cpp for:
+ *    - <double, double> PRECISION=DOUBLE
+ *    - <float, float>   PRECISION=FLOAT
+ *    - <float, int32_t> PRECISION=FIXED (native integer samples, Q31
+ *                       transform, converted to T on the output bins)
+*/
+template<typename T, typename S = T>
+class ecmcFFTEngineT : public ecmcFFTEngine, public ecmcFFTResults<T> {
+ public:
+
+  // Block converter from data type of source to S (see convertBlock<R, S>())
+  typedef void (*ConvertFunc)(const uint8_t* src,
+                              size_t         elements,
+                              double         scale,
+                              S*             dest,
+                              size_t         firstIndex,
+                              double*        sumY,
+                              double*        sumJY);
+
+  /** Optional conversion of raw samples (in place) before scale is applied,
+   *  called from realtime thread (for instance an EPICS breaktable).
+  */
+  typedef void (*RawConvertFunc)(void*  userData,
+                                 S*     data,
+                                 size_t elements);
+
+  ecmcFFTEngineT(size_t nfft,
+                 double overlap,
+                 ecmcFFTPlanCache<S>* planCache = NULL);  // Shared plans (NULL = own cache)
+  ~ecmcFFTEngineT();
+
+  void                  setSampleType(FFT_SAMPLE_TYPE type);
+  void                  setRawConvert(RawConvertFunc func, void* userData);
+  FFT_PRECISION         getPrecision();
+  ecmcFFTPlanCache<S>*  getPlanCache();
+  void                  setZoom(double centerHz, double spanHz);
+
+  int                   acquire(const uint8_t*  data,
+                                size_t          elements,
+                                FFT_SAMPLE_TYPE type,
+                                int64_t         timeNs);
+
+  int                   applyNfftRequest();
+  int                   readAcqBuffers();
+  int                   updateCachedData();
+  void                  preProcess();
+  void                  calcFFT();
+  int                   postProcess();
+  void                  calcDone(int flags);
+
+  ecmcFFTSnapshot<T>*   getSnapshot();
+  ecmcFFTSnapshot<T>*   getAvgSnapshot();
+  void                  releaseSnapshot(ecmcFFTSnapshot<T>* snapshot);
+  T*                    getXAxis();
+
+ private:
+  void                  handOverAcqBuffer(int64_t timeNs);
+  void                  scaleBlock(S* data, size_t elements, size_t firstIndex);
+  void                  allocBuffers(size_t nfft, size_t hopSize);
+  size_t                getBinCapacity(size_t nfft);  // Bins of buffers
+  void                  configureZoom();
+  void                  freeBuffers();
+  ecmcFFTAcqBuffer<S>*  getFreeAcqBuffer();
+  ecmcFFTSnapshot<T>*   getFreeSnapshot(size_t nfft, int outputs);
+  void                  publishSnapshot(ecmcFFTSnapshot<T>* snapshot, int avg);
+  void                  publishEmptySnapshot();
+  void                  calcWindowSums(double* sumY, double* sumXY);
+  void                  preProcessSegment(const S* src,
+                                          size_t offset,
+                                          size_t elements,
+                                          double k,
+                                          double m,
+                                          const S* window);
+  double                getResultScale();    // Scale of transform result (1 if scaled in calcFFT())
+  void                  calcSpectrum();      // Scale, unit and requested outputs (one pass)
+  void                  calcBands();         // RMS, peak and peak frequency of bands
+  int                   calcFFTAvg();        // Returns 1 if average should be published
+  void                  calcFFTXAxis();
+  void                  calcWindow();        // Window table and window correction
+  static ConvertFunc    getConvertFunc(FFT_SAMPLE_TYPE type);
+
+  typename ecmcFFTTransform<S>::type* fft_;  // Current plan (owned by planCache_)
+  ecmcFFTZoom<T>*       zoom_;               // Mix, decimate and transform of band (NULL = no zoom)
+  ecmcFFTPlanCache<S>*  planCache_;
+  int                   ownPlanCache_;       // planCache_ deleted with engine
+  ecmcFFTSnapshot<T>*   snapshots_[ECMC_PLUGIN_MAX_SNAPSHOTS]; // Pool (allocated when needed)
+  ecmcFFTSnapshot<T>*   calcSnapshot_;       // Written in current calc (worker)
+  ecmcFFTSnapshot<T>*   avgSnapshot_;        // Holds running average (input to next average)
+  ecmcFFTSnapshot<T>*   publishedSnapshot_;  // Latest spectrum
+  ecmcFFTSnapshot<T>*   publishedAvgSnapshot_; // Latest published average
+  std::mutex            snapshotLock_;       // Protects published pointers (short, never in realtime)
+  T*                    fftBufferXAxis_;     // FFT x axis with freqs
+  S*                    ringBuffer_;         // Window history (worker thread)
+  S*                    windowBuffer_;       // Window coefficients (aligned, NFFT)
+  S*                    fftInput_;           // Transform input if S is not T (else prepProcData)
+  int                   fixedShift_;         // Shift of samples to Q31 (PRECISION=FIXED)
+  ecmcFFTAcqBuffer<S>   acqBuffers_[ECMC_PLUGIN_ACQ_BUFFER_COUNT]; // Acquisition buffer pool
+  ecmcFFTAcqBuffer<S>*  acqBuffer_;          // Buffer currently filled by realtime thread
+  ConvertFunc           convertFunc_;        // Converter for data type of source
+  RawConvertFunc        rawConvertFunc_;
+  void*                 rawConvertData_;
+};
+
+#endif  /* ECMC_FFT_ENGINE_H_ */
@@ -0,0 +1,292 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTFixed.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ecmcFFTFixed.h"
+
+// Q31 product (64 bit, rounded)
+static inline int32_t fixedRound(int64_t x) {
+  return (int32_t)((x + ((int64_t)1 << 30)) >> 31);
+}
+
+static inline void fixedMul(ecmcFFTFixedCpx* m,
+                            const ecmcFFTFixedCpx& a,
+                            const ecmcFFTFixedCpx& b) {
+  m->r = fixedRound((int64_t)a.r * b.r - (int64_t)a.i * b.i);
+  m->i = fixedRound((int64_t)a.r * b.i + (int64_t)a.i * b.r);
+}
+
+// Divide by 2^shift (radix 2 and 4)
+static inline void fixedShift(ecmcFFTFixedCpx* c, int shift) {
+  int32_t half = 1 << (shift - 1);
+  c->r = (c->r + half) >> shift;
+  c->i = (c->i + half) >> shift;
+}
+
+/** ecmc FFT fixed point transform
+ * This object can throw:
+ *    - bad_alloc
+ *    - out_of_range
+*/
+ecmcFFTFixed::ecmcFFTFixed(size_t nfft, bool inverse) {
+  nfft_          = nfft;
+  inverse_       = inverse;
+  twiddles_      = NULL;
+  scratch_       = NULL;
+  result_        = NULL;
+  splitTwiddles_ = NULL;
+  memset(factors_, 0, sizeof(factors_));
+
+  if(nfft_ == 0) {
+    throw std::out_of_range("NFFT must be > 0.");
+  }
+
+  factor(nfft_);
+
+  size_t maxRadix = 0;
+  for(size_t i = 0; factors_[i] != 0; i += 2) {
+    if(factors_[i] > maxRadix) {
+      maxRadix = factors_[i];
+    }
+    if(factors_[i + 1] == 1) {
+      break;
+    }
+  }
+
+  try {
+    twiddles_      = new ecmcFFTFixedCpx[nfft_];
+    scratch_       = new ecmcFFTFixedCpx[maxRadix];
+    result_        = new ecmcFFTFixedCpx[nfft_];
+    splitTwiddles_ = new std::complex<float>[nfft_ / 2 + 1];
+  }
+  catch(std::bad_alloc& e) {
+    delete[] twiddles_;
+    delete[] scratch_;
+    delete[] result_;
+    delete[] splitTwiddles_;
+    throw;
+  }
+
+  double sign = inverse_ ? 1.0 : -1.0;
+  for(size_t i = 0; i < nfft_; ++i) {
+    double phase = sign * 2 * M_PI * (double)i / (double)nfft_;
+    twiddles_[i].r = (int32_t)floor(0.5 + ECMC_FFT_FIXED_ONE * cos(phase));
+    twiddles_[i].i = (int32_t)floor(0.5 + ECMC_FFT_FIXED_ONE * sin(phase));
+  }
+
+  // Real input of 2*nfft samples (see transformReal())
+  for(size_t k = 0; k <= nfft_ / 2; ++k) {
+    double phase = sign * M_PI * ((double)k / (double)nfft_ + 0.5);
+    splitTwiddles_[k] = std::complex<float>((float)cos(phase), (float)sin(phase));
+  }
+}
+
+ecmcFFTFixed::~ecmcFFTFixed() {
+  delete[] twiddles_;
+  delete[] scratch_;
+  delete[] result_;
+  delete[] splitTwiddles_;
+}
+
+// Radix 4 first, then 2, 3, 5,... (pairs of radix and remaining size)
+void ecmcFFTFixed::factor(size_t n) {
+  size_t p         = 4;
+  size_t floorSqrt = (size_t)floor(sqrt((double)n));
+  size_t i         = 0;
+  do {
+    while(n % p) {
+      switch(p) {
+        case 4:
+          p = 2;
+          break;
+        case 2:
+          p = 3;
+          break;
+        default:
+          p += 2;
+          break;
+      }
+      if(p > floorSqrt) {
+        p = n;
+      }
+    }
+    n /= p;
+    factors_[i++] = p;
+    factors_[i++] = n;
+  } while(n > 1);
+}
+
+void ecmcFFTFixed::transform(const ecmcFFTFixedCpx* src, ecmcFFTFixedCpx* dst) {
+  work(dst, src, 1, factors_);
+}
+
+/** One stage (recursive, decimation in time). Sub transforms of size m are
+ *  calculated first and then combined with p point butterflies.
+*/
+void ecmcFFTFixed::work(ecmcFFTFixedCpx*       dst,
+                        const ecmcFFTFixedCpx* src,
+                        size_t                 fstride,
+                        const size_t*          factors) {
+  size_t                 p   = factors[0];
+  size_t                 m   = factors[1];
+  ecmcFFTFixedCpx*       out = dst;
+  const ecmcFFTFixedCpx* end = dst + p * m;
+
+  if(m == 1) {
+    do {
+      *out = *src;
+      src += fstride;
+    } while(++out != end);
+  } else {
+    do {
+      work(out, src, fstride * p, factors + 2);
+      src += fstride;
+    } while((out += m) != end);
+  }
+
+  switch(p) {
+    case 2:
+      bfly2(dst, fstride, m);
+      break;
+    case 4:
+      bfly4(dst, fstride, m);
+      break;
+    default:
+      bflyGeneric(dst, fstride, m, p);
+      break;
+  }
+}
+
+void ecmcFFTFixed::bfly2(ecmcFFTFixedCpx* dst, size_t fstride, size_t m) {
+  ecmcFFTFixedCpx*       dst2 = dst + m;
+  const ecmcFFTFixedCpx* tw   = twiddles_;
+  ecmcFFTFixedCpx        t;
+  for(size_t k = 0; k < m; ++k) {
+    fixedShift(&dst[k], 1);
+    fixedShift(&dst2[k], 1);
+    fixedMul(&t, dst2[k], *tw);
+    tw += fstride;
+    dst2[k].r = dst[k].r - t.r;
+    dst2[k].i = dst[k].i - t.i;
+    dst[k].r += t.r;
+    dst[k].i += t.i;
+  }
+}
+
+void ecmcFFTFixed::bfly4(ecmcFFTFixedCpx* dst, size_t fstride, size_t m) {
+  const ecmcFFTFixedCpx* tw1 = twiddles_;
+  const ecmcFFTFixedCpx* tw2 = twiddles_;
+  const ecmcFFTFixedCpx* tw3 = twiddles_;
+  size_t                 m2  = 2 * m;
+  size_t                 m3  = 3 * m;
+  ecmcFFTFixedCpx        s[6];
+
+  for(size_t k = 0; k < m; ++k) {
+    ecmcFFTFixedCpx* f = dst + k;
+    fixedShift(&f[0], 2);
+    fixedShift(&f[m], 2);
+    fixedShift(&f[m2], 2);
+    fixedShift(&f[m3], 2);
+
+    fixedMul(&s[0], f[m], *tw1);
+    fixedMul(&s[1], f[m2], *tw2);
+    fixedMul(&s[2], f[m3], *tw3);
+
+    s[5].r = f[0].r - s[1].r;
+    s[5].i = f[0].i - s[1].i;
+    f[0].r += s[1].r;
+    f[0].i += s[1].i;
+    s[3].r = s[0].r + s[2].r;
+    s[3].i = s[0].i + s[2].i;
+    s[4].r = s[0].r - s[2].r;
+    s[4].i = s[0].i - s[2].i;
+    f[m2].r = f[0].r - s[3].r;
+    f[m2].i = f[0].i - s[3].i;
+    tw1 += fstride;
+    tw2 += fstride * 2;
+    tw3 += fstride * 3;
+    f[0].r += s[3].r;
+    f[0].i += s[3].i;
+
+    if(inverse_) {
+      f[m].r  = s[5].r - s[4].i;
+      f[m].i  = s[5].i + s[4].r;
+      f[m3].r = s[5].r + s[4].i;
+      f[m3].i = s[5].i - s[4].r;
+    } else {
+      f[m].r  = s[5].r + s[4].i;
+      f[m].i  = s[5].i - s[4].r;
+      f[m3].r = s[5].r - s[4].i;
+      f[m3].i = s[5].i + s[4].r;
+    }
+  }
+}
+
+// Any radix (3, 5, 7,...). Scaled by 1/p (multiply with Q31 1/p)
+void ecmcFFTFixed::bflyGeneric(ecmcFFTFixedCpx* dst, size_t fstride, size_t m, size_t p) {
+  int32_t         div = (int32_t)(ECMC_FFT_FIXED_ONE / p);
+  ecmcFFTFixedCpx t;
+
+  for(size_t u = 0; u < m; ++u) {
+    size_t k = u;
+    for(size_t q1 = 0; q1 < p; ++q1) {
+      scratch_[q1].r = fixedRound((int64_t)dst[k].r * div);
+      scratch_[q1].i = fixedRound((int64_t)dst[k].i * div);
+      k += m;
+    }
+
+    k = u;
+    for(size_t q1 = 0; q1 < p; ++q1) {
+      size_t twIndex = 0;
+      dst[k] = scratch_[0];
+      for(size_t q = 1; q < p; ++q) {
+        twIndex += fstride * k;
+        if(twIndex >= nfft_) {
+          twIndex -= nfft_;
+        }
+        fixedMul(&t, scratch_[q], twiddles_[twIndex]);
+        dst[k].r += t.r;
+        dst[k].i += t.i;
+      }
+      k += m;
+    }
+  }
+}
+
+/** Even and odd samples as real and imaginary part of an nfft complex
+ *  transform. The spectrum of the real data is split from the complex result
+ *  in float (with the scale), so the conversion is only made on the output
+ *  bins.
+*/
+void ecmcFFTFixed::transformReal(const int32_t*       src,
+                                 std::complex<float>* dst,
+                                 double               scale) {
+  transform((const ecmcFFTFixedCpx*)src, result_);
+
+  // Result is DFT/nfft
+  float f = (float)(scale * (double)nfft_);
+  float h = 0.5f * f;
+
+  dst[0]     = std::complex<float>((float)result_[0].r * f + (float)result_[0].i * f, 0);
+  dst[nfft_] = std::complex<float>((float)result_[0].r * f - (float)result_[0].i * f, 0);
+
+  for(size_t k = 1; k <= nfft_ / 2; ++k) {
+    std::complex<float> fpk((float)result_[k].r, (float)result_[k].i);
+    std::complex<float> fpnk((float)result_[nfft_ - k].r, -(float)result_[nfft_ - k].i);
+    std::complex<float> f1k = fpk + fpnk;
+    std::complex<float> tw  = (fpk - fpnk) * splitTwiddles_[k];
+    dst[k]         = (f1k + tw) * h;
+    dst[nfft_ - k] = std::conj(f1k - tw) * h;
+  }
+}
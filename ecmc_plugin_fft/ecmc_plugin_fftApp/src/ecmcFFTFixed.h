@@ -0,0 +1,78 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTFixed.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_FIXED_H_
+#define ECMC_FFT_FIXED_H_
+
+#include <stdexcept>
+#include <stdint.h>
+#include <stddef.h>
+#include <complex>
+
+#define ECMC_FFT_FIXED_ONE 2147483647  // 1.0 in Q31
+
+// Largest input sample (Q31) that can not overflow in the transform
+#define ECMC_FFT_FIXED_INPUT_MAX (1 << 30)
+
+// Complex Q31 value
+typedef struct ecmcFFTFixedCpx {
+  int32_t               r;
+  int32_t               i;
+} ecmcFFTFixedCpx;
+
+class ecmcFFTFixed {
+ public:
+
+  /** ecmc FFT fixed point transform
+   * Mixed radix complex FFT of nfft points in Q31 (same structure as
+   * kissfft with FIXED_POINT=32). Each stage is scaled by 1/radix and
+   * products are 64 bit, so output is DFT/nfft and can not overflow for
+   * input within +-ECMC_FFT_FIXED_INPUT_MAX.
+   * This object can throw:
+   *    - bad_alloc
+   *    - out_of_range
+  */
+  ecmcFFTFixed(size_t nfft,
+               bool   inverse);
+  ~ecmcFFTFixed();
+
+  // dst = DFT(src)/nfft (src and dst nfft long, not in place)
+  void                  transform(const ecmcFFTFixedCpx* src,
+                                  ecmcFFTFixedCpx*       dst);
+
+  /** Real input of 2*nfft samples (Q31) transformed as nfft complex.
+   *  Output is converted to float (dst = DFT(src)*scale) only for the
+   *  nfft+1 bins (DC..nyquist).
+  */
+  void                  transformReal(const int32_t*       src,
+                                      std::complex<float>* dst,
+                                      double               scale);
+
+ private:
+  void                  factor(size_t n);
+  void                  work(ecmcFFTFixedCpx*       dst,
+                             const ecmcFFTFixedCpx* src,
+                             size_t                 fstride,
+                             const size_t*          factors);
+  void                  bfly2(ecmcFFTFixedCpx* dst, size_t fstride, size_t m);
+  void                  bfly4(ecmcFFTFixedCpx* dst, size_t fstride, size_t m);
+  void                  bflyGeneric(ecmcFFTFixedCpx* dst, size_t fstride, size_t m, size_t p);
+
+  size_t                nfft_;
+  bool                  inverse_;
+  size_t                factors_[64];        // Radix and remaining size per stage
+  ecmcFFTFixedCpx*      twiddles_;           // Q31, nfft
+  ecmcFFTFixedCpx*      scratch_;            // Generic butterfly (largest radix)
+  ecmcFFTFixedCpx*      result_;             // Complex result of transformReal()
+  std::complex<float>*  splitTwiddles_;      // Real split of transformReal()
+};
+
+#endif  /* ECMC_FFT_FIXED_H_ */
@@ -0,0 +1,637 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTSimd.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <math.h>
+#include "ecmcFFTSimd.h"
+
+#if defined(__x86_64__)
+#define ECMC_FFT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ECMC_FFT_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* Scalar butterflies (also tails of the vectorized kernels), same operation
+ * order as kissfft. Explicit complex multiply (no inf/nan handling).
+*/
+template<typename T>
+static inline std::complex<T> cmul(const std::complex<T>& a, const std::complex<T>& b) {
+  return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(),
+                         a.real() * b.imag() + a.imag() * b.real());
+}
+
+template<typename T>
+static void bfly2Range(std::complex<T>*       f,
+                       const std::complex<T>* tw,
+                       size_t                 fstride,
+                       size_t                 m,
+                       size_t                 k) {
+  for(; k < m; ++k) {
+    std::complex<T> t = cmul(f[k + m], tw[k * fstride]);
+    f[k + m] = f[k] - t;
+    f[k]    += t;
+  }
+}
+
+template<typename T>
+static void bfly4Range(std::complex<T>*       f,
+                       const std::complex<T>* tw,
+                       size_t                 fstride,
+                       size_t                 m,
+                       int                    inverse,
+                       size_t                 k) {
+  for(; k < m; ++k) {
+    std::complex<T> s0 = cmul(f[k + m],     tw[k * fstride]);
+    std::complex<T> s1 = cmul(f[k + 2 * m], tw[k * fstride * 2]);
+    std::complex<T> s2 = cmul(f[k + 3 * m], tw[k * fstride * 3]);
+    std::complex<T> s5 = f[k] - s1;
+    std::complex<T> f0 = f[k] + s1;
+    std::complex<T> s3 = s0 + s2;
+    std::complex<T> s4 = s0 - s2;
+    s4 = inverse ? std::complex<T>(-s4.imag(), s4.real()) :
+                   std::complex<T>(s4.imag(), -s4.real());
+    f[k + 2 * m] = f0 - s3;
+    f[k]         = f0 + s3;
+    f[k + m]     = s5 + s4;
+    f[k + 3 * m] = s5 - s4;
+  }
+}
+
+template<typename T>
+static void bfly2Scalar(std::complex<T>* f, const std::complex<T>* tw,
+                        size_t fstride, size_t m, int /*inverse*/) {
+  bfly2Range(f, tw, fstride, m, 0);
+}
+
+template<typename T>
+static void bfly4Scalar(std::complex<T>* f, const std::complex<T>* tw,
+                        size_t fstride, size_t m, int inverse) {
+  bfly4Range(f, tw, fstride, m, inverse, 0);
+}
+
+#ifdef ECMC_FFT_SIMD_X86
+
+/* SSE2 (baseline of x86-64). Double: one complex per vector,
+ * float: two complex per vector (k and k+1).
+*/
+static inline __m128d cmulSse2(__m128d a, __m128d b) {
+  __m128d ar = _mm_unpacklo_pd(a, a);
+  __m128d ai = _mm_unpackhi_pd(a, a);
+  __m128d bs = _mm_shuffle_pd(b, b, 1);
+  __m128d t  = _mm_xor_pd(_mm_mul_pd(ai, bs), _mm_set_pd(0.0, -0.0));
+  return _mm_add_pd(_mm_mul_pd(ar, b), t);
+}
+
+// Multiply with -i (forward) or i (inverse), sign selects lane to negate
+static inline __m128d rotSse2(__m128d x, __m128d sign) {
+  return _mm_xor_pd(_mm_shuffle_pd(x, x, 1), sign);
+}
+
+static void bfly2Sse2(std::complex<double>* f, const std::complex<double>* tw,
+                      size_t fstride, size_t m, int /*inverse*/) {
+  double* p = (double*)f;
+  for(size_t k = 0; k < m; ++k) {
+    __m128d a = _mm_loadu_pd(p + 2 * k);
+    __m128d b = _mm_loadu_pd(p + 2 * (k + m));
+    __m128d t = cmulSse2(b, _mm_loadu_pd((const double*)&tw[k * fstride]));
+    _mm_storeu_pd(p + 2 * (k + m), _mm_sub_pd(a, t));
+    _mm_storeu_pd(p + 2 * k,       _mm_add_pd(a, t));
+  }
+}
+
+static void bfly4Sse2(std::complex<double>* f, const std::complex<double>* tw,
+                      size_t fstride, size_t m, int inverse) {
+  double* p    = (double*)f;
+  __m128d sign = inverse ? _mm_set_pd(0.0, -0.0) : _mm_set_pd(-0.0, 0.0);
+  for(size_t k = 0; k < m; ++k) {
+    __m128d f0 = _mm_loadu_pd(p + 2 * k);
+    __m128d s0 = cmulSse2(_mm_loadu_pd(p + 2 * (k + m)),
+                          _mm_loadu_pd((const double*)&tw[k * fstride]));
+    __m128d s1 = cmulSse2(_mm_loadu_pd(p + 2 * (k + 2 * m)),
+                          _mm_loadu_pd((const double*)&tw[k * fstride * 2]));
+    __m128d s2 = cmulSse2(_mm_loadu_pd(p + 2 * (k + 3 * m)),
+                          _mm_loadu_pd((const double*)&tw[k * fstride * 3]));
+    __m128d s5 = _mm_sub_pd(f0, s1);
+    f0         = _mm_add_pd(f0, s1);
+    __m128d s3 = _mm_add_pd(s0, s2);
+    __m128d s4 = rotSse2(_mm_sub_pd(s0, s2), sign);
+    _mm_storeu_pd(p + 2 * (k + 2 * m), _mm_sub_pd(f0, s3));
+    _mm_storeu_pd(p + 2 * k,           _mm_add_pd(f0, s3));
+    _mm_storeu_pd(p + 2 * (k + m),     _mm_add_pd(s5, s4));
+    _mm_storeu_pd(p + 2 * (k + 3 * m), _mm_sub_pd(s5, s4));
+  }
+}
+
+static inline __m128 cmulSse2(__m128 a, __m128 b) {
+  __m128 ar = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0));
+  __m128 ai = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1));
+  __m128 bs = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 t  = _mm_xor_ps(_mm_mul_ps(ai, bs), _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+  return _mm_add_ps(_mm_mul_ps(ar, b), t);
+}
+
+static inline __m128 rotSse2(__m128 x, __m128 sign) {
+  return _mm_xor_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)), sign);
+}
+
+// Twiddles of k and k+1 (stride)
+static inline __m128 loadTwSse2(const std::complex<float>* tw, size_t k, size_t stride) {
+  __m128 lo = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&tw[k * stride]);
+  return _mm_loadh_pi(lo, (const __m64*)&tw[(k + 1) * stride]);
+}
+
+static void bfly2Sse2(std::complex<float>* f, const std::complex<float>* tw,
+                      size_t fstride, size_t m, int /*inverse*/) {
+  float* p = (float*)f;
+  size_t k = 0;
+  for(; k + 2 <= m; k += 2) {
+    __m128 a = _mm_loadu_ps(p + 2 * k);
+    __m128 b = _mm_loadu_ps(p + 2 * (k + m));
+    __m128 t = cmulSse2(b, loadTwSse2(tw, k, fstride));
+    _mm_storeu_ps(p + 2 * (k + m), _mm_sub_ps(a, t));
+    _mm_storeu_ps(p + 2 * k,       _mm_add_ps(a, t));
+  }
+  bfly2Range(f, tw, fstride, m, k);
+}
+
+static void bfly4Sse2(std::complex<float>* f, const std::complex<float>* tw,
+                      size_t fstride, size_t m, int inverse) {
+  float* p    = (float*)f;
+  __m128 sign = inverse ? _mm_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f) :
+                          _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+  size_t k    = 0;
+  for(; k + 2 <= m; k += 2) {
+    __m128 f0 = _mm_loadu_ps(p + 2 * k);
+    __m128 s0 = cmulSse2(_mm_loadu_ps(p + 2 * (k + m)),     loadTwSse2(tw, k, fstride));
+    __m128 s1 = cmulSse2(_mm_loadu_ps(p + 2 * (k + 2 * m)), loadTwSse2(tw, k, fstride * 2));
+    __m128 s2 = cmulSse2(_mm_loadu_ps(p + 2 * (k + 3 * m)), loadTwSse2(tw, k, fstride * 3));
+    __m128 s5 = _mm_sub_ps(f0, s1);
+    f0        = _mm_add_ps(f0, s1);
+    __m128 s3 = _mm_add_ps(s0, s2);
+    __m128 s4 = rotSse2(_mm_sub_ps(s0, s2), sign);
+    _mm_storeu_ps(p + 2 * (k + 2 * m), _mm_sub_ps(f0, s3));
+    _mm_storeu_ps(p + 2 * k,           _mm_add_ps(f0, s3));
+    _mm_storeu_ps(p + 2 * (k + m),     _mm_add_ps(s5, s4));
+    _mm_storeu_ps(p + 2 * (k + 3 * m), _mm_sub_ps(s5, s4));
+  }
+  bfly4Range(f, tw, fstride, m, inverse, k);
+}
+
+/* AVX2 and FMA (runtime detected). Double: two complex per vector,
+ * float: four complex per vector. Results differ from scalar in rounding (FMA).
+*/
+#define ECMC_FFT_AVX2 __attribute__((target("avx2,fma")))
+
+ECMC_FFT_AVX2 static inline __m256d cmulAvx2(__m256d a, __m256d b) {
+  __m256d ar = _mm256_movedup_pd(a);
+  __m256d ai = _mm256_permute_pd(a, 0xF);
+  __m256d bs = _mm256_permute_pd(b, 0x5);
+  return _mm256_fmaddsub_pd(ar, b, _mm256_mul_pd(ai, bs));
+}
+
+ECMC_FFT_AVX2 static inline __m256d rotAvx2(__m256d x, __m256d sign) {
+  return _mm256_xor_pd(_mm256_permute_pd(x, 0x5), sign);
+}
+
+ECMC_FFT_AVX2 static inline __m256d loadTwAvx2(const std::complex<double>* tw, size_t k, size_t stride) {
+  __m128d lo = _mm_loadu_pd((const double*)&tw[k * stride]);
+  __m128d hi = _mm_loadu_pd((const double*)&tw[(k + 1) * stride]);
+  return _mm256_insertf128_pd(_mm256_castpd128_pd256(lo), hi, 1);
+}
+
+ECMC_FFT_AVX2 static void bfly2Avx2(std::complex<double>* f, const std::complex<double>* tw,
+                                    size_t fstride, size_t m, int /*inverse*/) {
+  double* p = (double*)f;
+  size_t  k = 0;
+  for(; k + 2 <= m; k += 2) {
+    __m256d a = _mm256_loadu_pd(p + 2 * k);
+    __m256d b = _mm256_loadu_pd(p + 2 * (k + m));
+    __m256d t = cmulAvx2(b, loadTwAvx2(tw, k, fstride));
+    _mm256_storeu_pd(p + 2 * (k + m), _mm256_sub_pd(a, t));
+    _mm256_storeu_pd(p + 2 * k,       _mm256_add_pd(a, t));
+  }
+  _mm256_zeroupper();  // Avoid AVX to SSE transition penalty in scalar tail
+  bfly2Range(f, tw, fstride, m, k);
+}
+
+ECMC_FFT_AVX2 static void bfly4Avx2(std::complex<double>* f, const std::complex<double>* tw,
+                                    size_t fstride, size_t m, int inverse) {
+  double* p    = (double*)f;
+  __m256d sign = inverse ? _mm256_setr_pd(-0.0, 0.0, -0.0, 0.0) :
+                           _mm256_setr_pd(0.0, -0.0, 0.0, -0.0);
+  size_t  k    = 0;
+  for(; k + 2 <= m; k += 2) {
+    __m256d f0 = _mm256_loadu_pd(p + 2 * k);
+    __m256d s0 = cmulAvx2(_mm256_loadu_pd(p + 2 * (k + m)),     loadTwAvx2(tw, k, fstride));
+    __m256d s1 = cmulAvx2(_mm256_loadu_pd(p + 2 * (k + 2 * m)), loadTwAvx2(tw, k, fstride * 2));
+    __m256d s2 = cmulAvx2(_mm256_loadu_pd(p + 2 * (k + 3 * m)), loadTwAvx2(tw, k, fstride * 3));
+    __m256d s5 = _mm256_sub_pd(f0, s1);
+    f0         = _mm256_add_pd(f0, s1);
+    __m256d s3 = _mm256_add_pd(s0, s2);
+    __m256d s4 = rotAvx2(_mm256_sub_pd(s0, s2), sign);
+    _mm256_storeu_pd(p + 2 * (k + 2 * m), _mm256_sub_pd(f0, s3));
+    _mm256_storeu_pd(p + 2 * k,           _mm256_add_pd(f0, s3));
+    _mm256_storeu_pd(p + 2 * (k + m),     _mm256_add_pd(s5, s4));
+    _mm256_storeu_pd(p + 2 * (k + 3 * m), _mm256_sub_pd(s5, s4));
+  }
+  _mm256_zeroupper();
+  bfly4Range(f, tw, fstride, m, inverse, k);
+}
+
+ECMC_FFT_AVX2 static inline __m256 cmulAvx2(__m256 a, __m256 b) {
+  __m256 ar = _mm256_moveldup_ps(a);
+  __m256 ai = _mm256_movehdup_ps(a);
+  __m256 bs = _mm256_permute_ps(b, 0xB1);
+  return _mm256_fmaddsub_ps(ar, b, _mm256_mul_ps(ai, bs));
+}
+
+ECMC_FFT_AVX2 static inline __m256 rotAvx2(__m256 x, __m256 sign) {
+  return _mm256_xor_ps(_mm256_permute_ps(x, 0xB1), sign);
+}
+
+// Twiddles of k..k+3 (stride)
+ECMC_FFT_AVX2 static inline __m256 loadTwAvx2(const std::complex<float>* tw, size_t k, size_t stride) {
+  if(stride == 1) {
+    return _mm256_loadu_ps((const float*)&tw[k]);
+  }
+  __m128 lo = loadTwSse2(tw, k, stride);
+  __m128 hi = loadTwSse2(tw, k + 2, stride);
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+}
+
+ECMC_FFT_AVX2 static void bfly2Avx2(std::complex<float>* f, const std::complex<float>* tw,
+                                    size_t fstride, size_t m, int /*inverse*/) {
+  float* p = (float*)f;
+  size_t k = 0;
+  for(; k + 4 <= m; k += 4) {
+    __m256 a = _mm256_loadu_ps(p + 2 * k);
+    __m256 b = _mm256_loadu_ps(p + 2 * (k + m));
+    __m256 t = cmulAvx2(b, loadTwAvx2(tw, k, fstride));
+    _mm256_storeu_ps(p + 2 * (k + m), _mm256_sub_ps(a, t));
+    _mm256_storeu_ps(p + 2 * k,       _mm256_add_ps(a, t));
+  }
+  _mm256_zeroupper();  // Avoid AVX to SSE transition penalty in scalar tail
+  bfly2Range(f, tw, fstride, m, k);
+}
+
+ECMC_FFT_AVX2 static void bfly4Avx2(std::complex<float>* f, const std::complex<float>* tw,
+                                    size_t fstride, size_t m, int inverse) {
+  float* p    = (float*)f;
+  __m256 sign = inverse ? _mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f) :
+                          _mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f);
+  size_t k    = 0;
+  for(; k + 4 <= m; k += 4) {
+    __m256 f0 = _mm256_loadu_ps(p + 2 * k);
+    __m256 s0 = cmulAvx2(_mm256_loadu_ps(p + 2 * (k + m)),     loadTwAvx2(tw, k, fstride));
+    __m256 s1 = cmulAvx2(_mm256_loadu_ps(p + 2 * (k + 2 * m)), loadTwAvx2(tw, k, fstride * 2));
+    __m256 s2 = cmulAvx2(_mm256_loadu_ps(p + 2 * (k + 3 * m)), loadTwAvx2(tw, k, fstride * 3));
+    __m256 s5 = _mm256_sub_ps(f0, s1);
+    f0        = _mm256_add_ps(f0, s1);
+    __m256 s3 = _mm256_add_ps(s0, s2);
+    __m256 s4 = rotAvx2(_mm256_sub_ps(s0, s2), sign);
+    _mm256_storeu_ps(p + 2 * (k + 2 * m), _mm256_sub_ps(f0, s3));
+    _mm256_storeu_ps(p + 2 * k,           _mm256_add_ps(f0, s3));
+    _mm256_storeu_ps(p + 2 * (k + m),     _mm256_add_ps(s5, s4));
+    _mm256_storeu_ps(p + 2 * (k + 3 * m), _mm256_sub_ps(s5, s4));
+  }
+  _mm256_zeroupper();
+  bfly4Range(f, tw, fstride, m, inverse, k);
+}
+
+#endif  // ECMC_FFT_SIMD_X86
+
+#ifdef ECMC_FFT_SIMD_NEON
+
+/* NEON (enabled at compile time). Float: two complex per vector,
+ * double (aarch64 only): one complex per vector.
+*/
+static inline float32x4_t cmulNeon(float32x4_t a, float32x4_t b) {
+  static const float sign[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+  float32x4x2_t dup = vtrnq_f32(a, a);       // Real and imag parts duplicated
+  float32x4_t   t   = vmulq_f32(vmulq_f32(dup.val[1], vrev64q_f32(b)), vld1q_f32(sign));
+  return vmlaq_f32(t, dup.val[0], b);
+}
+
+static inline float32x4_t rotNeon(float32x4_t x, float32x4_t sign) {
+  return vmulq_f32(vrev64q_f32(x), sign);
+}
+
+static inline float32x4_t loadTwNeon(const std::complex<float>* tw, size_t k, size_t stride) {
+  return vcombine_f32(vld1_f32((const float*)&tw[k * stride]),
+                      vld1_f32((const float*)&tw[(k + 1) * stride]));
+}
+
+static void bfly2Neon(std::complex<float>* f, const std::complex<float>* tw,
+                      size_t fstride, size_t m, int /*inverse*/) {
+  float* p = (float*)f;
+  size_t k = 0;
+  for(; k + 2 <= m; k += 2) {
+    float32x4_t a = vld1q_f32(p + 2 * k);
+    float32x4_t b = vld1q_f32(p + 2 * (k + m));
+    float32x4_t t = cmulNeon(b, loadTwNeon(tw, k, fstride));
+    vst1q_f32(p + 2 * (k + m), vsubq_f32(a, t));
+    vst1q_f32(p + 2 * k,       vaddq_f32(a, t));
+  }
+  bfly2Range(f, tw, fstride, m, k);
+}
+
+static void bfly4Neon(std::complex<float>* f, const std::complex<float>* tw,
+                      size_t fstride, size_t m, int inverse) {
+  static const float signFwd[4] = {1.0f, -1.0f, 1.0f, -1.0f};
+  static const float signInv[4] = {-1.0f, 1.0f, -1.0f, 1.0f};
+  float*      p    = (float*)f;
+  float32x4_t sign = vld1q_f32(inverse ? signInv : signFwd);
+  size_t      k    = 0;
+  for(; k + 2 <= m; k += 2) {
+    float32x4_t f0 = vld1q_f32(p + 2 * k);
+    float32x4_t s0 = cmulNeon(vld1q_f32(p + 2 * (k + m)),     loadTwNeon(tw, k, fstride));
+    float32x4_t s1 = cmulNeon(vld1q_f32(p + 2 * (k + 2 * m)), loadTwNeon(tw, k, fstride * 2));
+    float32x4_t s2 = cmulNeon(vld1q_f32(p + 2 * (k + 3 * m)), loadTwNeon(tw, k, fstride * 3));
+    float32x4_t s5 = vsubq_f32(f0, s1);
+    f0             = vaddq_f32(f0, s1);
+    float32x4_t s3 = vaddq_f32(s0, s2);
+    float32x4_t s4 = rotNeon(vsubq_f32(s0, s2), sign);
+    vst1q_f32(p + 2 * (k + 2 * m), vsubq_f32(f0, s3));
+    vst1q_f32(p + 2 * k,           vaddq_f32(f0, s3));
+    vst1q_f32(p + 2 * (k + m),     vaddq_f32(s5, s4));
+    vst1q_f32(p + 2 * (k + 3 * m), vsubq_f32(s5, s4));
+  }
+  bfly4Range(f, tw, fstride, m, inverse, k);
+}
+
+// NEON kernels of type (resolved at compile time, see getKernels())
+static int getNeonKernels(ecmcFFTSimd<float>::BflyFunc* bfly2,
+                          ecmcFFTSimd<float>::BflyFunc* bfly4) {
+  *bfly2 = bfly2Neon;
+  *bfly4 = bfly4Neon;
+  return 1;
+}
+
+#if defined(__aarch64__)
+static inline float64x2_t cmulNeon(float64x2_t a, float64x2_t b) {
+  static const double sign[2] = {-1.0, 1.0};
+  float64x2_t t = vmulq_f64(vmulq_f64(vdupq_laneq_f64(a, 1), vextq_f64(b, b, 1)), vld1q_f64(sign));
+  return vfmaq_f64(t, vdupq_laneq_f64(a, 0), b);
+}
+
+static inline float64x2_t rotNeon(float64x2_t x, float64x2_t sign) {
+  return vmulq_f64(vextq_f64(x, x, 1), sign);
+}
+
+static void bfly2Neon(std::complex<double>* f, const std::complex<double>* tw,
+                      size_t fstride, size_t m, int /*inverse*/) {
+  double* p = (double*)f;
+  for(size_t k = 0; k < m; ++k) {
+    float64x2_t a = vld1q_f64(p + 2 * k);
+    float64x2_t b = vld1q_f64(p + 2 * (k + m));
+    float64x2_t t = cmulNeon(b, vld1q_f64((const double*)&tw[k * fstride]));
+    vst1q_f64(p + 2 * (k + m), vsubq_f64(a, t));
+    vst1q_f64(p + 2 * k,       vaddq_f64(a, t));
+  }
+}
+
+static void bfly4Neon(std::complex<double>* f, const std::complex<double>* tw,
+                      size_t fstride, size_t m, int inverse) {
+  static const double signFwd[2] = {1.0, -1.0};
+  static const double signInv[2] = {-1.0, 1.0};
+  double*     p    = (double*)f;
+  float64x2_t sign = vld1q_f64(inverse ? signInv : signFwd);
+  for(size_t k = 0; k < m; ++k) {
+    float64x2_t f0 = vld1q_f64(p + 2 * k);
+    float64x2_t s0 = cmulNeon(vld1q_f64(p + 2 * (k + m)),
+                              vld1q_f64((const double*)&tw[k * fstride]));
+    float64x2_t s1 = cmulNeon(vld1q_f64(p + 2 * (k + 2 * m)),
+                              vld1q_f64((const double*)&tw[k * fstride * 2]));
+    float64x2_t s2 = cmulNeon(vld1q_f64(p + 2 * (k + 3 * m)),
+                              vld1q_f64((const double*)&tw[k * fstride * 3]));
+    float64x2_t s5 = vsubq_f64(f0, s1);
+    f0             = vaddq_f64(f0, s1);
+    float64x2_t s3 = vaddq_f64(s0, s2);
+    float64x2_t s4 = rotNeon(vsubq_f64(s0, s2), sign);
+    vst1q_f64(p + 2 * (k + 2 * m), vsubq_f64(f0, s3));
+    vst1q_f64(p + 2 * k,           vaddq_f64(f0, s3));
+    vst1q_f64(p + 2 * (k + m),     vaddq_f64(s5, s4));
+    vst1q_f64(p + 2 * (k + 3 * m), vsubq_f64(s5, s4));
+  }
+}
+
+static int getNeonKernels(ecmcFFTSimd<double>::BflyFunc* bfly2,
+                          ecmcFFTSimd<double>::BflyFunc* bfly4) {
+  *bfly2 = bfly2Neon;
+  *bfly4 = bfly4Neon;
+  return 1;
+}
+#else
+// No double vectors on 32-bit ARM
+static int getNeonKernels(ecmcFFTSimd<double>::BflyFunc* /*bfly2*/,
+                          ecmcFFTSimd<double>::BflyFunc* /*bfly4*/) {
+  return 0;
+}
+#endif  // __aarch64__
+
+#endif  // ECMC_FFT_SIMD_NEON
+
+/** kissfft compatible transform with vectorized radix 2 and 4 butterflies
+ * This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument (kernels not supported by cpu)
+*/
+template<typename T>
+ecmcFFTSimd<T>::ecmcFFTSimd(size_t nfft, bool inverse, FFT_SIMD simd) {
+  nfft_    = nfft;
+  inverse_ = inverse;
+  simd_    = simd == SIMD_AUTO ? detectSimd() : simd;
+  kiss_    = NULL;
+  bfly2_   = NULL;
+  bfly4_   = NULL;
+
+  if(!getKernels(simd_, &bfly2_, &bfly4_)) {
+    throw std::invalid_argument("SIMD kernels not supported.");
+  }
+
+  // Factors 4 first, then 2 (as kissfft). Other sizes are left to kissfft
+  size_t n = nfft_;
+  while(n > 1) {
+    size_t p = n % 4 == 0 && n != 2 ? 4 : 2;
+    if(n % p) {
+      break;
+    }
+    n /= p;
+    stageRadix_.push_back(p);
+    stageRemainder_.push_back(n);
+  }
+  if(n != 1 || nfft_ <= 1) {
+    stageRadix_.clear();
+    stageRemainder_.clear();
+    kiss_  = new kissfft<T>(nfft_, inverse_);
+    simd_  = SIMD_NONE;
+    return;
+  }
+
+  // Twiddles calculated in double also for float
+  twiddles_.resize(nfft_);
+  double phaseInc = (inverse_ ? 2 : -2) * M_PI / (double)nfft_;
+  for(size_t i = 0; i < nfft_; ++i) {
+    twiddles_[i] = cpx_t((T)cos(phaseInc * (double)i), (T)sin(phaseInc * (double)i));
+  }
+
+  // Half steps for the split of transform_real()
+  realTwiddles_.resize(nfft_ / 2 + 1);
+  for(size_t k = 0; k <= nfft_ / 2; ++k) {
+    realTwiddles_[k] = cpx_t((T)cos(0.5 * phaseInc * (double)k),
+                             (T)sin(0.5 * phaseInc * (double)k));
+  }
+}
+
+template<typename T>
+ecmcFFTSimd<T>::~ecmcFFTSimd() {
+  delete kiss_;
+}
+
+template<typename T>
+FFT_SIMD ecmcFFTSimd<T>::getSimd() {
+  return simd_;
+}
+
+template<typename T>
+void ecmcFFTSimd<T>::transform(const cpx_t* src, cpx_t* dst) {
+  if(kiss_) {
+    kiss_->transform(src, dst);
+    return;
+  }
+  work(dst, src, 1, 0);
+}
+
+// Recursive decimation in time (as kissfft::transform())
+template<typename T>
+void ecmcFFTSimd<T>::work(cpx_t* dst, const cpx_t* src, size_t fstride, size_t stage) {
+  size_t       p   = stageRadix_[stage];
+  size_t       m   = stageRemainder_[stage];
+  cpx_t*       out = dst;
+  const cpx_t* end = dst + p * m;
+
+  if(m == 1) {
+    do {
+      *out = *src;
+      src += fstride;
+    } while(++out != end);
+  } else {
+    do {
+      work(out, src, fstride * p, stage + 1);
+      src += fstride;
+    } while((out += m) != end);
+  }
+
+  if(p == 4) {
+    bfly4_(dst, &twiddles_[0], fstride, m, inverse_);
+  } else {
+    bfly2_(dst, &twiddles_[0], fstride, m, inverse_);
+  }
+}
+
+/** Real input of 2*nfft samples. DC and nyquist are packed in dst[0] (as
+ *  kissfft<T>::transform_real()).
+*/
+template<typename T>
+void ecmcFFTSimd<T>::transform_real(const T* src, cpx_t* dst) {
+  if(kiss_) {
+    kiss_->transform_real(src, dst);
+    return;
+  }
+
+  const size_t n = nfft_;
+  transform((const cpx_t*)src, dst);
+
+  dst[0] = cpx_t(dst[0].real() + dst[0].imag(), dst[0].real() - dst[0].imag());
+
+  for(size_t k = 1; 2 * k < n; ++k) {
+    cpx_t w = (T)0.5 * cpx_t(dst[k].real() + dst[n - k].real(),
+                             dst[k].imag() - dst[n - k].imag());
+    cpx_t z = (T)0.5 * cpx_t(dst[k].imag() + dst[n - k].imag(),
+                            -dst[k].real() + dst[n - k].real());
+    cpx_t tz = cmul(realTwiddles_[k], z);
+    dst[k]     = w + tz;
+    dst[n - k] = std::conj(w - tz);
+  }
+  if(n % 2 == 0) {
+    dst[n / 2] = std::conj(dst[n / 2]);
+  }
+}
+
+template<typename T>
+FFT_SIMD ecmcFFTSimd<T>::detectSimd() {
+  BflyFunc bfly2;
+  BflyFunc bfly4;
+  if(getKernels(SIMD_AVX2, &bfly2, &bfly4)) {
+    return SIMD_AVX2;
+  }
+  if(getKernels(SIMD_SSE2, &bfly2, &bfly4)) {
+    return SIMD_SSE2;
+  }
+  if(getKernels(SIMD_NEON, &bfly2, &bfly4)) {
+    return SIMD_NEON;
+  }
+  return SIMD_NONE;
+}
+
+template<typename T>
+const char* ecmcFFTSimd<T>::getSimdName(FFT_SIMD simd) {
+  switch(simd) {
+    case SIMD_NONE:
+      return "NONE";
+    case SIMD_SSE2:
+      return "SSE2";
+    case SIMD_AVX2:
+      return "AVX2";
+    case SIMD_NEON:
+      return "NEON";
+    default:
+      return "AUTO";
+  }
+}
+
+// Kernels of type T if compiled in and supported by cpu. Returns 1 if available
+template<typename T>
+int ecmcFFTSimd<T>::getKernels(FFT_SIMD simd, BflyFunc* bfly2, BflyFunc* bfly4) {
+  switch(simd) {
+    case SIMD_NONE:
+      *bfly2 = bfly2Scalar<T>;
+      *bfly4 = bfly4Scalar<T>;
+      return 1;
+#ifdef ECMC_FFT_SIMD_X86
+    case SIMD_SSE2:
+      *bfly2 = bfly2Sse2;
+      *bfly4 = bfly4Sse2;
+      return 1;
+    case SIMD_AVX2:
+      if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        return 0;
+      }
+      *bfly2 = bfly2Avx2;
+      *bfly4 = bfly4Avx2;
+      return 1;
+#endif
+#ifdef ECMC_FFT_SIMD_NEON
+    case SIMD_NEON:
+      return getNeonKernels(bfly2, bfly4);
+#endif
+    default:
+      return 0;
+  }
+  return 0;
+}
+
+template class ecmcFFTSimd<double>;
+template class ecmcFFTSimd<float>;
@@ -0,0 +1,82 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTSimd.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_SIMD_H_
+#define ECMC_FFT_SIMD_H_
+
+#include <stdexcept>
+#include <stddef.h>
+#include <complex>
+#include <vector>
+#include "kissfft/kissfft.hh"
+
+// Butterfly kernels (selected at runtime, see ecmcFFTSimd<T>::detectSimd())
+typedef enum FFT_SIMD{
+  SIMD_AUTO   = -1,  // Best supported by cpu
+  SIMD_NONE   = 0,   // Scalar
+  SIMD_SSE2   = 1,   // x86-64
+  SIMD_AVX2   = 2,   // x86-64 with AVX2 and FMA
+  SIMD_NEON   = 3,   // ARM (double only on aarch64)
+} FFT_SIMD;
+
+/** kissfft compatible transform with vectorized radix 2 and 4 butterflies.
+ *  Same factorization and output as kissfft<T> (T = double or float). Sizes
+ *  with other factors than 2 and 4 are calculated by kissfft<T>.
+ *  This object can throw:
+ *    - bad_alloc
+ *    - invalid_argument (requested kernels not supported by cpu)
+*/
+template<typename T>
+class ecmcFFTSimd {
+ public:
+  typedef std::complex<T> cpx_t;
+
+  // Kernel of one butterfly stage
+  typedef void (*BflyFunc)(cpx_t*       dst,
+                           const cpx_t* twiddles,
+                           size_t       fstride,
+                           size_t       m,
+                           int          inverse);
+
+  ecmcFFTSimd(size_t   nfft,
+              bool     inverse,
+              FFT_SIMD simd = SIMD_AUTO);
+  ~ecmcFFTSimd();
+
+  // Complex transform of nfft points (not in place)
+  void                  transform(const cpx_t* src, cpx_t* dst);
+  // Real input of 2*nfft samples, packed as kissfft<T>::transform_real()
+  void                  transform_real(const T* src, cpx_t* dst);
+  FFT_SIMD              getSimd();           // Kernels in use (SIMD_NONE if kissfft)
+
+  static FFT_SIMD       detectSimd();        // Best kernels supported by cpu
+  static const char*    getSimdName(FFT_SIMD simd);
+
+ private:
+  void                  work(cpx_t*       dst,
+                             const cpx_t* src,
+                             size_t       fstride,
+                             size_t       stage);
+  static int            getKernels(FFT_SIMD simd, BflyFunc* bfly2, BflyFunc* bfly4);
+
+  size_t                nfft_;
+  bool                  inverse_;
+  FFT_SIMD              simd_;
+  std::vector<cpx_t>    twiddles_;
+  std::vector<cpx_t>    realTwiddles_;       // Split of transform_real() (nfft/2+1)
+  std::vector<size_t>   stageRadix_;
+  std::vector<size_t>   stageRemainder_;
+  kissfft<T>*           kiss_;               // Sizes with other factors (else NULL)
+  BflyFunc              bfly2_;
+  BflyFunc              bfly4_;
+};
+
+#endif  /* ECMC_FFT_SIMD_H_ */
@@ -0,0 +1,312 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTWorkerPool.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+// Needed to get headers in ecmc right...
+#define ECMC_IS_PLUGIN
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sstream>
+#include "ecmcFFTWorkerPool.h"
+#include "ecmcFFT.h"
+#include "ecmcFFTDefs.h"
+#include "epicsThread.h"
+#include "epicsAtomic.h"
+
+void f_poolWorker(void *obj) {
+  if(!obj) {
+    printf("%s/%s:%d: Error: Worker pool object NULL..\n",
+            __FILE__, __FUNCTION__, __LINE__);
+    return;
+  }
+  ecmcFFTWorkerPool * pool = (ecmcFFTWorkerPool*)obj;
+  pool->doWork();
+}
+
+ecmcFFTWorkerPool::ecmcFFTWorkerPool(int         threadCount,
+                                     int         priority,
+                                     const char* cpus) {
+  nextFFT_        = 0;
+  exitEvents_     = NULL;
+  threadsCreated_ = 0;
+  threadsStarted_ = 0;
+  destructs_      = 0;
+  threadCount_    = threadCount;
+  priority_       = priority;
+  cpus_           = NULL;
+
+  if(threadCount_ <= 0 || threadCount_ > ECMC_PLUGIN_MAX_POOL_THREADS) {
+    throw std::out_of_range("Worker pool thread count out of range.");
+  }
+
+  if(priority_ < 0 || priority_ > 99) {
+    throw std::out_of_range("Worker pool priority out of range (0..99).");
+  }
+
+  if(cpus && cpus[0]) {
+    std::vector<int> cpuList;
+    parseCpuList(cpus, &cpuList);  // Throws if invalid
+    cpus_ = strdup(cpus);
+  }
+
+  exitEvents_ = new epicsEvent[threadCount_];
+
+  for(int i = 0; i < threadCount_; ++i) {
+    std::ostringstream threadname;
+    threadname << "ecmc.plugin.fft.pool" << i;
+    if(epicsThreadCreate(threadname.str().c_str(), priority_,
+                         ECMC_PLUGIN_WORKER_STACK_SIZE, f_poolWorker, this) == NULL) {
+      // Threads already started use this object, stop them before it is freed
+      stopThreads();
+      delete[] exitEvents_;
+      free(cpus_);
+      throw std::runtime_error("Error: Failed create worker pool thread.");
+    }
+    threadsCreated_++;
+  }
+}
+
+ecmcFFTWorkerPool::~ecmcFFTWorkerPool() {
+  stopThreads();
+  delete[] exitEvents_;
+  if(cpus_) {
+    free(cpus_);
+  }
+}
+
+// Wait for all threads to finish current job and exit (each thread wakes the next)
+void ecmcFFTWorkerPool::stopThreads() {
+  epicsAtomicSetIntT(&destructs_, 1);
+  jobEvent_.signal();
+  for(int i = 0; i < threadsCreated_; ++i) {
+    exitEvents_[i].wait();
+  }
+}
+
+void ecmcFFTWorkerPool::addFFT(ecmcFFT* fft) {
+  if(!fft) {
+    return;
+  }
+  fftsLock_.lock();
+  ffts_.push_back(fft);
+  fftsLock_.unlock();
+}
+
+/** Called from realtime thread. The job is already flagged in the FFT object
+ *  (see ecmcFFT::triggerWorker()), so only a pool thread is woken (no lock
+ *  shared with the pool threads).
+*/
+void ecmcFFTWorkerPool::submit() {
+  jobEvent_.signal();
+}
+
+// Claim next flagged FFT object (if any). Starts after the last served object.
+ecmcFFT* ecmcFFTWorkerPool::takeJob(int* moreJobs) {
+  ecmcFFT* fft = NULL;
+  *moreJobs    = 0;
+
+  fftsLock_.lock();
+  size_t count = ffts_.size();
+  size_t first = nextFFT_;
+  for(size_t i = 0; i < count; ++i) {
+    ecmcFFT* candidate = ffts_[(first + i) % count];
+    if(!fft) {
+      if(candidate->claimJob()) {
+        fft      = candidate;
+        nextFFT_ = (first + i + 1) % count;
+      }
+    } else if(candidate->getJobPending()) {
+      *moreJobs = 1;
+      break;
+    }
+  }
+  fftsLock_.unlock();
+  return fft;
+}
+
+void ecmcFFTWorkerPool::doWork() {
+  int index = epicsAtomicIncrIntT(&threadsStarted_) - 1;  // Exit event of this thread
+  setupCurrentThread(priority_ > 0 ? SCHED_FIFO : SCHED_OTHER, priority_, cpus_);
+
+  while(true) {
+    jobEvent_.wait();
+    if(epicsAtomicGetIntT(&destructs_)) {
+      break;
+    }
+
+    int      moreJobs = 0;
+    ecmcFFT* fft      = takeJob(&moreJobs);
+
+    // Event is binary, wake another thread if more jobs are flagged
+    if(moreJobs) {
+      jobEvent_.signal();
+    }
+
+    if(fft) {
+      fft->doCalcJob();
+    }
+  }
+
+  // Wake next thread so it also can exit
+  jobEvent_.signal();
+  // Last access of this object (freed when all threads are done)
+  exitEvents_[index].signal();
+}
+
+int ecmcFFTWorkerPool::getThreadCount() {
+  return threadCount_;
+}
+
+int ecmcFFTWorkerPool::getPriority() {
+  return priority_;
+}
+
+const char* ecmcFFTWorkerPool::getCpus() {
+  return cpus_;
+}
+
+// Parse cpu list like "1,2,3", "1-3" or "0,2-3". Throws if invalid.
+void ecmcFFTWorkerPool::parseCpuList(const char* cpus, std::vector<int>* cpuList) {
+  cpuList->clear();
+  if(!cpus) {
+    return;
+  }
+
+  const char* p = cpus;
+  while(*p) {
+    char* end = NULL;
+    long first = strtol(p, &end, 10);
+    if(end == p || first < 0 || first >= CPU_SETSIZE) {
+      throw std::invalid_argument("Invalid CPU list.");
+    }
+    long last = first;
+    p = end;
+    if(*p == '-') {
+      p++;
+      last = strtol(p, &end, 10);
+      if(end == p || last < first || last >= CPU_SETSIZE) {
+        throw std::invalid_argument("Invalid CPU list.");
+      }
+      p = end;
+    }
+    for(long cpu = first; cpu <= last; ++cpu) {
+      cpuList->push_back((int)cpu);
+    }
+    if(*p == ',') {
+      p++;
+    } else if(*p) {
+      throw std::invalid_argument("Invalid CPU list.");
+    }
+  }
+}
+
+/** Apply scheduling policy, priority and cpu affinity to the calling thread.
+ *  SCHED_OTHER leaves the policy untouched (priority must then be 0).
+ *  Returns 0 if success.
+*/
+int ecmcFFTWorkerPool::setupCurrentThread(int policy, int priority, const char* cpus) {
+  int errorCode = 0;
+
+  if(policy != SCHED_OTHER) {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    if(pthread_setschedparam(pthread_self(), policy, &param) != 0) {
+      printf("%s/%s:%d: Warning: Failed set policy %d with priority %d (check permissions).\n",
+              __FILE__, __FUNCTION__, __LINE__, policy, priority);
+      errorCode = ECMC_PLUGIN_FFT_ERROR_CODE;
+    }
+  }
+
+  if(cpus && cpus[0]) {
+    std::vector<int> cpuList;
+    try {
+      parseCpuList(cpus, &cpuList);
+    }
+    catch(std::exception& e) {
+      printf("%s/%s:%d: Warning: %s (%s).\n",
+              __FILE__, __FUNCTION__, __LINE__, e.what(), cpus);
+      return ECMC_PLUGIN_FFT_ERROR_CODE;
+    }
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for(size_t i = 0; i < cpuList.size(); ++i) {
+      CPU_SET(cpuList[i], &cpuSet);
+    }
+    if(pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+      printf("%s/%s:%d: Warning: Failed set CPU affinity (%s).\n",
+              __FILE__, __FUNCTION__, __LINE__, cpus);
+      errorCode = ECMC_PLUGIN_FFT_ERROR_CODE;
+    }
+  }
+
+  return errorCode;
+}
+
+/** Read back effective scheduling policy, priority and cpu affinity of the
+ *  calling thread. The cpu set is written as a list like "0-1,3".
+ *  Returns 0 if success.
+*/
+int ecmcFFTWorkerPool::getCurrentThreadInfo(int*   policy,
+                                            int*   priority,
+                                            char*  cpus,
+                                            size_t cpusSize) {
+  struct sched_param param;
+  memset(&param, 0, sizeof(param));
+  if(pthread_getschedparam(pthread_self(), policy, &param) != 0) {
+    return ECMC_PLUGIN_FFT_ERROR_CODE;
+  }
+  *priority = param.sched_priority;
+
+  if(!cpus || cpusSize == 0) {
+    return 0;
+  }
+  cpus[0] = '\0';
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if(pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+    return ECMC_PLUGIN_FFT_ERROR_CODE;
+  }
+
+  // Compress to ranges
+  std::ostringstream os;
+  int cpu = 0;
+  while(cpu < CPU_SETSIZE) {
+    if(!CPU_ISSET(cpu, &cpuSet)) {
+      cpu++;
+      continue;
+    }
+    int first = cpu;
+    while(cpu + 1 < CPU_SETSIZE && CPU_ISSET(cpu + 1, &cpuSet)) {
+      cpu++;
+    }
+    if(os.tellp() > 0) {
+      os << ",";
+    }
+    os << first;
+    if(cpu > first) {
+      os << "-" << cpu;
+    }
+    cpu++;
+  }
+  snprintf(cpus, cpusSize, "%s", os.str().c_str());
+  return 0;
+}
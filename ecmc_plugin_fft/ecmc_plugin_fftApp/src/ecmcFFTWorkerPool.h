@@ -0,0 +1,73 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTWorkerPool.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_WORKER_POOL_H_
+#define ECMC_FFT_WORKER_POOL_H_
+
+#include <stdexcept>
+#include <vector>
+#include "epicsEvent.h"
+#include "epicsMutex.h"
+
+class ecmcFFT;
+
+class ecmcFFTWorkerPool {
+ public:
+
+  /** ecmc FFT worker pool class
+   * Shared worker threads for FFT objects (instead of one thread per object).
+   * This object can throw:
+   *    - bad_alloc
+   *    - invalid_argument
+   *    - runtime_error
+  */
+  ecmcFFTWorkerPool(int         threadCount,
+                    int         priority,     // 0 = default (not realtime)
+                    const char* cpus);        // CPU list ("2,3" or "2-3"), NULL = all
+  ~ecmcFFTWorkerPool();
+
+  // Register FFT object (called at configuration, before realtime)
+  void                  addFFT(ecmcFFT* fft);
+  // Wake a pool thread (called from realtime thread, job flagged in FFT object)
+  void                  submit();
+  void                  doWork();  // Called from pool threads
+  int                   getThreadCount();
+  int                   getPriority();
+  const char*           getCpus();
+
+  // Thread utils (also for non pool worker threads)
+  static void           parseCpuList(const char* cpus, std::vector<int>* cpuList);
+  static int            setupCurrentThread(int         policy,    // SCHED_OTHER, SCHED_FIFO, SCHED_RR
+                                           int         priority,
+                                           const char* cpus);
+  static int            getCurrentThreadInfo(int*   policy,
+                                             int*   priority,
+                                             char*  cpus,       // Effective cpu list ("0-1,3")
+                                             size_t cpusSize);
+
+ private:
+  ecmcFFT*              takeJob(int* moreJobs);
+  void                  stopThreads();
+
+  std::vector<ecmcFFT*> ffts_;               // Registered FFT objects (scanned for jobs)
+  size_t                nextFFT_;            // Scan start (all objects get served)
+  epicsMutex            fftsLock_;           // Only taken by pool threads and addFFT()
+  epicsEvent            jobEvent_;
+  epicsEvent*           exitEvents_;         // One per thread, signaled when thread is done
+  int                   threadCount_;
+  int                   threadsCreated_;
+  int                   threadsStarted_;     // Index of exit event of thread (atomic)
+  int                   priority_;
+  char*                 cpus_;
+  int                   destructs_;
+};
+
+#endif  /* ECMC_FFT_WORKER_POOL_H_ */
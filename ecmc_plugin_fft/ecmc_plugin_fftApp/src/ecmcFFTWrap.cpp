@@ -20,6 +20,7 @@
 #include "ecmcFFTWrap.h"
 #include "ecmcFFT.h"
 #include "ecmcFFTDefs.h"
+#include "ecmcFFTWorkerPool.h"
 
 #define ECMC_PLUGIN_MAX_PORTNAME_CHARS 64
 #define ECMC_PLUGIN_PORTNAME_PREFIX "PLUGIN.FFT"
@@ -27,6 +28,7 @@
 static std::vector<ecmcFFT*>  ffts;
 static int                    fftObjCounter = 0;
 static char                   portNameBuffer[ECMC_PLUGIN_MAX_PORTNAME_CHARS];
+static ecmcFFTWorkerPool*     workerPool = NULL;  // Shared by all FFT objects with WORKER_POOL
 
 int createFFT(char* configStr) {
 
@@ -39,6 +41,20 @@ int createFFT(char* configStr) {
             ECMC_PLUGIN_PORTNAME_PREFIX "%d", fftObjCounter);
   try {
     fft = new ecmcFFT(fftObjCounter, configStr, portNameBuffer);
+
+    // Use shared worker pool (created by first FFT object that uses the pool)
+    if(fft->getCfgPoolThreads() > 0) {
+      if(!workerPool) {
+        workerPool = new ecmcFFTWorkerPool(fft->getCfgPoolThreads(),
+                                           fft->getCfgPoolPrio(),
+                                           fft->getCfgPoolCpus());
+      } else if(fft->getCfgPoolThreads() != workerPool->getThreadCount()) {
+        printf("Warning: Worker pool already created with %d threads. Pool config ignored.\n",
+               workerPool->getThreadCount());
+      }
+      workerPool->addFFT(fft);
+      fft->setWorkerPool(workerPool);
+    }
   }
   catch(std::exception& e) {
     if(fft) {
@@ -55,6 +71,11 @@ int createFFT(char* configStr) {
 }
 
 void deleteAllFFTs() {
+  // Stop pool threads first since they use the FFT objects
+  if(workerPool) {
+    delete workerPool;
+    workerPool = NULL;
+  }
   for(std::vector<ecmcFFT*>::iterator pfft = ffts.begin(); pfft != ffts.end(); ++pfft) {
     if(*pfft) {
       delete (*pfft);
@@ -115,7 +136,18 @@ int modeFFT(int fftIndex, FFT_MODE mode) {
     ffts.at(fftIndex)->setModeFFT(mode);
   }
   catch(std::exception& e) {
-    printf("Exception: %s. FFT index out of range.\n",e.what());
+    printf("Exception: %s\n",e.what());  // FFT index out of range or mode not allowed (zoom)
+    return ECMC_PLUGIN_FFT_ERROR_CODE;
+  }  
+  return 0;
+}
+
+int nfftFFT(int fftIndex, int nfft) {
+  try {
+    ffts.at(fftIndex)->setNfft((size_t)nfft);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. FFT index or NFFT out of range.\n",e.what());
     return ECMC_PLUGIN_FFT_ERROR_CODE;
   }  
   return 0;
@@ -131,3 +163,14 @@ FFT_STATUS  statFFT(int fftIndex) {
   }  
   return NO_STAT;
 }
+
+double bandFFT(int fftIndex, int band, FFT_BAND_OUTPUT output) {
+  try {
+    return ffts.at(fftIndex)->getBandValue(band, output);
+  }
+  catch(std::exception& e) {
+    printf("Exception: %s. FFT index or band out of range.\n",e.what());
+    return 0;
+  }
+  return 0;
+}
@@ -75,6 +75,17 @@ int         modeFFT(int fftIndex, FFT_MODE mode);
  */
 int         triggFFT(int fftIndex);
 
+/** \brief Set NFFT of FFT object\n
+ *
+ *  Change number of samples in each FFT (must be even). The new NFFT is applied\n
+ *  by the worker thread and the acquisition restarts with the new size.\n
+ *  \param[in] fftIndex Index of fft (first loaded fft have index 0 then increases)\n
+ *  \param[in] nfft New NFFT\n
+ *
+ *  \return 0 if success or otherwise an error code.\n
+ */
+int         nfftFFT(int fftIndex, int nfft);
+
 /** \brief Get status of FFT object
  *
  *  The FFT object can be in different states:\n
@@ -88,6 +99,20 @@ int         triggFFT(int fftIndex);
  */
 FFT_STATUS  statFFT(int fftIndex);
 
+/** \brief Get band summary of FFT object
+ *
+ *  Summary of a band (BANDS) of the latest spectrum of the first channel:\n
+ *    BAND_RMS(0)      : RMS of band\n
+ *    BAND_PEAK(1)     : Max of amplitude spectrum in band (configured unit)\n
+ *    BAND_PEAK_FREQ(2): Frequency of max [Hz]\n
+ *  \param[in] fftIndex Index of fft (first loaded fft have index 0 then increases)\n
+ *  \param[in] band Index of band (order in BANDS, first band have index 0)\n
+ *  \param[in] output Value of band\n
+ *
+ *  \return Value (0 if index or band is out of range).\n
+ */
+double      bandFFT(int fftIndex, int band, FFT_BAND_OUTPUT output);
+
 /** \brief Link data to _all_ fft objects
  *
  *  This tells the FFT lib to connect to ecmc to find it's data source.\n
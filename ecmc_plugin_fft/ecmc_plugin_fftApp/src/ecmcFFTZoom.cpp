@@ -0,0 +1,205 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTZoom.cpp
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+
+#include <string.h>
+#include <math.h>
+#include "ecmcFFTZoom.h"
+
+template<typename T>
+ecmcFFTZoom<T>::ecmcFFTZoom() {
+  nfft_         = 0;
+  hop_          = 1;
+  decimation_   = 1;
+  bins_         = 0;
+  rate_         = 0;
+  firstFreq_    = 0;
+  osc_          = 1;
+  rot_          = 1;
+  taps_         = NULL;
+  tapCount_     = 0;
+  history_      = NULL;
+  historyIndex_ = 0;
+  historyCount_ = 0;
+  decimCounter_ = 0;
+  ring_         = NULL;
+  ringIndex_    = 0;
+  ringCount_    = 0;
+  ringNew_      = 0;
+  input_        = NULL;
+  output_       = NULL;
+  fft_          = NULL;
+}
+
+template<typename T>
+ecmcFFTZoom<T>::~ecmcFFTZoom() {
+  freeBuffers();
+}
+
+template<typename T>
+void ecmcFFTZoom<T>::freeBuffers() {
+  delete[] taps_;
+  delete[] history_;
+  delete[] ring_;
+  delete[] input_;
+  delete[] output_;
+  delete fft_;
+  taps_    = NULL;
+  history_ = NULL;
+  ring_    = NULL;
+  input_   = NULL;
+  output_  = NULL;
+  fft_     = NULL;
+}
+
+// Decimation that keeps the span (and the filter transition) below the new Nyquist
+template<typename T>
+size_t ecmcFFTZoom<T>::getDecimation(double sampleRateHz, double spanHz) {
+  double decimation = floor(sampleRateHz / (spanHz * ECMC_PLUGIN_ZOOM_OVERSAMPLING));
+  return decimation < 1 ? 1 : (size_t)decimation;
+}
+
+/** New band, rate or NFFT. Filter and window restart. The old config is
+ *  kept if allocation fails (throws bad_alloc).
+*/
+template<typename T>
+void ecmcFFTZoom<T>::configure(double sampleRateHz,
+                               double centerHz,
+                               double spanHz,
+                               size_t nfft,
+                               size_t hop) {
+  size_t decimation = getDecimation(sampleRateHz, spanHz);
+  size_t tapCount   = ECMC_PLUGIN_ZOOM_TAPS_PER_DECIMATION * decimation + 1;
+
+  T*               taps    = NULL;
+  std::complex<T>* history = NULL;
+  std::complex<T>* ring    = NULL;
+  std::complex<T>* input   = NULL;
+  std::complex<T>* output  = NULL;
+  ecmcFFTSimd<T>*  fft     = NULL;
+  try {
+    taps    = new T[tapCount];
+    history = new std::complex<T>[2 * tapCount];
+    ring    = new std::complex<T>[nfft];
+    input   = new std::complex<T>[nfft];
+    output  = new std::complex<T>[nfft];
+    fft     = new ecmcFFTSimd<T>(nfft, false);
+  }
+  catch(std::bad_alloc& e) {
+    delete[] taps;
+    delete[] history;
+    delete[] ring;
+    delete[] input;
+    delete[] output;
+    throw;
+  }
+
+  // Blackman windowed sinc, cutoff at half the decimated rate, unity dc gain
+  double cutoff = 0.5 / (double)decimation;
+  double mid    = (double)(tapCount - 1) / 2.0;
+  double sum    = 0;
+  std::vector<double> h(tapCount);
+  for(size_t k = 0; k < tapCount; ++k) {
+    double x    = (double)k - mid;
+    double sinc = x == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * x) / (M_PI * x);
+    double w    = 0.42 - 0.5 * cos(2 * M_PI * k / (tapCount - 1)) +
+                  0.08 * cos(4 * M_PI * k / (tapCount - 1));
+    h[k] = sinc * w;
+    sum += h[k];
+  }
+  for(size_t k = 0; k < tapCount; ++k) {
+    taps[k] = (T)(h[k] / sum);
+  }
+
+  freeBuffers();
+  taps_       = taps;
+  history_    = history;
+  ring_       = ring;
+  input_      = input;
+  output_     = output;
+  fft_        = fft;
+  tapCount_   = tapCount;
+  nfft_       = nfft;
+  hop_        = hop;
+  decimation_ = decimation;
+  rate_       = sampleRateHz / (double)decimation;
+  rot_        = std::polar(1.0, -2 * M_PI * centerHz / sampleRateHz);
+
+  // Bins within the span (symmetric around centre, inside the decimated Nyquist)
+  double df   = rate_ / (double)nfft;
+  size_t half = (size_t)(spanHz / 2 / df);
+  if(half > nfft / 2 - 1) {
+    half = nfft / 2 - 1;
+  }
+  bins_      = 2 * half + 1;
+  firstFreq_ = centerHz - (double)half * df;
+  reset();
+}
+
+template<typename T>
+void ecmcFFTZoom<T>::reset() {
+  historyIndex_ = 0;
+  historyCount_ = 0;
+  decimCounter_ = 0;
+  ringIndex_    = 0;
+  ringCount_    = 0;
+  ringNew_      = 0;
+}
+
+template<typename T>
+void ecmcFFTZoom<T>::addDecimated(std::complex<T> value) {
+  ring_[ringIndex_] = value;
+  ringIndex_ = ringIndex_ + 1 < nfft_ ? ringIndex_ + 1 : 0;
+  if(ringCount_ < nfft_) {
+    ringCount_++;
+  }
+  ringNew_++;
+}
+
+template<typename T>
+int ecmcFFTZoom<T>::windowReady() {
+  return fft_ && ringCount_ == nfft_ && ringNew_ >= hop_;
+}
+
+// Transform of window, negative frequencies (upper half) first
+template<typename T>
+void ecmcFFTZoom<T>::transform(std::complex<T>* result) {
+  fft_->transform(input_, output_);
+  size_t half  = bins_ / 2;
+  size_t index = nfft_ - half;
+  for(size_t i = 0; i < bins_; ++i) {
+    result[i] = output_[index];
+    index = index + 1 < nfft_ ? index + 1 : 0;
+  }
+}
+
+template<typename T>
+size_t ecmcFFTZoom<T>::getBins() {
+  return bins_;
+}
+
+template<typename T>
+size_t ecmcFFTZoom<T>::getDecimation() {
+  return decimation_;
+}
+
+template<typename T>
+double ecmcFFTZoom<T>::getRate() {
+  return rate_;
+}
+
+template<typename T>
+double ecmcFFTZoom<T>::getFirstFreq() {
+  return firstFreq_;
+}
+
+template class ecmcFFTZoom<double>;
+template class ecmcFFTZoom<float>;
@@ -0,0 +1,139 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTZoom.h
+*
+*  Created on: Mar 22, 2020
+*      Author: anderssandstrom
+*
+\*************************************************************************/
+#ifndef ECMC_FFT_ZOOM_H_
+#define ECMC_FFT_ZOOM_H_
+
+#include <stdexcept>
+#include <stddef.h>
+#include <complex>
+#include "ecmcFFTDefs.h"
+#include "ecmcFFTSimd.h"
+
+template<typename T>
+class ecmcFFTZoom {
+ public:
+
+  /** ecmc FFT zoom class
+   * Band limited spectrum (zoom FFT) of real data around a centre frequency.
+   * The data is mixed down (multiplied with exp(-j*2*pi*fc*t)), low pass
+   * filtered (windowed sinc FIR), decimated by D and collected in a window
+   * of NFFT complex samples. The complex transform of the window gives the
+   * bins of the band fc-span/2..fc+span/2 with the resolution fs/(D*NFFT).
+   * Only accessed by worker:
+   *   configure(), add(), windowReady(), getWindow(), transform()
+   * This object can throw:
+   *    - bad_alloc
+  */
+  ecmcFFTZoom();
+  ~ecmcFFTZoom();
+
+  void                  configure(double sampleRateHz,
+                                  double centerHz,
+                                  double spanHz,
+                                  size_t nfft,
+                                  size_t hop);  // Decimated samples between windows
+  void                  reset();             // Gap in data, restart filter and window
+  template<typename S>
+  void                  add(const S* data, size_t elements);
+  int                   windowReady();       // NFFT samples and hop new since last window
+  template<typename S>
+  void                  getWindow(const S* window, T* raw, T* prep);  // Real parts to raw and prep
+  void                  transform(std::complex<T>* result);  // Bins of band (ascending freq)
+  size_t                getBins();           // Bins in band (odd, centre bin in the middle)
+  size_t                getDecimation();
+  double                getRate();           // Rate of decimated data
+  double                getFirstFreq();      // Frequency of first bin
+
+  static size_t         getDecimation(double sampleRateHz, double spanHz);
+
+ private:
+  void                  addDecimated(std::complex<T> value);
+  void                  freeBuffers();
+
+  size_t                nfft_;
+  size_t                hop_;
+  size_t                decimation_;
+  size_t                bins_;
+  double                rate_;
+  double                firstFreq_;
+  std::complex<double>  osc_;                // Mixer (rotated by rot_ each sample)
+  std::complex<double>  rot_;
+  T*                    taps_;               // Low pass (length taps_, symmetric)
+  size_t                tapCount_;
+  std::complex<T>*      history_;            // Mixed samples (twice, contiguous for any start)
+  size_t                historyIndex_;       // Oldest sample in history
+  size_t                historyCount_;       // Valid samples (up to tapCount_)
+  size_t                decimCounter_;       // Samples since last decimated sample
+  std::complex<T>*      ring_;               // Decimated samples (NFFT)
+  size_t                ringIndex_;          // Next write (oldest if full)
+  size_t                ringCount_;
+  size_t                ringNew_;            // Decimated samples since last window
+  std::complex<T>*      input_;              // Windowed transform input
+  std::complex<T>*      output_;             // Transform output (NFFT)
+  ecmcFFTSimd<T>*       fft_;
+};
+
+/** Mix down, low pass and decimate. The filter is only evaluated for the
+ *  decimated samples (tapCount_/D multiply-adds per sample).
+*/
+template<typename T>
+template<typename S>
+void ecmcFFTZoom<T>::add(const S* data, size_t elements) {
+  if(!fft_) {
+    return;
+  }
+  std::complex<double> osc = osc_;
+  for(size_t i = 0; i < elements; ++i) {
+    std::complex<double> mixed = osc * (double)data[i];
+    osc *= rot_;
+    std::complex<T> value((T)mixed.real(), (T)mixed.imag());
+    history_[historyIndex_]             = value;
+    history_[historyIndex_ + tapCount_] = value;
+    historyIndex_ = historyIndex_ + 1 < tapCount_ ? historyIndex_ + 1 : 0;
+    if(historyCount_ < tapCount_) {
+      historyCount_++;
+    }
+    if(++decimCounter_ < decimation_) {
+      continue;
+    }
+    decimCounter_ = 0;
+    if(historyCount_ < tapCount_) {
+      continue;  // Filter not filled since reset
+    }
+    const std::complex<T>* h = &history_[historyIndex_];
+    T re = 0;
+    T im = 0;
+    for(size_t k = 0; k < tapCount_; ++k) {
+      re += taps_[k] * h[k].real();
+      im += taps_[k] * h[k].imag();
+    }
+    addDecimated(std::complex<T>(re, im));
+  }
+  osc_ = osc / std::abs(osc);  // Rounding
+}
+
+// Window of the latest NFFT decimated samples (oldest first)
+template<typename T>
+template<typename S>
+void ecmcFFTZoom<T>::getWindow(const S* window, T* raw, T* prep) {
+  size_t index = ringIndex_;
+  for(size_t i = 0; i < nfft_; ++i) {
+    std::complex<T> value = ring_[index];
+    index     = index + 1 < nfft_ ? index + 1 : 0;
+    input_[i] = value * (T)window[i];
+    raw[i]    = value.real();
+    prep[i]   = input_[i].real();
+  }
+  ringNew_ = 0;
+}
+
+#endif  /* ECMC_FFT_ZOOM_H_ */
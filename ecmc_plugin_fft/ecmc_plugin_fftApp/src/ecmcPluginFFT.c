@@ -106,6 +106,26 @@ double fft_stat(double index) {
   return (double)statFFT((int)index);
 }
 
+// Plc function for change of nfft
+double fft_nfft(double index, double nfft) {
+  return (double)nfftFFT((int)index, (int)nfft);
+}
+
+// Plc function for rms of band
+double fft_band_rms(double index, double band) {
+  return bandFFT((int)index, (int)band, BAND_RMS);
+}
+
+// Plc function for peak of band
+double fft_band_peak(double index, double band) {
+  return bandFFT((int)index, (int)band, BAND_PEAK);
+}
+
+// Plc function for frequency of peak of band
+double fft_band_freq(double index, double band) {
+  return bandFFT((int)index, (int)band, BAND_PEAK_FREQ);
+}
+
 // Register data for plugin so ecmc know what to use
 struct ecmcPluginData pluginDataDef = {
   // Allways use ECMC_PLUG_VERSION_MAGIC
@@ -117,6 +137,12 @@ struct ecmcPluginData pluginDataDef = {
   // Option description
   .optionDesc = "\n    "ECMC_PLUGIN_DBG_PRINT_OPTION_CMD"<1/0>     : Enables/disables printouts from plugin, default = disabled.\n"
                 "    "ECMC_PLUGIN_SOURCE_OPTION_CMD"<source>     : Sets source variable for FFT (example: ec0.s1.AI_1).\n"
+                "    "ECMC_PLUGIN_SOURCES_OPTION_CMD"<a,b,..>   : Several sources in one FFT object, calculated in one batch (asyn addr = index in list, instead of SOURCE).\n"
+                "    "ECMC_PLUGIN_CROSS_OPTION_CMD"<1/0>         : Cross spectrum, transfer function (H1) and coherence of each source in SOURCES to first source, default = disabled.\n"
+                "    "ECMC_PLUGIN_ZOOM_CENTER_OPTION_CMD"<hz>    : Centre frequency of zoom band (see ZOOM_SPAN), default = 0.\n"
+                "    "ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD"<hz>      : Zoom FFT: NFFT bins of mixed down and decimated data, only the band ZOOM_CENTER +- ZOOM_SPAN/2 is published (MODE=CONT), default = 0 (no zoom).\n"
+                "    "ECMC_PLUGIN_BANDS_OPTION_CMD"<lo-hi,..>     : Bands [Hz] summarized as rms, peak and peak frequency (asyn and plc), default = none.\n"
+                "    "ECMC_PLUGIN_PUBLISH_ARRAYS_OPTION_CMD"<1/0> : Array callbacks of data and spectra (arrays can still be read on request), default = 1.\n"
                 "    "ECMC_PLUGIN_NFFT_OPTION_CMD"<nfft>         : Data points to collect, default = 4096.\n" 
                 "    "ECMC_PLUGIN_SCALE_OPTION_CMD"scalefactor   : Apply scale to source data, default = 1.0.\n" 
                 "    "ECMC_PLUGIN_RM_DC_OPTION_CMD"<1/0>         : Remove DC offset of input data (SOURCE), default = disabled.\n" 
@@ -124,6 +150,21 @@ struct ecmcPluginData pluginDataDef = {
                 "    "ECMC_PLUGIN_ENABLE_OPTION_CMD"<1/0>        : Enable data acq. and calcs (can be controlled over asyn), default = disabled.\n"
                 "    "ECMC_PLUGIN_MODE_OPTION_CMD"<CONT/TRIGG>   : Continious or triggered mode, defaults to TRIGG\n"
                 "    "ECMC_PLUGIN_RATE_OPTION_CMD"<rate in hz>   : fft data sample rate in hz (must be lower than ecmc rate and (ecmc_rate/fft_rate)=integer), default = ecmc rate.\n"
+                "    "ECMC_PLUGIN_OVERLAP_OPTION_CMD"<percent>   : Overlap between spectra in CONT mode in % of NFFT (0..<100), default = 0.\n"
+                "    "ECMC_PLUGIN_WINDOW_OPTION_CMD"<window>     : Window function NONE/HANN/HAMMING/BLACKMANHARRIS/FLATTOP, default = NONE.\n"
+                "    "ECMC_PLUGIN_WINDOW_CORR_OPTION_CMD"AMP/ENERGY : Window correction of amplitude or energy, default = AMP.\n"
+                "    "ECMC_PLUGIN_UNIT_OPTION_CMD"AMP/POWER/PSD/DB : Unit of amplitude spectrum (PSD one-sided per Hz, DB relative DB_REF), default = AMP.\n"
+                "    "ECMC_PLUGIN_DB_REF_OPTION_CMD"<ref>     : Reference amplitude of DB unit (> 0), default = 1.0.\n"
+                "    "ECMC_PLUGIN_AVG_MODE_OPTION_CMD"<mode>   : Averaging of amplitude NONE/LIN/EXP/MAX, default = NONE.\n"
+                "    "ECMC_PLUGIN_AVG_COUNT_OPTION_CMD"<count>  : Spectra in linear average (LIN), default = 10.\n"
+                "    "ECMC_PLUGIN_AVG_ALPHA_OPTION_CMD"<alpha>  : Alpha of exponential average (EXP) 0..1, default = 0.1.\n"
+                "    "ECMC_PLUGIN_PRECISION_OPTION_CMD"DOUBLE/FLOAT/FIXED : Precision of buffers and FFT calc (FLOAT and FIXED publish Float32 arrays), default = DOUBLE.\n"
+                "    "ECMC_PLUGIN_WORKER_POOL_OPTION_CMD"<threads> : Use shared worker pool with threads (first object creates pool), default = 0 (own thread).\n"
+                "    "ECMC_PLUGIN_POOL_PRIO_OPTION_CMD"<prio>    : Priority of worker pool threads (>0 = SCHED_FIFO), default = 0.\n"
+                "    "ECMC_PLUGIN_POOL_CPUS_OPTION_CMD"<cpus>    : CPU affinity of worker pool threads (example: 2,3 or 2-3), default = all.\n"
+                "    "ECMC_PLUGIN_WORKER_PRIO_OPTION_CMD"<prio>  : Priority of worker thread (>0 = SCHED_FIFO if no policy), default = 0.\n"
+                "    "ECMC_PLUGIN_WORKER_POLICY_OPTION_CMD"OTHER/FIFO/RR : Scheduling policy of worker thread, default = FIFO if prio > 0 else OTHER.\n"
+                "    "ECMC_PLUGIN_WORKER_CPUS_OPTION_CMD"<cpus>  : CPU affinity of worker thread (example: 2,3 or 2-3), default = all.\n"
                 "    "ECMC_PLUGIN_BREAKTABLE_OPTION_CMD"<brktab> : Use epics breaktable to convert raw values (applied before any other signal cond. alg.), default not used."
                 , 
   // Plugin version
@@ -254,7 +295,99 @@ struct ecmcPluginData pluginDataDef = {
         .funcArg10 = NULL,
         .funcGenericObj = NULL,
       },
-  .funcs[5] = {0},  // last element set all to zero..
+    .funcs[5] =
+      { /*----fft_nfft----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "fft_nfft",
+        // Function description
+        .funcDesc = "double fft_nfft(index, nfft) : Set nfft (even) for fft[index]. Acq. restarts with new nfft.",
+        /**
+        * 7 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = fft_nfft,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+    .funcs[6] =
+      { /*----fft_band_rms----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "fft_band_rms",
+        // Function description
+        .funcDesc = "double fft_band_rms(index, band) : Get rms of band (BANDS) of latest spectrum for fft[index].",
+        /**
+        * 7 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = fft_band_rms,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+    .funcs[7] =
+      { /*----fft_band_peak----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "fft_band_peak",
+        // Function description
+        .funcDesc = "double fft_band_peak(index, band) : Get peak amplitude of band (BANDS) of latest spectrum for fft[index].",
+        /**
+        * 7 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = fft_band_peak,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+    .funcs[8] =
+      { /*----fft_band_freq----*/
+        // Function name (this is the name you use in ecmc plc-code)
+        .funcName = "fft_band_freq",
+        // Function description
+        .funcDesc = "double fft_band_freq(index, band) : Get frequency of peak of band (BANDS) of latest spectrum for fft[index].",
+        /**
+        * 7 different prototypes allowed (only doubles since reg in plc).
+        * Only funcArg${argCount} func shall be assigned the rest set to NULL.
+        **/
+        .funcArg0 = NULL,
+        .funcArg1 = NULL,
+        .funcArg2 = fft_band_freq,
+        .funcArg3 = NULL,
+        .funcArg4 = NULL,
+        .funcArg5 = NULL,
+        .funcArg6 = NULL,
+        .funcArg7 = NULL,
+        .funcArg8 = NULL,
+        .funcArg9 = NULL,
+        .funcArg10 = NULL,
+        .funcGenericObj = NULL,
+      },
+  .funcs[9] = {0},  // last element set all to zero..
   // PLC consts
   /* CONTINIOUS MODE = 1 */
   .consts[0] = {
@@ -0,0 +1,721 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTBench.cpp
+*
+*  Host benchmark of the FFT plugin processing pipeline (realtime
+*  ingestion and worker calculation) without IOC or EtherCAT hardware.
+*  ecmc, asyn and EPICS base are replaced by the shims in ./shims.
+*  With -E the engine (ecmcFFTEngine) is benchmarked alone.
+*
+\*************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "ecmcFFT.h"
+#include "ecmcFFTEngine.h"
+#include "ecmcFFTDefs.h"
+#include "ecmcPluginClient.h"
+
+#define BENCH_DEFAULT_NFFTS    "256,1024,4096,16384,65536"
+#define BENCH_DEFAULT_TYPES    "S16,S32,F32,F64"
+#define BENCH_DEFAULT_OPTIONS  "NONE,RM_DC,RM_LIN,BREAKTABLE,SCALE"
+#define BENCH_DEFAULT_SPECTRA  50
+#define BENCH_DEFAULT_ELEMENTS 10     // Samples per ecmc cycle (oversampling)
+#define BENCH_DEFAULT_CHANNELS 1      // Sources per FFT object (SOURCES if > 1)
+#define BENCH_SOURCE_NAME      "bench"
+#define BENCH_WAIT_TIMEOUT_S   10
+#define BENCH_ROUND_WAIT_MS    1
+
+typedef struct {
+  const char*     name;
+  ecmcEcDataType  dt;
+  FFT_SAMPLE_TYPE sampleType;  // Engine only (-E)
+} benchType;
+
+static const benchType benchTypes[] = {
+  {"U8",  ECMC_EC_U8,  SAMPLE_U8},
+  {"S8",  ECMC_EC_S8,  SAMPLE_S8},
+  {"U16", ECMC_EC_U16, SAMPLE_U16},
+  {"S16", ECMC_EC_S16, SAMPLE_S16},
+  {"U32", ECMC_EC_U32, SAMPLE_U32},
+  {"S32", ECMC_EC_S32, SAMPLE_S32},
+  {"U64", ECMC_EC_U64, SAMPLE_U64},
+  {"S64", ECMC_EC_S64, SAMPLE_S64},
+  {"F32", ECMC_EC_F32, SAMPLE_F32},
+  {"F64", ECMC_EC_F64, SAMPLE_F64},
+};
+
+typedef struct {
+  const char* name;
+  const char* config;
+} benchOption;
+
+static const benchOption benchOptions[] = {
+  {"NONE",       ""},
+  {"RM_DC",      "RM_DC=1;"},
+  {"RM_LIN",     "RM_LIN=1;"},
+  {"BREAKTABLE", "BREAKTABLE=" BENCH_SOURCE_NAME ";"},
+  {"SCALE",      "SCALE=0.001;"},
+};
+
+// Worker stage times, copied from the workertime array callback
+static std::mutex              resultLock;
+static std::condition_variable resultCond;
+static asynPortDriver*         resultDriver = NULL;
+static int                     resultId     = -1;
+static size_t                  resultCounter = 0;
+static double                  resultTimes[ECMC_PLUGIN_WORKER_STAGE_COUNT];
+
+static void arrayCallback(asynPortDriver* driver, int reason,
+                          const void* value, size_t nElements) {
+  if(driver != resultDriver || reason != resultId ||
+     nElements != ECMC_PLUGIN_WORKER_STAGE_COUNT) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(resultLock);
+  memcpy(resultTimes, value, sizeof(resultTimes));
+  resultCounter++;
+  resultCond.notify_one();
+}
+
+static int waitForSpectrum(size_t counter, double* times, int timeoutMs) {
+  std::unique_lock<std::mutex> guard(resultLock);
+  if(!resultCond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                          [counter]{ return resultCounter > counter; })) {
+    return -1;
+  }
+  memcpy(times, resultTimes, sizeof(resultTimes));
+  return 0;
+}
+
+static size_t getResultCounter() {
+  std::lock_guard<std::mutex> guard(resultLock);
+  return resultCounter;
+}
+
+static int64_t getNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static std::vector<std::string> splitList(const char* list) {
+  std::vector<std::string> items;
+  std::string              item;
+  for(const char* p = list; ; ++p) {
+    if(*p == ',' || *p == '\0') {
+      if(!item.empty()) {
+        items.push_back(item);
+      }
+      item.clear();
+      if(*p == '\0') {
+        break;
+      }
+    } else {
+      item += *p;
+    }
+  }
+  return items;
+}
+
+template<typename T>
+static void fillTyped(uint8_t* dest, size_t elements, size_t first, size_t nfft) {
+  for(size_t i = 0; i < elements; ++i) {
+    size_t j = first + i;
+    // DC + ramp + tone in 0..65535 (inside breaktable and all int ranges)
+    double value = 20000.0 + 0.01 * (double)(j % nfft) +
+                   10000.0 * sin(2 * M_PI * 37.0 * (double)j / (double)nfft);
+    if(sizeof(T) == 1) {
+      value /= 512.0;  // 8 bit types
+    }
+    T raw = (T)value;
+    memcpy(dest + i * sizeof(T), &raw, sizeof(T));
+  }
+}
+
+// Synthetic signal, one window (NFFT samples) of the source data type
+static void fillSignal(std::vector<uint8_t>* buffer, ecmcEcDataType dt, size_t nfft) {
+  switch(dt) {
+    case ECMC_EC_U8:
+      buffer->resize(nfft * sizeof(uint8_t));
+      fillTyped<uint8_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_S8:
+      buffer->resize(nfft * sizeof(int8_t));
+      fillTyped<int8_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_U16:
+      buffer->resize(nfft * sizeof(uint16_t));
+      fillTyped<uint16_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_S16:
+      buffer->resize(nfft * sizeof(int16_t));
+      fillTyped<int16_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_U32:
+      buffer->resize(nfft * sizeof(uint32_t));
+      fillTyped<uint32_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_S32:
+      buffer->resize(nfft * sizeof(int32_t));
+      fillTyped<int32_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_U64:
+      buffer->resize(nfft * sizeof(uint64_t));
+      fillTyped<uint64_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_S64:
+      buffer->resize(nfft * sizeof(int64_t));
+      fillTyped<int64_t>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    case ECMC_EC_F32:
+      buffer->resize(nfft * sizeof(float));
+      fillTyped<float>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+    default:
+      buffer->resize(nfft * sizeof(double));
+      fillTyped<double>(&(*buffer)[0], nfft, 0, nfft);
+      break;
+  }
+}
+
+typedef struct {
+  double rtNsPerSample;
+  double stageUs[ECMC_PLUGIN_WORKER_STAGE_COUNT];  // Mean
+  size_t spectra;
+} benchResult;
+
+/** Run one case: CONT mode without overlap (one spectrum per NFFT samples).
+ *  Each window is fed in ecmc cycles of "elements" samples, then the
+ *  benchmark waits for the worker (so realtime and worker are measured
+ *  separately). With more than one channel all sources are fed each cycle
+ *  and calculated in one batch (SOURCES). Parameters in subscribe (optional
+ *  outputs, for instance fftphase) are connected on all channels as a
+ *  record would. Returns 0 if success.
+*/
+static int runCase(int            index,
+                   size_t         nfft,
+                   const benchType*   type,
+                   const benchOption* option,
+                   const char*    extraConfig,
+                   const std::vector<std::string>& subscribe,
+                   size_t         spectra,
+                   size_t         elements,
+                   size_t         channels,
+                   benchResult*   result) {
+  memset(result, 0, sizeof(*result));
+
+  std::vector<ecmcDataItem*> dataItems;
+  std::string                sources;
+  for(size_t c = 0; c < channels; ++c) {
+    std::string name = BENCH_SOURCE_NAME;
+    if(channels > 1) {
+      name += std::to_string(c);
+      sources += c > 0 ? "," : "";
+      sources += name;
+    }
+    dataItems.push_back(new ecmcDataItem(name.c_str(), type->dt, elements));
+    addEcmcShimDataItem(dataItems.back());
+  }
+  if(channels > 1) {
+    sources = ECMC_PLUGIN_SOURCES_OPTION_CMD + sources;
+  } else {
+    sources = ECMC_PLUGIN_SOURCE_OPTION_CMD BENCH_SOURCE_NAME;
+  }
+
+  char config[1024];
+  snprintf(config, sizeof(config),
+           "%s;NFFT=%zu;MODE=CONT;ENABLE=1;%s%s",
+           sources.c_str(), nfft, option->config, extraConfig);
+  char portName[64];
+  snprintf(portName, sizeof(portName), "BENCH%d", index);
+  int zoom = strstr(config, ECMC_PLUGIN_ZOOM_SPAN_OPTION_CMD) != NULL;
+
+  ecmcFFT* fft = NULL;
+  try {
+    fft = new ecmcFFT(index, config, portName);
+    fft->connectToDataSource();
+  }
+  catch(std::exception& e) {
+    printf("Error: %s (%s).\n", e.what(), config);
+    if(fft) {
+      delete fft;
+    }
+    for(size_t c = 0; c < channels; ++c) {
+      delete dataItems[c];
+    }
+    clearEcmcShimDataItems();
+    return -1;
+  }
+
+  char paramName[128];
+  snprintf(paramName, sizeof(paramName), "plugin.fft%d.workertime", index);
+  {
+    std::lock_guard<std::mutex> guard(resultLock);
+    resultDriver = fft;
+    if(fft->findParam(paramName, &resultId) != asynSuccess) {
+      resultId = -1;
+    }
+  }
+
+  for(size_t s = 0; s < subscribe.size(); ++s) {
+    snprintf(paramName, sizeof(paramName), "plugin.fft%d.%s", index, subscribe[s].c_str());
+    for(size_t c = 0; c < channels; ++c) {
+      asynUser user;
+      memset(&user, 0, sizeof(user));
+      user.addr = (int)c;
+      if(fft->drvUserCreate(&user, paramName, NULL, NULL) != asynSuccess) {
+        printf("Error: Parameter %s not found.\n", paramName);
+      }
+    }
+  }
+
+  std::vector<uint8_t> signal;
+  fillSignal(&signal, type->dt, nfft);
+  size_t elementSize = dataItems[0]->getEcmcDataElementSize();
+  size_t cycleBytes  = elements * elementSize;
+
+  int     errorCode = 0;
+  int64_t rtNs      = 0;
+  size_t  rtSamples = 0;
+  double  times[ECMC_PLUGIN_WORKER_STAGE_COUNT];
+  // First window is warm up (plan, cached data, page faults)
+  for(size_t s = 0; s <= spectra && errorCode == 0; ++s) {
+    size_t  counter = getResultCounter();
+    int64_t feedNs  = 0;
+    size_t  fed     = 0;
+    int     found   = 0;
+    // Zoom windows need NFFT decimated samples (the signal is fed until done)
+    for(int waitMs = 0; !found && waitMs < BENCH_WAIT_TIMEOUT_S * 1000;
+        waitMs += BENCH_ROUND_WAIT_MS) {
+      int64_t startNs = getNs();
+      for(size_t offset = 0; offset < signal.size(); offset += cycleBytes) {
+        size_t bytes = signal.size() - offset;
+        if(bytes > cycleBytes) {
+          bytes = cycleBytes;
+        }
+        for(size_t c = 0; c < channels; ++c) {
+          dataItems[c]->executeCallback(&signal[offset], bytes);
+        }
+      }
+      feedNs += getNs() - startNs;
+      fed    += nfft * channels;
+      found = waitForSpectrum(counter, times, zoom ? BENCH_ROUND_WAIT_MS :
+                              BENCH_WAIT_TIMEOUT_S * 1000) == 0;
+      if(!zoom) {
+        break;
+      }
+    }
+
+    if(!found) {
+      printf("Error: Timeout waiting for spectrum (%s).\n", config);
+      errorCode = -1;
+      break;
+    }
+    if(s == 0) {
+      continue;
+    }
+    rtNs      += feedNs;
+    rtSamples += fed;
+    for(int i = 0; i < ECMC_PLUGIN_WORKER_STAGE_COUNT; ++i) {
+      result->stageUs[i] += times[i];
+    }
+    result->spectra++;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(resultLock);
+    resultDriver = NULL;
+    resultId     = -1;
+  }
+  delete fft;
+  for(size_t c = 0; c < channels; ++c) {
+    delete dataItems[c];
+  }
+  clearEcmcShimDataItems();
+
+  if(result->spectra > 0) {
+    result->rtNsPerSample = (double)rtNs / (double)rtSamples;
+    for(int i = 0; i < ECMC_PLUGIN_WORKER_STAGE_COUNT; ++i) {
+      result->stageUs[i] /= (double)result->spectra;
+    }
+  }
+  return errorCode;
+}
+
+/** Run one case on the engine only (no asyn, shims or threads). Realtime
+ *  and worker stages are called from the benchmark thread, same method as
+ *  runCase(). Returns 0 if success, 1 if option not available.
+*/
+static int runEngineCase(size_t             nfft,
+                         const benchType*   type,
+                         const benchOption* option,
+                         FFT_PRECISION      precision,
+                         size_t             spectra,
+                         size_t             elements,
+                         benchResult*       result) {
+  memset(result, 0, sizeof(*result));
+
+  // Breaktables are looked up by the plugin (not part of the engine)
+  if(!strcmp(option->name, "BREAKTABLE")) {
+    return 1;
+  }
+
+  ecmcFFTEngine* engine = NULL;
+  try {
+    if(precision == PRECISION_FIXED) {
+      engine = new ecmcFFTEngineT<float, int32_t>(nfft, 0);
+    } else if(precision == PRECISION_FLOAT) {
+      engine = new ecmcFFTEngineT<float>(nfft, 0);
+    } else {
+      engine = new ecmcFFTEngineT<double>(nfft, 0);
+    }
+    engine->setMode(CONT);
+    engine->setEnable(1);
+    engine->setSampleRate(1000.0);
+    engine->setSampleType(type->sampleType);
+    engine->setDcRemove(!strcmp(option->name, "RM_DC"));
+    engine->setLinRemove(!strcmp(option->name, "RM_LIN"));
+    engine->setScale(!strcmp(option->name, "SCALE") ? 0.001 : 1.0);
+  }
+  catch(std::exception& e) {
+    printf("Error: %s (NFFT=%zu).\n", e.what(), nfft);
+    return -1;
+  }
+
+  std::vector<uint8_t> signal;
+  fillSignal(&signal, type->dt, nfft);
+  size_t elementSize = ecmcFFTEngine::getSampleTypeByteSize(type->sampleType);
+  size_t cycleBytes  = elements * elementSize;
+
+  int     errorCode = 0;
+  int64_t rtNs      = 0;
+  // First window is warm up (cached data, page faults)
+  for(size_t s = 0; s <= spectra; ++s) {
+    int64_t startNs = getNs();
+    for(size_t offset = 0; offset < signal.size(); offset += cycleBytes) {
+      size_t bytes = signal.size() - offset;
+      if(bytes > cycleBytes) {
+        bytes = cycleBytes;
+      }
+      engine->acquire(&signal[offset], bytes / elementSize, type->sampleType, startNs);
+    }
+    int64_t feedNs = getNs() - startNs;
+
+    int64_t stageNs[ECMC_PLUGIN_WORKER_STAGE_COUNT];
+    stageNs[STAGE_PREPROCESS] = getNs();
+    if(!engine->readAcqBuffers()) {
+      printf("Error: No complete window (NFFT=%zu).\n", nfft);
+      errorCode = -1;
+      break;
+    }
+    engine->updateCachedData();
+    engine->preProcess();
+    stageNs[STAGE_TRANSFORM] = getNs();
+    engine->calcFFT();
+    stageNs[STAGE_POSTPROCESS] = getNs();
+    int flags = engine->postProcess();
+    stageNs[STAGE_PUBLISH] = getNs();
+    engine->calcDone(flags);
+    stageNs[STAGE_TOTAL] = getNs();
+    if(s == 0) {
+      continue;
+    }
+    rtNs += feedNs;
+    for(int i = 0; i < STAGE_TOTAL; ++i) {
+      result->stageUs[i] += (double)(stageNs[i + 1] - stageNs[i]) / 1000.0;
+    }
+    result->stageUs[STAGE_TOTAL] += (double)(stageNs[STAGE_TOTAL] - stageNs[STAGE_PREPROCESS]) / 1000.0;
+    result->spectra++;
+  }
+  delete engine;
+
+  if(result->spectra > 0) {
+    result->rtNsPerSample = (double)rtNs / (double)(result->spectra * nfft);
+    for(int i = 0; i < ECMC_PLUGIN_WORKER_STAGE_COUNT; ++i) {
+      result->stageUs[i] /= (double)result->spectra;
+    }
+  }
+  return errorCode;
+}
+
+// PRECISION=FIXED: integer types that fit in int32, no breaktable
+static int fixedSupported(const benchType* type, const benchOption* option) {
+  if(!strcmp(option->name, "BREAKTABLE")) {
+    return 0;
+  }
+  switch(type->sampleType) {
+    case SAMPLE_U8:
+    case SAMPLE_S8:
+    case SAMPLE_U16:
+    case SAMPLE_S16:
+    case SAMPLE_S32:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+/** Transforms (complex and real) with all SIMD kernels supported here compared
+ *  with kissfft<T>. Error is relative to the largest bin. Returns 1 if any
+ *  error is above tol.
+*/
+template<typename T>
+static int verifySimd(const std::vector<std::string>& nfftList, const char* name, double tol) {
+  typedef std::complex<T> cpx_t;
+  const FFT_SIMD kernels[] = {SIMD_NONE, SIMD_SSE2, SIMD_AVX2, SIMD_NEON};
+  int errorCode = 0;
+
+  for(size_t n = 0; n < nfftList.size(); ++n) {
+    size_t nfft = (size_t)atol(nfftList[n].c_str());
+    if(nfft < 2 || nfft % 2) {
+      printf("Error: NFFT must be even (%zu).\n", nfft);
+      return 1;
+    }
+    size_t             half = nfft / 2;
+    std::vector<T>     in(nfft);
+    std::vector<cpx_t> ref(nfft);
+    std::vector<cpx_t> res(nfft);
+    srand(1);
+    for(size_t i = 0; i < nfft; ++i) {
+      in[i] = (T)(rand() / (double)RAND_MAX - 0.5);
+    }
+    for(int real = 0; real <= 1; ++real) {
+      kissfft<T> kiss(half, false);
+      if(real) {
+        kiss.transform_real(&in[0], &ref[0]);
+      } else {
+        kiss.transform((const cpx_t*)&in[0], &ref[0]);  // nfft/2 complex
+      }
+      double peak = 0;
+      for(size_t i = 0; i < half; ++i) {
+        peak = std::max(peak, (double)std::abs(ref[i]));
+      }
+      for(size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        ecmcFFTSimd<T>* fft = NULL;
+        try {
+          fft = new ecmcFFTSimd<T>(half, false, kernels[k]);
+        }
+        catch(std::invalid_argument& e) {
+          continue;  // Not supported here
+        }
+        const int loops = 2000;
+        auto start = std::chrono::steady_clock::now();
+        for(int l = 0; l < loops; ++l) {
+          if(real) {
+            fft->transform_real(&in[0], &res[0]);
+          } else {
+            fft->transform((const cpx_t*)&in[0], &res[0]);
+          }
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - start).count() / loops;
+        double maxError = 0;
+        for(size_t i = 0; i < half; ++i) {
+          maxError = std::max(maxError, (double)std::abs(res[i] - ref[i]));
+        }
+        maxError /= peak > 0 ? peak : 1;
+        int fail = maxError > tol;
+        printf("%-7zu %-6s %-7s %-6s %12.3e %9.2f %s\n", nfft, name, real ? "REAL" : "COMPLEX",
+               ecmcFFTSimd<T>::getSimdName(fft->getSimd()), maxError, us, fail ? "FAIL" : "OK");
+        errorCode |= fail;
+        delete fft;
+      }
+    }
+  }
+  return errorCode;
+}
+
+static void printUsage(const char* name) {
+  printf("Usage: %s [-n nffts] [-t types] [-o options] [-c spectra] [-e elements] [-m channels] [-x config] [-s params] [-E] [-F] [-I] [-V]\n", name);
+  printf("  -n  NFFT list (default " BENCH_DEFAULT_NFFTS ")\n");
+  printf("  -t  Data types, U8,S8,U16,S16,U32,S32,U64,S64,F32,F64 (default " BENCH_DEFAULT_TYPES ")\n");
+  printf("  -o  Options, NONE,RM_DC,RM_LIN,BREAKTABLE,SCALE (default " BENCH_DEFAULT_OPTIONS ")\n");
+  printf("  -c  Spectra per case (default %d)\n", BENCH_DEFAULT_SPECTRA);
+  printf("  -e  Samples per ecmc cycle (default %d)\n", BENCH_DEFAULT_ELEMENTS);
+  printf("  -m  Sources per FFT object, batched with SOURCES (default %d, max %d, not with -E)\n",
+         BENCH_DEFAULT_CHANNELS, ECMC_PLUGIN_MAX_CHANNELS);
+  printf("  -x  Extra plugin config added to all cases (example: \"WINDOW=HANN;\")\n");
+  printf("  -s  Optional outputs to subscribe on all channels (fftphase,fftreal,fftimag, not with -E)\n");
+  printf("  -E  Engine only, without plugin, asyn and threads (-x and BREAKTABLE not used)\n");
+  printf("  -F  Float precision (PRECISION=FLOAT)\n");
+  printf("  -I  Fixed point (PRECISION=FIXED, only U8,S8,U16,S16,S32 without BREAKTABLE)\n");
+  printf("  -V  Verify SIMD kernels against kissfft for the -n NFFTs (no benchmark)\n");
+}
+
+int main(int argc, char** argv) {
+  const char* nffts    = BENCH_DEFAULT_NFFTS;
+  const char* types    = BENCH_DEFAULT_TYPES;
+  const char* options  = BENCH_DEFAULT_OPTIONS;
+  const char* extra    = "";
+  const char* subscribe = "";
+  size_t      spectra  = BENCH_DEFAULT_SPECTRA;
+  size_t      elements = BENCH_DEFAULT_ELEMENTS;
+  size_t      channels = BENCH_DEFAULT_CHANNELS;
+  int         engineOnly = 0;
+  int         verify     = 0;
+  FFT_PRECISION precision = PRECISION_DOUBLE;
+
+  for(int i = 1; i < argc; ++i) {
+    if(!strcmp(argv[i], "-E")) {
+      engineOnly = 1;
+      continue;
+    }
+    if(!strcmp(argv[i], "-F")) {
+      precision = PRECISION_FLOAT;
+      continue;
+    }
+    if(!strcmp(argv[i], "-I")) {
+      precision = PRECISION_FIXED;
+      continue;
+    }
+    if(!strcmp(argv[i], "-V")) {
+      verify = 1;
+      continue;
+    }
+    if(i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+      printUsage(argv[0]);
+      return 1;
+    }
+    const char* value = argv[++i];
+    switch(argv[i - 1][1]) {
+      case 'n':
+        nffts = value;
+        break;
+      case 't':
+        types = value;
+        break;
+      case 'o':
+        options = value;
+        break;
+      case 'c':
+        spectra = (size_t)atol(value);
+        break;
+      case 'e':
+        elements = (size_t)atol(value);
+        break;
+      case 'm':
+        channels = (size_t)atol(value);
+        break;
+      case 'x':
+        extra = value;
+        break;
+      case 's':
+        subscribe = value;
+        break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if(spectra == 0 || elements == 0 || channels == 0 || channels > ECMC_PLUGIN_MAX_CHANNELS) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::string extraConfig = extra;
+  if(precision == PRECISION_FLOAT) {
+    extraConfig = ECMC_PLUGIN_PRECISION_OPTION_CMD ECMC_PLUGIN_PRECISION_FLOAT_OPTION ";" + extraConfig;
+  } else if(precision == PRECISION_FIXED) {
+    extraConfig = ECMC_PLUGIN_PRECISION_OPTION_CMD ECMC_PLUGIN_PRECISION_FIXED_OPTION ";" + extraConfig;
+  }
+
+  asynShimArrayCallbackFunc = arrayCallback;
+  setEcmcShimSampleRate(1000.0);
+
+  std::vector<std::string> nfftList   = splitList(nffts);
+  std::vector<std::string> typeList   = splitList(types);
+  std::vector<std::string> optionList = splitList(options);
+  std::vector<std::string> subscribeList = splitList(subscribe);
+
+  if(verify) {
+    printf("SIMD detected: %s (double), %s (float)\n",
+           ecmcFFTSimd<double>::getSimdName(ecmcFFTSimd<double>::detectSimd()),
+           ecmcFFTSimd<float>::getSimdName(ecmcFFTSimd<float>::detectSimd()));
+    printf("%-7s %-6s %-7s %-6s %12s %9s\n", "NFFT", "PREC", "INPUT", "SIMD", "MAX ERROR", "us");
+    int errorCode = verifySimd<double>(nfftList, "DOUBLE", 1e-12);
+    errorCode |= verifySimd<float>(nfftList, "FLOAT", 1e-5);
+    return errorCode;
+  }
+
+  if(channels > 1 && !engineOnly) {
+    printf("Channels: %zu (times per batch, ns/smpl and spectra/s of all channels)\n", channels);
+  }
+  printf("%-7s %-4s %-10s %9s %9s %9s %9s %9s %9s %9s %10s\n",
+         "NFFT", "TYPE", "OPTION", "RT",  "PRE", "FFT", "POST", "PUB", "TOTAL",
+         "TOTAL", "SPECTRA/s");
+  printf("%-7s %-4s %-10s %9s %9s %9s %9s %9s %9s %9s %10s\n",
+         "", "", "", "ns/smpl", "us", "us", "us", "us", "us", "ns/smpl", "(worker)");
+
+  int errorCode = 0;
+  int index     = 0;
+  for(size_t n = 0; n < nfftList.size(); ++n) {
+    size_t nfft = (size_t)atol(nfftList[n].c_str());
+    for(size_t t = 0; t < typeList.size(); ++t) {
+      const benchType* type = NULL;
+      for(size_t i = 0; i < sizeof(benchTypes) / sizeof(benchTypes[0]); ++i) {
+        if(typeList[t] == benchTypes[i].name) {
+          type = &benchTypes[i];
+        }
+      }
+      for(size_t o = 0; o < optionList.size(); ++o) {
+        const benchOption* option = NULL;
+        for(size_t i = 0; i < sizeof(benchOptions) / sizeof(benchOptions[0]); ++i) {
+          if(optionList[o] == benchOptions[i].name) {
+            option = &benchOptions[i];
+          }
+        }
+        if(!type || !option) {
+          printf("Error: Invalid type or option (%s, %s).\n",
+                 typeList[t].c_str(), optionList[o].c_str());
+          return 1;
+        }
+
+        benchResult result;
+        int         caseError;
+        if(precision == PRECISION_FIXED && !fixedSupported(type, option)) {
+          caseError = 1;
+        } else if(engineOnly) {
+          caseError = runEngineCase(nfft, type, option, precision, spectra, elements, &result);
+        } else {
+          caseError = runCase(index++, nfft, type, option, extraConfig.c_str(), subscribeList, spectra, elements, channels, &result);
+        }
+        if(caseError > 0) {
+          printf("%-7zu %-4s %-10s %9s\n", nfft, type->name, option->name, "-");
+          continue;
+        }
+        if(caseError) {
+          errorCode = 1;
+          continue;
+        }
+        double totalUs = result.stageUs[STAGE_TOTAL];
+        double batch   = engineOnly ? 1.0 : (double)channels;
+        printf("%-7zu %-4s %-10s %9.2f %9.1f %9.1f %9.1f %9.1f %9.1f %9.2f %10.1f\n",
+               nfft, type->name, option->name,
+               result.rtNsPerSample,
+               result.stageUs[STAGE_PREPROCESS],
+               result.stageUs[STAGE_TRANSFORM],
+               result.stageUs[STAGE_POSTPROCESS],
+               result.stageUs[STAGE_PUBLISH],
+               totalUs,
+               result.rtNsPerSample + totalUs * 1000.0 / ((double)nfft * batch),
+               totalUs > 0 ? batch * 1e6 / totalUs : 0.0);
+        fflush(stdout);
+      }
+    }
+  }
+
+  return errorCode;
+}
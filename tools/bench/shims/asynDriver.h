@@ -0,0 +1,56 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  asynDriver.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  asyn (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ASYN_DRIVER_H_
+#define SHIM_ASYN_DRIVER_H_
+
+#include <stddef.h>
+#include "epicsTypes.h"
+
+typedef enum {
+  asynSuccess,
+  asynTimeout,
+  asynOverflow,
+  asynError,
+  asynDisconnected,
+  asynDisabled
+} asynStatus;
+
+typedef struct asynUser {
+  char *errorMessage;
+  int   errorMessageSize;
+  double timeout;
+  void *userPvt;
+  void *userData;
+  void *drvUser;
+  int   reason;
+  int   addr;        // Benchmark only (pasynManager->getAddr() in asyn)
+} asynUser;
+
+#define asynCommonMask        0x00000001
+#define asynDrvUserMask       0x00000002
+#define asynOptionMask        0x00000004
+#define asynInt32Mask         0x00000008
+#define asynUInt32DigitalMask 0x00000010
+#define asynFloat64Mask       0x00000020
+#define asynOctetMask         0x00000040
+#define asynInt8ArrayMask     0x00000080
+#define asynInt16ArrayMask    0x00000100
+#define asynInt32ArrayMask    0x00000200
+#define asynFloat32ArrayMask  0x00000400
+#define asynFloat64ArrayMask  0x00000800
+#define asynGenericPointerMask 0x00001000
+#define asynEnumMask          0x00002000
+
+#define ASYN_MULTIDEVICE      0x0001
+#define ASYN_CANBLOCK         0x0002
+
+#endif  /* SHIM_ASYN_DRIVER_H_ */
@@ -0,0 +1,110 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  asynPortDriver.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  asyn (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ASYN_PORT_DRIVER_H_
+#define SHIM_ASYN_PORT_DRIVER_H_
+
+#include <string>
+#include <vector>
+#include "asynDriver.h"
+
+typedef enum {
+  asynParamNotDefined,
+  asynParamInt32,
+  asynParamUInt32Digital,
+  asynParamFloat64,
+  asynParamOctet,
+  asynParamInt8Array,
+  asynParamInt16Array,
+  asynParamInt32Array,
+  asynParamFloat32Array,
+  asynParamFloat64Array,
+  asynParamGenericPointer
+} asynParamType;
+
+class asynPortDriver;
+
+// Hook for array callbacks (the benchmark uses it to detect published spectra)
+typedef void (*asynShimArrayCallback)(asynPortDriver *driver,
+                                      int             reason,
+                                      const void     *value,
+                                      size_t          nElements);
+extern asynShimArrayCallback asynShimArrayCallbackFunc;
+
+/** Parameter library only (no records, no interrupts). Not thread safe,
+ *  same as asynPortDriver without the port lock. One parameter list for all
+ *  addresses (list and addr are ignored).
+*/
+class asynPortDriver {
+ public:
+  asynPortDriver(const char *portName, int maxAddr, int interfaceMask,
+                 int interruptMask, int asynFlags, int autoConnect,
+                 int priority, int stackSize);
+  virtual ~asynPortDriver();
+
+  virtual asynStatus lock();
+  virtual asynStatus unlock();
+  virtual asynStatus writeInt32(asynUser *pasynUser, epicsInt32 value);
+  virtual asynStatus readInt32(asynUser *pasynUser, epicsInt32 *value);
+  virtual asynStatus writeFloat64(asynUser *pasynUser, epicsFloat64 value);
+  virtual asynStatus readFloat64(asynUser *pasynUser, epicsFloat64 *value);
+  virtual asynStatus readInt8Array(asynUser *pasynUser, epicsInt8 *value,
+                                   size_t nElements, size_t *nIn);
+  virtual asynStatus readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                    size_t nElements, size_t *nIn);
+  virtual asynStatus readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                      size_t nElements, size_t *nIn);
+  virtual asynStatus readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
+                                      size_t nElements, size_t *nIn);
+  virtual asynStatus readEnum(asynUser *pasynUser, char *strings[], int values[],
+                              int severities[], size_t nElements, size_t *nIn);
+  virtual asynStatus drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                   const char **pptypeName, size_t *psize);
+  virtual asynStatus drvUserDestroy(asynUser *pasynUser);
+
+  asynStatus createParam(const char *name, asynParamType type, int *index);
+  asynStatus createParam(int list, const char *name, asynParamType type, int *index);
+  asynStatus findParam(const char *name, int *index);
+  asynStatus setIntegerParam(int index, int value);
+  asynStatus setIntegerParam(int list, int index, int value);
+  asynStatus setDoubleParam(int index, double value);
+  asynStatus setDoubleParam(int list, int index, double value);
+  asynStatus getIntegerParam(int index, int *value);
+  asynStatus getIntegerParam(int list, int index, int *value);
+  asynStatus getDoubleParam(int index, double *value);
+  asynStatus getDoubleParam(int list, int index, double *value);
+  asynStatus callParamCallbacks();
+  asynStatus callParamCallbacks(int addr);
+  asynStatus callParamCallbacks(int list, int addr);
+  asynStatus getAddress(asynUser *pasynUser, int *address);
+  asynStatus doCallbacksInt8Array(epicsInt8 *value, size_t nElements,
+                                  int reason, int addr);
+  asynStatus doCallbacksInt32Array(epicsInt32 *value, size_t nElements,
+                                   int reason, int addr);
+  asynStatus doCallbacksFloat32Array(epicsFloat32 *value, size_t nElements,
+                                     int reason, int addr);
+  asynStatus doCallbacksFloat64Array(epicsFloat64 *value, size_t nElements,
+                                     int reason, int addr);
+
+  char *portName;
+  int   maxAddr;
+
+ private:
+  typedef struct {
+    std::string   name;
+    asynParamType type;
+    int           intValue;
+    double        doubleValue;
+  } param;
+  std::vector<param> params_;
+};
+
+#endif  /* SHIM_ASYN_PORT_DRIVER_H_ */
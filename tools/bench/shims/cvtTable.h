@@ -0,0 +1,20 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  cvtTable.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_CVT_TABLE_H_
+#define SHIM_CVT_TABLE_H_
+
+#include "dbBase.h"
+
+long cvtRawToEngBpt(double *pval, short linr, short init,
+                    void **ppbrk, short *plbrk);
+
+#endif  /* SHIM_CVT_TABLE_H_ */
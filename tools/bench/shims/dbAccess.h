@@ -0,0 +1,17 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  dbAccess.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_DB_ACCESS_H_
+#define SHIM_DB_ACCESS_H_
+
+extern int interruptAccept;
+
+#endif  /* SHIM_DB_ACCESS_H_ */
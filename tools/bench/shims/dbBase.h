@@ -0,0 +1,36 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  dbBase.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_DB_BASE_H_
+#define SHIM_DB_BASE_H_
+
+#include "ellLib.h"
+
+typedef struct brkInt {
+  double raw;
+  double slope;
+  double eng;
+} brkInt;
+
+typedef struct brkTable {
+  ELLNODE node;
+  char   *name;
+  long    number;        // Number of brkInt
+  brkInt *paBrkInt;
+} brkTable;
+
+typedef struct dbBase {
+  ELLLIST bptList;
+} dbBase;
+
+typedef dbBase DBBASE;
+
+#endif  /* SHIM_DB_BASE_H_ */
@@ -0,0 +1,22 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcAsynPortDriver.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  ecmc (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ECMC_ASYN_PORT_DRIVER_H_
+#define SHIM_ECMC_ASYN_PORT_DRIVER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "asynPortDriver.h"
+
+class ecmcAsynPortDriver;
+
+#endif  /* SHIM_ECMC_ASYN_PORT_DRIVER_H_ */
@@ -0,0 +1,17 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcAsynPortDriverUtils.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  ecmc (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ECMC_ASYN_PORT_DRIVER_UTILS_H_
+#define SHIM_ECMC_ASYN_PORT_DRIVER_UTILS_H_
+
+#include "ecmcAsynPortDriver.h"
+
+#endif  /* SHIM_ECMC_ASYN_PORT_DRIVER_UTILS_H_ */
@@ -0,0 +1,69 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcDataItem.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  ecmc (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ECMC_DATA_ITEM_H_
+#define SHIM_ECMC_DATA_ITEM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+enum ecmcEcDataType {
+  ECMC_EC_NONE = 0,
+  ECMC_EC_B1,
+  ECMC_EC_B2,
+  ECMC_EC_B3,
+  ECMC_EC_B4,
+  ECMC_EC_U8,
+  ECMC_EC_S8,
+  ECMC_EC_U16,
+  ECMC_EC_S16,
+  ECMC_EC_U32,
+  ECMC_EC_S32,
+  ECMC_EC_U64,
+  ECMC_EC_S64,
+  ECMC_EC_F32,
+  ECMC_EC_F64,
+};
+
+typedef struct ecmcDataItemInfo {
+  char  *name;
+  size_t dataSize;
+  size_t dataElementSize;
+  ecmcEcDataType dataType;
+} ecmcDataItemInfo;
+
+typedef void(*ecmcDataUpdatedCallback)(uint8_t*       data,
+                                       size_t         size,
+                                       ecmcEcDataType dt,
+                                       void*          obj);
+
+/** One data item with one callback. The benchmark sets type and size and
+ *  calls executeCallback() instead of the ecmc realtime loop.
+*/
+class ecmcDataItem {
+ public:
+  ecmcDataItem(const char *name, ecmcEcDataType dt, size_t elementsPerCycle);
+  ~ecmcDataItem();
+  ecmcDataItemInfo *getDataItemInfo();
+  int               regDataUpdatedCallback(ecmcDataUpdatedCallback func, void* obj);
+  void              deregDataUpdatedCallback(int handle);
+  ecmcEcDataType    getEcmcDataType();
+  size_t            getEcmcDataSize();
+  size_t            getEcmcDataElementSize();
+  void              executeCallback(uint8_t *data, size_t size);
+
+ private:
+  ecmcDataItemInfo        info_;
+  ecmcDataUpdatedCallback callback_;
+  void                   *callbackObj_;
+};
+
+#endif  /* SHIM_ECMC_DATA_ITEM_H_ */
@@ -0,0 +1,469 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcFFTBenchShims.cpp
+*
+*  Implementation of the ecmc, asyn and EPICS base shims used by the
+*  host benchmark (no IOC, no EtherCAT hardware).
+*
+\*************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include "asynPortDriver.h"
+#include "ecmcDataItem.h"
+#include "ecmcPluginClient.h"
+#include "epicsThread.h"
+#include "epicsString.h"
+#include "cvtTable.h"
+#include "dbAccess.h"
+
+/* ecmc */
+
+static std::vector<ecmcDataItem*> shimDataItems;
+static double                     shimSampleRate = 1000.0;
+
+void* getEcmcDataItem(char *idStringWP) {
+  for(size_t i = 0; i < shimDataItems.size(); ++i) {
+    if(!strcmp(shimDataItems[i]->getDataItemInfo()->name, idStringWP)) {
+      return shimDataItems[i];
+    }
+  }
+  return NULL;
+}
+
+double getEcmcSampleRate() {
+  return shimSampleRate;
+}
+
+void addEcmcShimDataItem(ecmcDataItem *dataItem) {
+  shimDataItems.push_back(dataItem);
+}
+
+void clearEcmcShimDataItems() {
+  shimDataItems.clear();
+}
+
+void setEcmcShimSampleRate(double rate) {
+  shimSampleRate = rate;
+}
+
+static size_t getElementSize(ecmcEcDataType dt) {
+  switch(dt) {
+    case ECMC_EC_U8:
+    case ECMC_EC_S8:
+      return 1;
+    case ECMC_EC_U16:
+    case ECMC_EC_S16:
+      return 2;
+    case ECMC_EC_U32:
+    case ECMC_EC_S32:
+    case ECMC_EC_F32:
+      return 4;
+    case ECMC_EC_U64:
+    case ECMC_EC_S64:
+    case ECMC_EC_F64:
+      return 8;
+    default:
+      return 0;
+  }
+}
+
+ecmcDataItem::ecmcDataItem(const char *name, ecmcEcDataType dt, size_t elementsPerCycle) {
+  memset(&info_, 0, sizeof(info_));
+  info_.name            = strdup(name);
+  info_.dataType        = dt;
+  info_.dataElementSize = getElementSize(dt);
+  info_.dataSize        = info_.dataElementSize * elementsPerCycle;
+  callback_             = NULL;
+  callbackObj_          = NULL;
+}
+
+ecmcDataItem::~ecmcDataItem() {
+  free(info_.name);
+}
+
+ecmcDataItemInfo *ecmcDataItem::getDataItemInfo() {
+  return &info_;
+}
+
+int ecmcDataItem::regDataUpdatedCallback(ecmcDataUpdatedCallback func, void* obj) {
+  if(callback_) {
+    return -1;  // One callback is enough for the benchmark
+  }
+  callback_    = func;
+  callbackObj_ = obj;
+  return 0;
+}
+
+void ecmcDataItem::deregDataUpdatedCallback(int handle) {
+  (void)handle;
+  callback_    = NULL;
+  callbackObj_ = NULL;
+}
+
+ecmcEcDataType ecmcDataItem::getEcmcDataType() {
+  return info_.dataType;
+}
+
+size_t ecmcDataItem::getEcmcDataSize() {
+  return info_.dataSize;
+}
+
+size_t ecmcDataItem::getEcmcDataElementSize() {
+  return info_.dataElementSize;
+}
+
+void ecmcDataItem::executeCallback(uint8_t *data, size_t size) {
+  if(callback_) {
+    callback_(data, size, info_.dataType, callbackObj_);
+  }
+}
+
+/* EPICS base */
+
+int interruptAccept = 1;
+
+// One breaktable "bench" (raw 0..65535 => eng, a few segments)
+static brkInt benchBrkInts[] = {
+  {    -1e9, 1.00,     -1e9},
+  {     0.0, 1.00,      0.0},
+  { 16384.0, 0.98,  16384.0},
+  { 32768.0, 1.02,  32440.3},
+  { 49152.0, 1.00,  49152.0},
+};
+
+static brkTable benchBrkTable = {
+  {NULL, NULL},
+  (char*)"bench",
+  sizeof(benchBrkInts) / sizeof(benchBrkInts[0]),
+  benchBrkInts
+};
+
+static dbBase benchDbBase = {
+  {{&benchBrkTable.node, &benchBrkTable.node}, 1}
+};
+
+DBBASE *pdbbase = &benchDbBase;
+
+// Same search as EPICS (start at last used interval)
+long cvtRawToEngBpt(double *pval, short linr, short init,
+                    void **ppbrk, short *plbrk) {
+  (void)linr;
+  (void)init;
+  brkTable *pbrkTable = (brkTable*)*ppbrk;
+  if(!pbrkTable || pbrkTable->number < 1) {
+    return -1;
+  }
+  double  val    = *pval;
+  long    number = pbrkTable->number;
+  short   lbrk   = *plbrk;
+  brkInt *pInt   = pbrkTable->paBrkInt;
+  if(lbrk < 0 || lbrk >= number) {
+    lbrk = 0;
+  }
+  while(lbrk > 0 && val < pInt[lbrk].raw) {
+    lbrk--;
+  }
+  while(lbrk < number - 1 && val >= pInt[lbrk + 1].raw) {
+    lbrk++;
+  }
+  *plbrk = lbrk;
+  *pval  = pInt[lbrk].eng + (val - pInt[lbrk].raw) * pInt[lbrk].slope;
+  return 0;
+}
+
+char* epicsStrDup(const char *s) {
+  return strdup(s);
+}
+
+typedef struct {
+  EPICSTHREADFUNC func;
+  void           *parm;
+} threadArgs;
+
+static void* threadMain(void *arg) {
+  threadArgs args = *(threadArgs*)arg;
+  delete (threadArgs*)arg;
+  args.func(args.parm);
+  return NULL;
+}
+
+// Priority and stack size ignored (threads are scheduled by the plugin itself)
+epicsThreadId epicsThreadCreate(const char     *name,
+                                unsigned int    priority,
+                                unsigned int    stackSize,
+                                EPICSTHREADFUNC funptr,
+                                void           *parm) {
+  (void)name;
+  (void)priority;
+  (void)stackSize;
+  pthread_t   thread;
+  threadArgs *args = new threadArgs;
+  args->func = funptr;
+  args->parm = parm;
+  if(pthread_create(&thread, NULL, threadMain, args) != 0) {
+    delete args;
+    return NULL;
+  }
+  pthread_detach(thread);
+  return (epicsThreadId)thread;
+}
+
+epicsThreadId epicsThreadGetIdSelf(void) {
+  return (epicsThreadId)pthread_self();
+}
+
+void epicsThreadSleep(double seconds) {
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+/* asyn */
+
+asynShimArrayCallback asynShimArrayCallbackFunc = NULL;
+
+asynPortDriver::asynPortDriver(const char *portName, int maxAddr, int interfaceMask,
+                               int interruptMask, int asynFlags, int autoConnect,
+                               int priority, int stackSize) {
+  (void)interfaceMask;
+  (void)interruptMask;
+  (void)asynFlags;
+  (void)autoConnect;
+  (void)priority;
+  (void)stackSize;
+  this->portName = strdup(portName);
+  this->maxAddr  = maxAddr;
+}
+
+asynPortDriver::~asynPortDriver() {
+  free(portName);
+}
+
+asynStatus asynPortDriver::lock() {
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::unlock() {
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::writeInt32(asynUser *pasynUser, epicsInt32 value) {
+  return setIntegerParam(pasynUser->reason, value);
+}
+
+asynStatus asynPortDriver::readInt32(asynUser *pasynUser, epicsInt32 *value) {
+  return getIntegerParam(pasynUser->reason, value);
+}
+
+asynStatus asynPortDriver::writeFloat64(asynUser *pasynUser, epicsFloat64 value) {
+  return setDoubleParam(pasynUser->reason, value);
+}
+
+asynStatus asynPortDriver::readFloat64(asynUser *pasynUser, epicsFloat64 *value) {
+  return getDoubleParam(pasynUser->reason, value);
+}
+
+asynStatus asynPortDriver::readInt8Array(asynUser *pasynUser, epicsInt8 *value,
+                                         size_t nElements, size_t *nIn) {
+  (void)pasynUser;
+  (void)value;
+  (void)nElements;
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus asynPortDriver::readInt32Array(asynUser *pasynUser, epicsInt32 *value,
+                                          size_t nElements, size_t *nIn) {
+  (void)pasynUser;
+  (void)value;
+  (void)nElements;
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus asynPortDriver::readFloat32Array(asynUser *pasynUser, epicsFloat32 *value,
+                                            size_t nElements, size_t *nIn) {
+  (void)pasynUser;
+  (void)value;
+  (void)nElements;
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus asynPortDriver::readFloat64Array(asynUser *pasynUser, epicsFloat64 *value,
+                                            size_t nElements, size_t *nIn) {
+  (void)pasynUser;
+  (void)value;
+  (void)nElements;
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus asynPortDriver::readEnum(asynUser *pasynUser, char *strings[], int values[],
+                                    int severities[], size_t nElements, size_t *nIn) {
+  (void)pasynUser;
+  (void)strings;
+  (void)values;
+  (void)severities;
+  (void)nElements;
+  *nIn = 0;
+  return asynError;
+}
+
+asynStatus asynPortDriver::createParam(const char *name, asynParamType type, int *index) {
+  param p;
+  p.name        = name;
+  p.type        = type;
+  p.intValue    = 0;
+  p.doubleValue = 0;
+  params_.push_back(p);
+  *index = (int)params_.size() - 1;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::createParam(int list, const char *name, asynParamType type, int *index) {
+  (void)list;
+  return createParam(name, type, index);
+}
+
+// Parameter of drvInfo (name) to reason
+asynStatus asynPortDriver::drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                         const char **pptypeName, size_t *psize) {
+  if(pptypeName) {
+    *pptypeName = NULL;
+  }
+  if(psize) {
+    *psize = 0;
+  }
+  return findParam(drvInfo, &pasynUser->reason);
+}
+
+asynStatus asynPortDriver::drvUserDestroy(asynUser *pasynUser) {
+  (void)pasynUser;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::findParam(const char *name, int *index) {
+  for(size_t i = 0; i < params_.size(); ++i) {
+    if(params_[i].name == name) {
+      *index = (int)i;
+      return asynSuccess;
+    }
+  }
+  return asynError;
+}
+
+asynStatus asynPortDriver::setIntegerParam(int index, int value) {
+  if(index < 0 || index >= (int)params_.size()) {
+    return asynError;
+  }
+  params_[index].intValue = value;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::setIntegerParam(int list, int index, int value) {
+  (void)list;
+  return setIntegerParam(index, value);
+}
+
+asynStatus asynPortDriver::setDoubleParam(int index, double value) {
+  if(index < 0 || index >= (int)params_.size()) {
+    return asynError;
+  }
+  params_[index].doubleValue = value;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::setDoubleParam(int list, int index, double value) {
+  (void)list;
+  return setDoubleParam(index, value);
+}
+
+asynStatus asynPortDriver::getIntegerParam(int index, int *value) {
+  if(index < 0 || index >= (int)params_.size()) {
+    return asynError;
+  }
+  *value = params_[index].intValue;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::getIntegerParam(int list, int index, int *value) {
+  (void)list;
+  return getIntegerParam(index, value);
+}
+
+asynStatus asynPortDriver::getDoubleParam(int index, double *value) {
+  if(index < 0 || index >= (int)params_.size()) {
+    return asynError;
+  }
+  *value = params_[index].doubleValue;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::getDoubleParam(int list, int index, double *value) {
+  (void)list;
+  return getDoubleParam(index, value);
+}
+
+asynStatus asynPortDriver::callParamCallbacks() {
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::callParamCallbacks(int addr) {
+  (void)addr;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::callParamCallbacks(int list, int addr) {
+  (void)list;
+  (void)addr;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::getAddress(asynUser *pasynUser, int *address) {
+  *address = pasynUser->addr;
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::doCallbacksInt8Array(epicsInt8 *value, size_t nElements,
+                                                int reason, int addr) {
+  (void)addr;
+  if(asynShimArrayCallbackFunc) {
+    asynShimArrayCallbackFunc(this, reason, value, nElements);
+  }
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::doCallbacksInt32Array(epicsInt32 *value, size_t nElements,
+                                                 int reason, int addr) {
+  (void)addr;
+  if(asynShimArrayCallbackFunc) {
+    asynShimArrayCallbackFunc(this, reason, value, nElements);
+  }
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::doCallbacksFloat32Array(epicsFloat32 *value, size_t nElements,
+                                                   int reason, int addr) {
+  (void)addr;
+  if(asynShimArrayCallbackFunc) {
+    asynShimArrayCallbackFunc(this, reason, value, nElements);
+  }
+  return asynSuccess;
+}
+
+asynStatus asynPortDriver::doCallbacksFloat64Array(epicsFloat64 *value, size_t nElements,
+                                                   int reason, int addr) {
+  (void)addr;
+  if(asynShimArrayCallbackFunc) {
+    asynShimArrayCallbackFunc(this, reason, value, nElements);
+  }
+  return asynSuccess;
+}
@@ -0,0 +1,25 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ecmcPluginClient.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  ecmc (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ECMC_PLUGIN_CLIENT_H_
+#define SHIM_ECMC_PLUGIN_CLIENT_H_
+
+#include "ecmcDataItem.h"
+
+void*  getEcmcDataItem(char *idStringWP);
+double getEcmcSampleRate();
+
+// Benchmark only: data items returned by getEcmcDataItem() (by name) and ecmc rate
+void   addEcmcShimDataItem(ecmcDataItem *dataItem);
+void   clearEcmcShimDataItems();
+void   setEcmcShimSampleRate(double rate);
+
+#endif  /* SHIM_ECMC_PLUGIN_CLIENT_H_ */
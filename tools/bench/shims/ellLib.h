@@ -0,0 +1,29 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  ellLib.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_ELL_LIB_H_
+#define SHIM_ELL_LIB_H_
+
+typedef struct ELLNODE {
+  struct ELLNODE *next;
+  struct ELLNODE *previous;
+} ELLNODE;
+
+typedef struct ELLLIST {
+  ELLNODE node;
+  int     count;
+} ELLLIST;
+
+#define ellFirst(PLIST) ((PLIST)->node.next)
+#define ellNext(PNODE)  ((PNODE)->next)
+#define ellCount(PLIST) ((PLIST)->count)
+
+#endif  /* SHIM_ELL_LIB_H_ */
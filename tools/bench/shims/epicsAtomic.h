@@ -0,0 +1,34 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsAtomic.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_ATOMIC_H_
+#define SHIM_EPICS_ATOMIC_H_
+
+// Same semantics as EPICS (full barriers)
+static inline int epicsAtomicGetIntT(const int *pTarget) {
+  return __atomic_load_n(pTarget, __ATOMIC_SEQ_CST);
+}
+static inline void epicsAtomicSetIntT(int *pTarget, int newValue) {
+  __atomic_store_n(pTarget, newValue, __ATOMIC_SEQ_CST);
+}
+static inline int epicsAtomicIncrIntT(int *pTarget) {
+  return __atomic_add_fetch(pTarget, 1, __ATOMIC_SEQ_CST);
+}
+static inline int epicsAtomicDecrIntT(int *pTarget) {
+  return __atomic_sub_fetch(pTarget, 1, __ATOMIC_SEQ_CST);
+}
+static inline int epicsAtomicCmpAndSwapIntT(int *pTarget, int oldVal, int newVal) {
+  __atomic_compare_exchange_n(pTarget, &oldVal, newVal, false,
+                              __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  return oldVal;
+}
+
+#endif  /* SHIM_EPICS_ATOMIC_H_ */
@@ -0,0 +1,46 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsEvent.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_EVENT_H_
+#define SHIM_EPICS_EVENT_H_
+
+#include <mutex>
+#include <condition_variable>
+
+typedef enum {
+  epicsEventEmpty,
+  epicsEventFull
+} epicsEventInitialState;
+
+// Binary event
+class epicsEvent {
+ public:
+  epicsEvent(epicsEventInitialState initial = epicsEventEmpty)
+    : full_(initial == epicsEventFull) {}
+  void signal() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    full_ = true;
+    cond_.notify_one();
+  }
+  void wait() {
+    std::unique_lock<std::mutex> guard(mutex_);
+    while(!full_) {
+      cond_.wait(guard);
+    }
+    full_ = false;
+  }
+ private:
+  std::mutex              mutex_;
+  std::condition_variable cond_;
+  bool                    full_;
+};
+
+#endif  /* SHIM_EPICS_EVENT_H_ */
@@ -0,0 +1,27 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsMutex.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_MUTEX_H_
+#define SHIM_EPICS_MUTEX_H_
+
+#include <mutex>
+
+// Recursive like epicsMutex
+class epicsMutex {
+ public:
+  void lock()    { mutex_.lock(); }
+  void unlock()  { mutex_.unlock(); }
+  bool tryLock() { return mutex_.try_lock(); }
+ private:
+  std::recursive_mutex mutex_;
+};
+
+#endif  /* SHIM_EPICS_MUTEX_H_ */
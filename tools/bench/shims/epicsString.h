@@ -0,0 +1,17 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsString.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_STRING_H_
+#define SHIM_EPICS_STRING_H_
+
+char* epicsStrDup(const char *s);
+
+#endif  /* SHIM_EPICS_STRING_H_ */
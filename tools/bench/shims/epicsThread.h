@@ -0,0 +1,26 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsThread.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_THREAD_H_
+#define SHIM_EPICS_THREAD_H_
+
+typedef struct epicsThreadOSD *epicsThreadId;
+typedef void (*EPICSTHREADFUNC)(void *parm);
+
+epicsThreadId epicsThreadCreate(const char     *name,
+                                unsigned int    priority,
+                                unsigned int    stackSize,
+                                EPICSTHREADFUNC funptr,
+                                void           *parm);
+epicsThreadId epicsThreadGetIdSelf(void);
+void          epicsThreadSleep(double seconds);
+
+#endif  /* SHIM_EPICS_THREAD_H_ */
@@ -0,0 +1,24 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsTypes.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_TYPES_H_
+#define SHIM_EPICS_TYPES_H_
+
+#include <stdint.h>
+
+typedef char     epicsInt8;   // As in EPICS base
+typedef int16_t  epicsInt16;
+typedef int32_t  epicsInt32;
+typedef uint32_t epicsUInt32;
+typedef float    epicsFloat32;
+typedef double   epicsFloat64;
+
+#endif  /* SHIM_EPICS_TYPES_H_ */
@@ -0,0 +1,17 @@
+/*************************************************************************\
+* Copyright (c) 2019 European Spallation Source ERIC
+* ecmc is distributed subject to a Software License Agreement found
+* in file LICENSE that is included with this distribution.
+*
+*  epicsVersion.h
+*
+*  Benchmark shim: minimal stand-in for the header with the same name in
+*  EPICS base (only what the FFT plugin uses).
+*
+\*************************************************************************/
+#ifndef SHIM_EPICS_VERSION_H_
+#define SHIM_EPICS_VERSION_H_
+
+#define BASE_VERSION 7
+
+#endif  /* SHIM_EPICS_VERSION_H_ */